@@ -0,0 +1,97 @@
+#ifndef ABQNN_BATCHER_H
+#define ABQNN_BATCHER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "abqnn_worker_pool.h"
+
+namespace abqnn::server {
+
+// Buckets of BatcherStats::size_histogram: sizes 1, 2, 3-4, 5-8, ..., 65-128, >128.
+static constexpr size_t kBatchSizeBuckets = 9;
+
+struct BatcherStats
+{
+    uint64_t batches = 0;
+    uint64_t items = 0;
+    uint64_t full_batches = 0;      // run because they reached the size limit
+    uint64_t timed_out_batches = 0; // run because their wait expired
+    std::array<uint64_t, kBatchSizeBuckets> size_histogram{};
+
+    double mean_batch_size() const
+    {
+        return batches == 0 ? 0.0 : static_cast<double>(items) / static_cast<double>(batches);
+    }
+};
+
+// Collects items per key until a batch holds `max_batch` items or its first
+// item has waited `max_wait`, then hands the whole batch to `run`. A full
+// batch runs on the thread that completed it; expired batches are submitted
+// to the worker pool by the batcher's timer thread. Items are opaque; `run`
+// owns finishing every item it is given.
+class Batcher
+{
+public:
+    using RunBatch = void (*)(std::vector<void *> &items);
+
+    Batcher(WorkerPool &pool, RunBatch run, size_t max_batch, std::chrono::microseconds max_wait);
+    ~Batcher();
+
+    Batcher(const Batcher &) = delete;
+    Batcher &operator=(const Batcher &) = delete;
+
+    void add(const std::string &key, void *item);
+
+    BatcherStats stats() const;
+
+private:
+    struct Batch
+    {
+        Batcher *owner = nullptr;
+        std::vector<void *> items;
+        std::chrono::steady_clock::time_point deadline;
+        bool full = false;
+    };
+
+    static void run_task(void *context);
+    void execute(Batch *batch);
+    void timer_main();
+
+    WorkerPool &pool_;
+    RunBatch run_;
+    size_t max_batch_;
+    std::chrono::microseconds max_wait_;
+
+    std::mutex mutex_;
+    std::condition_variable timer_cv_;
+    bool stopping_ = false;
+    // Open batch per key, null while the key has none. Keys stay in the map
+    // so that steady-state traffic does not allocate nodes.
+    std::unordered_map<std::string, Batch *> open_;
+    size_t open_count_ = 0;
+    // Batch objects are recycled so their item vectors keep their capacity.
+    std::vector<std::unique_ptr<Batch>> free_;
+
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> items_{0};
+    std::atomic<uint64_t> full_batches_{0};
+    std::atomic<uint64_t> timed_out_batches_{0};
+    std::array<std::atomic<uint64_t>, kBatchSizeBuckets> histogram_{};
+
+    std::thread timer_;
+};
+
+} // namespace abqnn::server
+
+#endif // ABQNN_BATCHER_H
@@ -0,0 +1,19 @@
+#ifndef ABQNN_DEFGRAD_PACK_H
+#define ABQNN_DEFGRAD_PACK_H
+
+#include <cstdint>
+
+namespace abqnn::server {
+
+// Packs a VUMAT defgradF(nblock, ndir + 2 * nshr), Fortran column-major with
+// components in Abaqus order [F11, F22, F33, F12, F23, F31, F21, F32, F13]
+// (3D) or [F11, F22, F33, F12, F21] (nshr = 1), into `out` as nblock
+// row-major 3x3 matrices. Absent components are written as zero, so `out`
+// needs no clearing. Only (ndir, nshr) = (3, 3) and (3, 1) are supported;
+// returns false for any other layout without touching `out`.
+bool pack_vumat_defgrad(const double *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, double *out);
+bool pack_vumat_defgrad(const float *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, float *out);
+
+} // namespace abqnn::server
+
+#endif // ABQNN_DEFGRAD_PACK_H
@@ -4,11 +4,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
 
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include "abqnn_ipc_transport.h"
 
 namespace abqnn::ipc {
 
@@ -16,29 +16,124 @@ static constexpr int ERR_IPC_CONNECT = 120;
 static constexpr int ERR_IPC_WRITE = 121;
 static constexpr int ERR_IPC_READ = 122;
 static constexpr int ERR_IPC_PROTOCOL = 123;
+// The server dropped a fresh connection on the request, in v1 as well: most
+// likely it predates the message type. transact_in_place only.
+static constexpr int ERR_IPC_UNSUPPORTED = 124;
 
-bool write_all(HANDLE h, const void* data, size_t n);
-bool read_all(HANDLE h, void* data, size_t n);
-
-int transact_blocking(const char* pipe_name,
+// Sends one request frame and waits for the matching response frame.
+// With ABQNN_IPC_PERSISTENT_CONNECTIONS the calling thread keeps its
+// connection open between calls and reconnects transparently when it is stale.
+int transact_blocking(const char* endpoint,
                      uint32_t request_type,
                      const std::vector<char>& request_payload,
                      uint32_t expected_response_type,
                      std::vector<char>& response_payload);
 
-template <typename T>
-inline void append_scalar(std::vector<char>& buf, const T& v)
+// Sends all requests over the stream connection without waiting for each
+// response, keeping a bounded window in flight, and stores response i for
+// request i. The server may answer in any order. Against a v1 server this
+// degrades to one transact_blocking per request.
+int transact_pipelined(const char* endpoint,
+                       uint32_t request_type,
+                       const std::vector<std::vector<char>>& request_payloads,
+                       uint32_t expected_response_type,
+                       std::vector<std::vector<char>>& response_payloads);
+
+// Non-owning view of a received payload.
+struct PayloadView
 {
-    size_t old_size = buf.size();
-    buf.resize(old_size + sizeof(T));
-    std::memcpy(buf.data() + old_size, &v, sizeof(T));
-}
+    const char* data = nullptr;
+    size_t size = 0;
+};
 
-inline void append_bytes(std::vector<char>& buf, const void* data, size_t n)
+// In-place variant of transact_blocking used on the hot path. The caller
+// serializes its request into the buffer returned by acquire_request_buffer
+// (the thread's shared-memory slot when one is attached and the payload fits,
+// a thread-local buffer otherwise), then calls transact_in_place with the same
+// size. `response` stays valid until the thread's next request.
+// `request_flags` are ABQNN_IPC_FLAG_* bits sent in the request header.
+char* acquire_request_buffer(const char* endpoint, size_t payload_size);
+int transact_in_place(const char* endpoint,
+                      uint32_t request_type,
+                      size_t payload_size,
+                      uint32_t expected_response_type,
+                      PayloadView& response,
+                      uint32_t request_flags = 0);
+
+// A request sent with transact_submit whose response has not been collected.
+// It owns a connection of its own, taken from a process-wide pool of idle ones,
+// so any number can be in flight and each can be completed from any thread.
+struct PendingTransaction
 {
-    size_t old_size = buf.size();
-    buf.resize(old_size + n);
-    std::memcpy(buf.data() + old_size, data, n);
+    std::vector<char> request; // payload, kept for a resend on a stale connection
+    std::vector<char> response;
+
+    std::unique_ptr<Connection> conn;
+    std::string endpoint;
+    uint32_t request_type = 0;
+    uint32_t request_flags = 0;
+    uint32_t expected_response_type = 0;
+    uint32_t version = 0;
+    uint32_t request_id = 0;
+    bool reused = false;
+};
+
+// Sends `pending.request` without waiting for the response. The caller then
+// polls with transact_ready and collects with transact_complete, which blocks
+// until the response is in; `response` stays valid while `pending` lives.
+int transact_submit(const char* endpoint,
+                    uint32_t request_type,
+                    uint32_t expected_response_type,
+                    PendingTransaction& pending);
+bool transact_ready(PendingTransaction& pending);
+int transact_complete(PendingTransaction& pending, PayloadView& response);
+
+// Closes the calling thread's persistent connection, if any.
+void close_thread_connection();
+
+// Sequential writer over a caller-provided buffer of known size.
+class PayloadWriter
+{
+public:
+    PayloadWriter(char* data, size_t capacity) : data_(data), capacity_(capacity) {}
+
+    template <typename T>
+    void put(const T& v)
+    {
+        put_bytes(&v, sizeof(T));
+    }
+
+    void put_bytes(const void* src, size_t n)
+    {
+        if (size_ + n > capacity_)
+        {
+            overflow_ = true;
+            return;
+        }
+        if (n > 0)
+        {
+            std::memcpy(data_ + size_, src, n);
+        }
+        size_ += n;
+    }
+
+    size_t size() const { return size_; }
+    bool ok() const { return !overflow_; }
+
+private:
+    char* data_;
+    size_t capacity_;
+    size_t size_ = 0;
+    bool overflow_ = false;
+};
+
+// Sizes `buf` to exactly `size` bytes and returns a writer over it. Reused
+// buffers keep their capacity, so encoding a payload of a size seen before
+// does not allocate.
+inline PayloadWriter begin_payload(std::vector<char>& buf, size_t size)
+{
+    buf.resize(size);
+    return PayloadWriter(buf.data(), size);
 }
 
 template <typename T>
@@ -53,6 +148,18 @@ inline bool read_scalar(const std::vector<char>& buf, size_t& offset, T& out)
     return true;
 }
 
+template <typename T>
+inline bool read_scalar(const PayloadView& buf, size_t& offset, T& out)
+{
+    if (offset + sizeof(T) > buf.size)
+    {
+        return false;
+    }
+    std::memcpy(&out, buf.data + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
 } // namespace abqnn::ipc
 
 #endif // ABQNN_IPC_COMMON_H
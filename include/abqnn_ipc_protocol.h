@@ -1,28 +1,103 @@
 #ifndef ABQNN_IPC_PROTOCOL_H
 #define ABQNN_IPC_PROTOCOL_H
 
+#include <cstddef>
 #include <cstdint>
 
 static constexpr uint32_t ABQNN_IPC_MAGIC = 0x4E4E5141; // 'AQNN'
-static constexpr uint32_t ABQNN_IPC_VERSION = 1;
+// Version spoken by this build, and the oldest version the server still
+// answers. Every frame is answered in the version it was sent with; a client
+// falls back to v1 when the server drops its first v2 frame.
+static constexpr uint32_t ABQNN_IPC_VERSION = 2;
+static constexpr uint32_t ABQNN_IPC_MIN_VERSION = 1;
 static constexpr uint32_t ABQNN_IPC_MAX_PAYLOAD = 256u * 1024u * 1024u; // 256 MB
 
-static constexpr const char* ABQNN_DEFAULT_PIPE_NAME = "\\\\.\\pipe\\abqnn_inference";
+#ifdef _WIN32
+static constexpr const char* ABQNN_DEFAULT_ENDPOINT = "\\\\.\\pipe\\abqnn_inference";
+#else
+static constexpr const char* ABQNN_DEFAULT_ENDPOINT = "/tmp/abqnn_inference.sock";
+#endif
 
 enum AbqnnIpcMessageType : uint32_t {
+    // Request: uint32 module length, module name, int32 n_mat_par, column-major
+    // 3x3 F, mat_par. Response: int32 status, then double psi, int32 cauchy_n,
+    // ddsdde_n, Cauchy[cauchy_n], DDSDDE. A negative ddsdde_n is a symmetric
+    // tangent sent as its -ddsdde_n upper-triangle entries, row by row; only
+    // requests flagged ABQNN_IPC_FLAG_PACKED_DDSDDE are answered that way.
     ABQNN_MSG_UMAT_REQ = 1,
     ABQNN_MSG_UMAT_RESP = 2,
     ABQNN_MSG_VUMAT_REQ = 3,
     ABQNN_MSG_VUMAT_RESP = 4,
+    // Assigns the connection a slot in the server's shared-memory region.
+    // Request: empty. Response: int32 status, uint64 server pid, uint32 slot index.
+    ABQNN_MSG_SHM_ATTACH_REQ = 5,
+    ABQNN_MSG_SHM_ATTACH_RESP = 6,
+    // Server statistics. Request: empty. Response: int32 status, uint32 length,
+    // then that many bytes of "key=value\n" text.
+    ABQNN_MSG_STATS_REQ = 7,
+    ABQNN_MSG_STATS_RESP = 8,
+    // Coalesced invoke_pt calls sharing one module and mat_par. Request: uint32
+    // module length, module name, int32 n_mat_par, int32 count, mat_par, then
+    // count column-major 3x3 F. Response: int32 status, then int32 count,
+    // cauchy_n, ddsdde_n, int32 point status[count], psi[count],
+    // Cauchy[count][cauchy_n], DDSDDE[count][|ddsdde_n|], packed as in
+    // ABQNN_MSG_UMAT_RESP when ddsdde_n is negative.
+    ABQNN_MSG_UMAT_BATCH_REQ = 9,
+    ABQNN_MSG_UMAT_BATCH_RESP = 10,
+    // Resolves a model and its mat_par once. Request: int32 kind (0 = UMAT,
+    // 1 = VUMAT), uint32 module length, module name, int32 n_mat_par, mat_par.
+    // Response: int32 status, then int32 handle, uint32 epoch. The epoch
+    // identifies the server process; handles die with it.
+    ABQNN_MSG_REGISTER_REQ = 11,
+    ABQNN_MSG_REGISTER_RESP = 12,
+    // UMAT by handle. Request: int32 handle, uint32 epoch, column-major 3x3 F.
+    // Response: as ABQNN_MSG_UMAT_RESP.
+    ABQNN_MSG_UMAT_HANDLE_REQ = 13,
+    ABQNN_MSG_UMAT_HANDLE_RESP = 14,
+    // VUMAT by handle. Request: int32 handle, uint32 epoch, int32 nblock, ndir,
+    // nshr, then defgradF. Response: as ABQNN_MSG_VUMAT_RESP.
+    ABQNN_MSG_VUMAT_HANDLE_REQ = 15,
+    ABQNN_MSG_VUMAT_HANDLE_RESP = 16,
+    // ABQNN_MSG_VUMAT_REQ/RESP with every real (defgradF, mat_par, energy,
+    // stress) as float32. The server runs a float32 copy of the model.
+    ABQNN_MSG_VUMAT_F32_REQ = 17,
+    ABQNN_MSG_VUMAT_F32_RESP = 18,
+    // Reloads a model file the server has cached, for every kind and dtype it
+    // is cached as. Request: uint32 module length, module name. Response:
+    // int32 status, sent once the new version serves requests.
+    ABQNN_MSG_RELOAD_REQ = 19,
+    ABQNN_MSG_RELOAD_RESP = 20,
 };
 
+// AbqnnIpcHeader::flags (protocol v2).
+// Response: the request was not understood; the payload is empty. A v1
+// connection is closed instead.
+static constexpr uint32_t ABQNN_IPC_FLAG_ERROR = 1u << 0;
+// Request: the client unpacks a symmetric DDSDDE sent as its upper triangle
+// (UMAT, UMAT_BATCH and UMAT_HANDLE responses). Shared-memory requests carry
+// it in SlotHeader::flags.
+static constexpr uint32_t ABQNN_IPC_FLAG_PACKED_DDSDDE = 1u << 1;
+
 #pragma pack(push, 1)
 struct AbqnnIpcHeader {
     uint32_t magic;
     uint32_t version;
     uint32_t message_type;
     uint32_t payload_size;
+    // Protocol v2 and later; a v1 header ends after payload_size. The server
+    // echoes request_id in the response, so one connection can carry many
+    // requests and have them answered out of order.
+    uint32_t request_id;
+    uint32_t flags;
 };
 #pragma pack(pop)
 
+static constexpr size_t ABQNN_IPC_V1_HEADER_SIZE = 16;
+
+// Bytes of AbqnnIpcHeader on the wire for a frame of the given version.
+inline size_t abqnn_ipc_header_size(uint32_t version)
+{
+    return version >= 2 ? sizeof(AbqnnIpcHeader) : ABQNN_IPC_V1_HEADER_SIZE;
+}
+
 #endif // ABQNN_IPC_PROTOCOL_H
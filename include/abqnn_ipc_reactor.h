@@ -0,0 +1,138 @@
+#ifndef ABQNN_IPC_REACTOR_H
+#define ABQNN_IPC_REACTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "abqnn_ipc_protocol.h"
+
+namespace abqnn::ipc {
+
+/*
+ * Event-driven server side of the stream transport. A small, fixed number of
+ * I/O threads (epoll on Linux, an I/O completion port on Windows) accept
+ * connections and assemble request frames from all of them, so an idle
+ * connection costs no thread. Complete requests go to a ReactorHandler, which
+ * queues them for the inference workers; the response is sent back from the
+ * worker through Reactor::reply.
+ */
+
+struct ReactorRequest;
+
+class ReactorConnection
+{
+public:
+    virtual ~ReactorConnection() = default;
+
+    // Sends one frame; the header occupies abqnn_ipc_header_size(version)
+    // bytes. Called by workers, serialized per connection. Blocks
+    // only while the peer's receive buffer is full. On failure the
+    // connection is shut down and the I/O thread reports it closed.
+    virtual bool write_frame(const AbqnnIpcHeader& header, const char* payload, size_t size) = 0;
+
+    // Makes the I/O thread see the connection as closed. Any thread.
+    virtual void shutdown() = 0;
+
+    // Free for the handler; only touched from the I/O thread serving this
+    // connection. The server keeps the attached shared-memory slot here.
+    int user_slot = -1;
+
+protected:
+    friend class Reactor;
+
+    // Frame assembly, driven by the I/O thread (see Reactor::receive_window).
+    // request_ is null while the header is being read.
+    AbqnnIpcHeader header_{};
+    size_t header_got_ = 0;
+    ReactorRequest* request_ = nullptr;
+    size_t payload_got_ = 0;
+};
+
+// One request frame. Owned by the handler from on_request until it is passed
+// to Reactor::reply or Reactor::reject; objects are recycled, so the vectors
+// keep their capacity across requests.
+struct ReactorRequest
+{
+    AbqnnIpcHeader header{};
+    std::vector<char> payload;
+
+    uint32_t response_type = 0;
+    std::vector<char> response;
+
+    std::shared_ptr<ReactorConnection> connection;
+};
+
+class ReactorHandler
+{
+public:
+    virtual ~ReactorHandler() = default;
+
+    // Called on an I/O thread for every complete, well-formed frame. Must not
+    // block: queue the request and return. v2 requests of one connection may
+    // be in flight together and answered in any order.
+    virtual void on_request(ReactorRequest* request) = 0;
+
+    // Called on an I/O thread once the peer has gone. Requests of this
+    // connection still held by the handler may be replied to; the responses
+    // are dropped.
+    virtual void on_close(ReactorConnection& connection) = 0;
+};
+
+class Reactor
+{
+public:
+    virtual ~Reactor() = default;
+
+    // Binds `endpoint`. Accepting pauses while `max_connections` connections
+    // are open (0 = unlimited). Returns nullptr if the endpoint is unusable,
+    // or on Unix if another server is listening on it.
+    static std::unique_ptr<Reactor> create(const char* endpoint, ReactorHandler& handler,
+                                           size_t io_threads, size_t max_connections);
+
+    // Runs the I/O threads. Returns only on an unrecoverable error.
+    virtual int run() = 0;
+
+    // Sends request->response framed as request->response_type, then
+    // recycles the request. Safe from any thread.
+    void reply(ReactorRequest* request);
+
+    // Recycles a request the handler could not serve (unknown message type).
+    // A v2 request is answered with ABQNN_IPC_FLAG_ERROR; a v1 connection is
+    // shut down.
+    void reject(ReactorRequest* request);
+
+    size_t connection_count() const { return connections_.load(std::memory_order_relaxed); }
+
+protected:
+    explicit Reactor(ReactorHandler& handler) : handler_(handler) {}
+
+    // Where the next bytes read from `conn` have to go; header and payload
+    // are read in place, without an intermediate buffer.
+    void receive_window(ReactorConnection& conn, char*& data, size_t& size);
+
+    // Commits `n` bytes read into the window and hands a completed frame to
+    // the handler. Returns false on a malformed header.
+    bool received(const std::shared_ptr<ReactorConnection>& conn, size_t n);
+
+    // Drops a partially assembled frame and notifies the handler.
+    void closed(ReactorConnection& conn);
+
+    ReactorHandler& handler_;
+    size_t max_connections_ = 0;
+    std::atomic<size_t> connections_{0};
+
+private:
+    ReactorRequest* acquire_request();
+    void recycle(ReactorRequest* request);
+
+    std::mutex free_mutex_;
+    std::vector<std::unique_ptr<ReactorRequest>> free_requests_;
+};
+
+} // namespace abqnn::ipc
+
+#endif // ABQNN_IPC_REACTOR_H
@@ -0,0 +1,141 @@
+#ifndef ABQNN_IPC_SHM_H
+#define ABQNN_IPC_SHM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace abqnn::ipc::shm {
+
+/*
+ * Shared-memory ring used as a zero-copy data path next to the stream
+ * transport. The server maps one region holding `slot_count` fixed-size
+ * slots. A client thread attaches to a slot over its stream connection
+ * (ABQNN_MSG_SHM_ATTACH_REQ), then serializes requests directly into the slot
+ * and waits for the server to write the response back into the same slot.
+ * The slot stays assigned until the stream connection closes.
+ *
+ * Posting a request also rings the region-wide doorbell, so a single server
+ * thread can watch every slot and hand claimed requests to the workers.
+ *
+ * Slot state machine (SlotHeader::state):
+ *   FREE -> IDLE              server assigns the slot on attach
+ *   IDLE -> REQUEST           client posted a request
+ *   REQUEST -> BUSY           server claimed the request for a worker
+ *   BUSY -> RESPONSE          server wrote the response frame
+ *   BUSY -> OVERFLOW          response larger than the slot; resend over the stream
+ *   BUSY -> ERROR             malformed request
+ *   RESPONSE/OVERFLOW/ERROR -> IDLE   client consumed the reply
+ */
+
+static constexpr uint32_t REGION_MAGIC = 0x4D485341; // 'ASHM'
+static constexpr uint32_t REGION_VERSION = 2;
+
+static constexpr uint32_t DEFAULT_SLOT_COUNT = 128;
+static constexpr uint64_t DEFAULT_SLOT_CAPACITY = 256u * 1024u; // fits a 512-point VUMAT block
+
+enum SlotState : uint32_t {
+    SLOT_FREE = 0,
+    SLOT_IDLE = 1,
+    SLOT_REQUEST = 2,
+    SLOT_BUSY = 3,
+    // Reply states; clients wait for any state >= SLOT_RESPONSE.
+    SLOT_RESPONSE = 4,
+    SLOT_OVERFLOW = 5,
+    SLOT_ERROR = 6,
+};
+
+struct RegionHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    std::atomic<uint32_t> doorbell;        // bumped by every posted request
+    uint64_t slot_capacity;
+    uint64_t slot_stride;
+    uint64_t server_pid;
+    std::atomic<uint32_t> server_waiting;  // non-zero while the server sleeps on the doorbell
+    uint32_t reserved;
+};
+
+struct alignas(64) SlotHeader {
+    std::atomic<uint32_t> state;
+    uint32_t message_type;
+    uint32_t payload_size;
+    uint32_t flags;                        // ABQNN_IPC_FLAG_* of the request
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "slot state must be address-free");
+
+// Slots start on the first cache line after the region header.
+static constexpr size_t SLOTS_OFFSET = 64;
+static_assert(sizeof(RegionHeader) <= SLOTS_OFFSET, "region header must fit in one cache line");
+
+inline uint64_t slot_stride_for(uint64_t slot_capacity)
+{
+    return (sizeof(SlotHeader) + slot_capacity + 63u) & ~uint64_t(63u);
+}
+
+inline size_t region_size_for(uint32_t slot_count, uint64_t slot_capacity)
+{
+    return SLOTS_OFFSET + static_cast<size_t>(slot_count) * static_cast<size_t>(slot_stride_for(slot_capacity));
+}
+
+// A mapped region plus the per-slot wake-up primitives (futexes on Linux,
+// named auto-reset events on Windows).
+class Region
+{
+public:
+    virtual ~Region() = default;
+
+    static std::unique_ptr<Region> create(const std::string& name, uint32_t slot_count, uint64_t slot_capacity);
+    static std::unique_ptr<Region> open(const std::string& name);
+
+    RegionHeader* header() const { return header_; }
+    SlotHeader* slot(uint32_t i) const
+    {
+        return reinterpret_cast<SlotHeader*>(base_ + slot_offset(i));
+    }
+    char* slot_data(uint32_t i) const
+    {
+        return base_ + slot_offset(i) + sizeof(SlotHeader);
+    }
+
+    // Client: publish the request in slot i and ring the doorbell.
+    virtual void post_request(uint32_t i) = 0;
+    // Server: publish `state` (RESPONSE, OVERFLOW or ERROR) in slot i and wake the client.
+    virtual void post_reply(uint32_t i, SlotState state) = 0;
+
+    // Server: block until the doorbell moves past `seen` or timeout_ms
+    // elapses. Updates `seen` and returns true if it moved; the caller then
+    // scans the slots for REQUEST states.
+    virtual bool wait_for_requests(uint32_t& seen, int timeout_ms) = 0;
+    // Client: block until slot i reaches a reply state or timeout_ms elapses.
+    virtual bool wait_for_reply(uint32_t i, int timeout_ms) = 0;
+
+protected:
+    Region() = default;
+
+    size_t slot_offset(uint32_t i) const
+    {
+        return SLOTS_OFFSET + static_cast<size_t>(i) * static_cast<size_t>(header_->slot_stride);
+    }
+
+    char* base_ = nullptr;
+    RegionHeader* header_ = nullptr;
+};
+
+// Busy-wait iterations before a waiter falls back to sleeping in the kernel.
+// Covers the round trip of a small UMAT request without a context switch.
+static constexpr int SPIN_ITERATIONS = 4000;
+
+// Name of the region a server with the given pid publishes.
+std::string region_name_for_pid(uint64_t pid);
+
+uint64_t current_pid();
+bool process_alive(uint64_t pid);
+
+} // namespace abqnn::ipc::shm
+
+#endif // ABQNN_IPC_SHM_H
@@ -0,0 +1,44 @@
+#ifndef ABQNN_IPC_TRANSPORT_H
+#define ABQNN_IPC_TRANSPORT_H
+
+#include <cstddef>
+#include <memory>
+
+namespace abqnn::ipc {
+
+// A client's connected, blocking, bidirectional byte stream to the server.
+// Frames (AbqnnIpcHeader + payload) are written and read on top of it; the
+// transport itself knows nothing about the wire format. The server side is
+// the reactor (abqnn_ipc_reactor.h).
+class Connection
+{
+public:
+    virtual ~Connection() = default;
+
+    virtual bool write_all(const void* data, size_t n) = 0;
+    // Writes `head` followed by `body`, in one gather write where the
+    // platform has one, so a frame's header and payload leave together.
+    virtual bool write_gather(const void* head, size_t head_size, const void* body, size_t body_size) = 0;
+    virtual bool read_all(void* data, size_t n) = 0;
+
+    // True if read_all would not block: data is waiting or the peer has gone
+    // (the read then fails at once). Never blocks.
+    virtual bool readable() = 0;
+
+    // Flushes pending output and releases the underlying handle. Safe to call
+    // more than once; the destructor calls it as well.
+    virtual void close() = 0;
+};
+
+// Endpoint used when the caller does not pass one explicitly: the value of the
+// ABQNN_IPC_ENDPOINT environment variable if set, otherwise
+// ABQNN_DEFAULT_ENDPOINT from abqnn_ipc_protocol.h.
+const char* default_endpoint();
+
+// Implemented once per platform backend (named pipes on Windows, Unix domain
+// sockets elsewhere).
+std::unique_ptr<Connection> connect_with_retry(const char* endpoint);
+
+} // namespace abqnn::ipc
+
+#endif // ABQNN_IPC_TRANSPORT_H
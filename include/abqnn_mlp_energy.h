@@ -0,0 +1,98 @@
+#ifndef ABQNN_MLP_ENERGY_H
+#define ABQNN_MLP_ENERGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace abqnn::server {
+
+// Isotropic strain energy psi = MLP(x) over the inputs
+//
+//   x = [I1bar - 3, I2bar - 3, J - 1, mat_par[0], ..., mat_par[K - 1]]
+//
+// where I1bar and I2bar are the isochoric invariants of C = F^T F. The MLP
+// is a stack of dense layers with a scalar identity output. Evaluated natively
+// (no TorchScript): forward-mode differentiation carries psi, its gradient and
+// its Hessian in the three invariants through the layers, and the invariant
+// derivatives are pushed forward to Kirchhoff stress and the spatial tangent in
+// closed form.
+//
+// Points are evaluated in tiles stored one component per row (structure of
+// arrays). Every layer is a sequence of contiguous multiply-adds over the
+// tile, which the compiler vectorizes for the target instruction set.
+//
+// Weight file (text, whitespace separated, `#` starts a comment):
+//
+//   abqnn-mlp-energy 1
+//   mat_par_inputs <K>
+//   layers <N>
+//   layer <in> <out> <softplus|tanh|identity>
+//   <out * in weights, row-major as torch.nn.Linear.weight>
+//   <out biases>
+//   ... N layers; the first takes 3 + K inputs, the last has 1 identity output.
+class MlpEnergyModel
+{
+public:
+    // Returns false with a message in `error` if the file is missing or malformed.
+    bool load(const std::string &path, std::string &error);
+
+    int32_t mat_par_inputs() const { return mat_par_inputs_; }
+    size_t weight_bytes() const { return weights_.size() * sizeof(double); }
+
+    // UMAT: n column-major 3x3 F (9 values per point, as Abaqus passes DFGRD1)
+    // to psi[n], Cauchy[n][6] and DDSDDE[n][6][6], Voigt order [11, 22, 33, 12,
+    // 13, 23]. `status[i]` is 0, or 105 when det F <= 0 (that point's outputs
+    // are NaN). Returns 110 without touching the outputs when fewer than
+    // mat_par_inputs() values are given.
+    int32_t umat(const double *F, int32_t n, const double *mat_par, int32_t n_mat_par, int32_t *status, double *psi,
+                 double *cauchy, double *ddsdde) const;
+
+    // VUMAT: defgradF(nblock, 3 + 2 * nshr) in Abaqus Fortran order (as for
+    // pack_vumat_defgrad) to energy[nblock] = psi and the co-rotational Cauchy
+    // stress(nblock, 3 + nshr), Fortran order, components [11, 22, 33, 12, 23,
+    // 31] (or [11, 22, 33, 12] for nshr = 1). Returns 110 for too few mat_par
+    // values, 111 for a layout other than (3, 3) or (3, 1), and 105 if any
+    // point has det F <= 0.
+    int32_t vumat(const double *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, const double *mat_par,
+                  int32_t n_mat_par, double *energy, double *stress) const;
+    int32_t vumat(const float *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, const double *mat_par,
+                  int32_t n_mat_par, float *energy, float *stress) const;
+
+private:
+    enum class Activation
+    {
+        identity,
+        softplus,
+        tanh
+    };
+
+    struct Layer
+    {
+        int32_t in = 0;
+        int32_t out = 0;
+        Activation activation = Activation::identity;
+        size_t weights = 0; // offset of the out x in weights in weights_
+        size_t bias = 0;    // offset of the out biases in weights_
+    };
+
+    struct Tile;
+
+    // psi and its invariant gradient/Hessian for tile.count points whose
+    // invariant inputs are already in the tile.
+    void evaluate(Tile &tile, const double *mat_par) const;
+
+    template <typename T>
+    int32_t vumat_impl(const T *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, const double *mat_par,
+                       int32_t n_mat_par, T *energy, T *stress) const;
+
+    int32_t mat_par_inputs_ = 0;
+    int32_t max_width_ = 0;
+    std::vector<Layer> layers_;
+    std::vector<double> weights_;
+};
+
+} // namespace abqnn::server
+
+#endif // ABQNN_MLP_ENERGY_H
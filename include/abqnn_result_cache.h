@@ -0,0 +1,101 @@
+#ifndef ABQNN_RESULT_CACHE_H
+#define ABQNN_RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace abqnn::server {
+
+struct ResultCacheStats
+{
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0; // keys, values and entry overhead
+
+    double hit_rate() const
+    {
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+// One memoized UMAT result: psi, then cauchy_n Cauchy and ddsdde_n DDSDDE
+// values in `values`.
+struct UmatResult
+{
+    double psi = 0.0;
+    int32_t cauchy_n = 0;
+    int32_t ddsdde_n = 0;
+    std::vector<double> values;
+
+    const double *cauchy() const { return values.data(); }
+    const double *ddsdde() const { return values.data() + cauchy_n; }
+};
+
+// Bounded map from (model, F, mat_par) to the UMAT result computed for it.
+// Keys compare the raw bytes of F and mat_par, so only bit-identical inputs
+// hit. `model` identifies what computed the result (the server passes the id
+// of the model version, never reused), so a new version never sees its
+// predecessor's results. Entries are spread over independently locked
+// shards; each shard holds up to its share of `max_entries` and replaces its
+// oldest entry when full.
+class UmatResultCache
+{
+public:
+    explicit UmatResultCache(size_t max_entries, size_t shards = 16);
+
+    UmatResultCache(const UmatResultCache &) = delete;
+    UmatResultCache &operator=(const UmatResultCache &) = delete;
+
+    // Copies the stored result into `out` on a hit.
+    bool lookup(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par, UmatResult &out);
+
+    void insert(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par, double psi,
+                const double *cauchy, int32_t cauchy_n, const double *ddsdde, int32_t ddsdde_n);
+
+    // Drops every entry of `model`, e.g. once that model version is gone.
+    void erase_model(uint64_t model);
+
+    ResultCacheStats stats() const;
+
+private:
+    struct Entry
+    {
+        uint64_t hash = 0;
+        uint64_t model = 0;
+        std::string key;
+        UmatResult result;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, size_t> index; // hash -> slot
+        std::vector<Entry> slots;
+        size_t next = 0;    // slot replaced by the next insert once full
+        size_t bytes = 0;
+        uint64_t evictions = 0;
+    };
+
+    // Serializes the key into `key` and returns its hash.
+    static uint64_t make_key(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par,
+                             std::string &key);
+    Shard &shard_for(uint64_t hash) const;
+
+    size_t capacity_per_shard_;
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_count_;
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> hits_{0};
+};
+
+} // namespace abqnn::server
+
+#endif // ABQNN_RESULT_CACHE_H
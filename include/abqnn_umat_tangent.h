@@ -0,0 +1,27 @@
+#ifndef ABQNN_UMAT_TANGENT_H
+#define ABQNN_UMAT_TANGENT_H
+
+#include <cstdint>
+
+namespace abqnn::server {
+
+// UMAT outputs of an energy psi(F) from its derivatives, for n points:
+//
+//   F[n][3][3]          deformation gradient, row-major
+//   P[n][3][3]          dpsi/dF (first Piola-Kirchhoff stress), row-major
+//   A[n][3][3][3][3]    d2psi/dF2, A[b][i][J][k][L] = dP_iJ / dF_kL
+//
+// to Cauchy[n][6] = (P F^T / J) and DDSDDE[n][6][6], the Jaumann-corrected
+// spatial tangent
+//
+//   (A_iqks F_jq F_ls + (tau_ik d_jl + tau_il d_jk + tau_jk d_il - tau_jl d_ik) / 2) / J
+//
+// with tau = P F^T, in Voigt order [11, 22, 33, 12, 13, 23] (the same as
+// psi_F_derivates_to_UMAT_3D in utils/gen_test_ts_models.py). `status[b]`
+// is 0, or 105 when det F <= 0, in which case that point's outputs are NaN.
+void umat_from_energy_derivatives(const double *F, const double *P, const double *A, int32_t n, int32_t *status,
+                                  double *cauchy, double *ddsdde);
+
+} // namespace abqnn::server
+
+#endif // ABQNN_UMAT_TANGENT_H
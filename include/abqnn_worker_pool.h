@@ -0,0 +1,98 @@
+#ifndef ABQNN_WORKER_POOL_H
+#define ABQNN_WORKER_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace abqnn::server {
+
+// Unit of work executed by the pool. Plain function pointer plus context so
+// submitting a request never allocates; the submitter keeps `context` alive
+// until the task has run.
+struct Task
+{
+    void (*run)(void *context) = nullptr;
+    void *context = nullptr;
+};
+
+struct WorkerPoolStats
+{
+    size_t workers = 0;
+    size_t queue_depth = 0;       // tasks submitted but not yet started
+    size_t max_queue_depth = 0;   // high-water mark of queue_depth
+    size_t busy_workers = 0;      // workers currently running a task
+    uint64_t tasks_completed = 0;
+    uint64_t tasks_stolen = 0;    // tasks run by a worker other than the one they were queued on
+    uint64_t busy_ns = 0;         // summed over workers
+    uint64_t uptime_ns = 0;
+
+    // Fraction of worker time spent running tasks since the pool started.
+    double utilisation() const
+    {
+        return (workers == 0 || uptime_ns == 0) ? 0.0
+                                                : static_cast<double>(busy_ns) / (static_cast<double>(uptime_ns) * workers);
+    }
+};
+
+// Fixed-size pool of inference workers. Each worker owns a deque; submissions
+// are spread round-robin over the deques, a worker serves its own deque first
+// and steals from the others when it runs dry.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t worker_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void submit(Task task);
+
+    // Submits the task and blocks the calling thread until it has run.
+    void run_and_wait(Task task);
+
+    size_t size() const { return workers_.size(); }
+    WorkerPoolStats stats() const;
+
+    // Index of the calling worker in [0, size()), or -1 off the pool.
+    static int current_worker_index();
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> busy_ns{0};
+    };
+
+    void worker_main(size_t index);
+    bool pop_local(size_t index, Task &task);
+    bool steal(size_t thief, Task &task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    bool stopping_ = false;
+
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> max_pending_{0};
+    std::atomic<size_t> busy_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::chrono::steady_clock::time_point started_;
+};
+
+} // namespace abqnn::server
+
+#endif // ABQNN_WORKER_POOL_H
@@ -10,6 +10,8 @@ extern "C" {
  * 
  * This function is the Abaqus-facing IPC client entrypoint.
  * Thread-safe initialization is performed on first call.
+ * With ABQNN_COALESCE_WINDOW_US set, concurrent calls for the same model and
+ * mat_par are sent to the server together (see README, "Coalescing UMAT Calls").
  * The shape of F is fixed as 3x3, while output sizes are model-defined.
  * In all cases F is a 3x3 deformation gradient tensor and psi is a scalar.
  * Cauchy and DDSDDE are filled from server response payload exactly as produced
@@ -31,10 +33,12 @@ extern "C" {
  *   110 - Invalid input parameters
  *   111 - Unsupported tensor layout/shape mismatch
  *   112 - CUDA requested but unavailable on server
+ *   113 - Unknown model handle (handled inside the library, see invoke_pt_register)
  *   120 - IPC connect error
  *   121 - IPC write error
  *   122 - IPC read error
  *   123 - IPC protocol error
+ *   124 - Request not supported by the server (an older server dropped it)
  */
 int invoke_pt(
     const char* module_filename,
@@ -67,6 +71,166 @@ int invoke_pt_vumat_batch(
     double* stressNew
 );
 
+/**
+ * @brief Resolve a model and its mat_par once, for invoke_pt_by_handle.
+ *
+ * The server loads the model and keeps a prepared copy of mat_par, so later
+ * calls send only a small handle and F. Registering the same model and mat_par
+ * again returns the same handle. Handles stay valid for the life of the
+ * process; after a server restart the library registers them again on its own.
+ *
+ * @param handle Set to a positive handle, 0 on error
+ * @return int Error code (0 = success, see invoke_pt)
+ */
+int invoke_pt_register(
+    const char* module_filename,
+    const double* mat_par,
+    int n_mat_par,
+    int* handle
+);
+
+/**
+ * @brief invoke_pt for a model registered with invoke_pt_register.
+ *
+ * @return int Error code (0 = success, see invoke_pt; 110 for an unknown handle)
+ */
+int invoke_pt_by_handle(
+    int handle,
+    const double* F,
+    double* psi,
+    double* Cauchy,
+    double* DDSDDE
+);
+
+/**
+ * @brief Register a VUMAT model and its mat_par, for invoke_pt_vumat_batch_by_handle.
+ *
+ * Same contract as invoke_pt_register; UMAT and VUMAT handles are distinct.
+ */
+int invoke_pt_vumat_register(
+    const char* module_filename,
+    const double* mat_par,
+    int n_mat_par,
+    int* handle
+);
+
+/**
+ * @brief invoke_pt_vumat_batch for a model registered with invoke_pt_vumat_register.
+ */
+int invoke_pt_vumat_batch_by_handle(
+    int handle,
+    const double* defgradF,
+    int nblock,
+    int ndir,
+    int nshr,
+    double* enerInternNew,
+    double* stressNew
+);
+
+/**
+ * @brief Single-precision invoke_pt_vumat_batch, for Abaqus/Explicit runs in
+ * single precision.
+ *
+ * Same layout as invoke_pt_vumat_batch. All reals cross the IPC boundary as
+ * float32 and the server evaluates a float32 copy of the model.
+ *
+ * @return int Error code (0 = success)
+ */
+int invoke_pt_vumat_batch_f32(
+    const char* module_filename,
+    const float* defgradF,
+    int nblock,
+    int ndir,
+    int nshr,
+    const float* mat_par,
+    int n_mat_par,
+    float* enerInternNew,
+    float* stressNew
+);
+
+/**
+ * @brief Start an invoke_pt call without waiting for its result.
+ *
+ * The request is sent at once on a connection of its own; F and mat_par may be
+ * reused as soon as this returns. psi, Cauchy and DDSDDE are written by
+ * invoke_pt_wait and must stay valid until then. Submitted calls are never
+ * coalesced.
+ *
+ * @param ticket Set to a positive handle for invoke_pt_poll/invoke_pt_wait, 0 on error
+ * @return int Error code of the submission (0 = success, see invoke_pt)
+ */
+int invoke_pt_submit(
+    const char* module_filename,
+    const double* F,
+    const double* mat_par,
+    int n_mat_par,
+    double* psi,
+    double* Cauchy,
+    double* DDSDDE,
+    int* ticket
+);
+
+/**
+ * @brief Start an invoke_pt_vumat_batch call without waiting for its result.
+ *
+ * Same contract as invoke_pt_submit: defgradF and mat_par are copied,
+ * enerInternNew and stressNew are filled by invoke_pt_wait.
+ */
+int invoke_pt_vumat_batch_submit(
+    const char* module_filename,
+    const double* defgradF,
+    int nblock,
+    int ndir,
+    int nshr,
+    const double* mat_par,
+    int n_mat_par,
+    double* enerInternNew,
+    double* stressNew,
+    int* ticket
+);
+
+/**
+ * @brief Check whether a submitted call has its response, without blocking.
+ *
+ * Sets *done to 1 once invoke_pt_wait on the ticket would not block, else 0.
+ *
+ * @return int 0, or 110 for an unknown ticket
+ */
+int invoke_pt_poll(int ticket, int* done);
+
+/**
+ * @brief Wait for a submitted call and write its outputs.
+ *
+ * Releases the ticket. Any thread may wait on any ticket, once.
+ *
+ * @return int The call's error code, as invoke_pt or invoke_pt_vumat_batch
+ *             would return it; 110 for an unknown ticket
+ */
+int invoke_pt_wait(int ticket);
+
+/**
+ * @brief Query the inference server's runtime statistics.
+ *
+ * Writes a NUL-terminated "key=value" list, one entry per line (worker count,
+ * queue depth, worker utilisation, ...), truncated to buffer_size bytes.
+ *
+ * @return int Error code (0 = success)
+ */
+int abqnn_server_stats(char* buffer, int buffer_size);
+
+/**
+ * @brief Reload a model file on the inference server.
+ *
+ * The server loads and warms up the new file while it keeps serving the old
+ * version, then switches every later request (registered handles included)
+ * over to it. A model the server has not loaded yet is left alone.
+ *
+ * @param module_filename Model file, as passed to invoke_pt
+ * @return int Error code (0 = success, 101 = the new file failed to load;
+ *             the old version stays in service)
+ */
+int abqnn_reload_model(const char* module_filename);
+
 #ifdef __cplusplus
 }
 #endif
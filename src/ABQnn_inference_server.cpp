@@ -1,18 +1,31 @@
+#include <cmath>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <deque>
 #include <mutex>
-#include <shared_mutex>
+#include <condition_variable>
 #include <filesystem>
+#include <future>
 #include <thread>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
 
 #include <torch/torch.h>
 #include <torch/script.h>
 #include <torch/cuda.h>
+#include <torch/csrc/jit/passes/inliner.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,9 +34,43 @@
 #include "abqnn_config.h"
 #include "abqnn_ipc_protocol.h"
 #include "abqnn_ipc_common.h"
+#include "abqnn_ipc_reactor.h"
+#include "abqnn_ipc_shm.h"
+#include "abqnn_worker_pool.h"
+#include "abqnn_batcher.h"
+#include "abqnn_defgrad_pack.h"
+#include "abqnn_result_cache.h"
+#include "abqnn_mlp_energy.h"
+#include "abqnn_umat_tangent.h"
+
+// Runtime settings, taken from the command line (see parse_server_options).
+struct ServerOptions
+{
+    size_t workers = 0;          // inference worker threads; 0 = hardware concurrency
+    size_t io_threads = 2;       // reactor threads accepting and reading connections
+    size_t max_connections = 0;  // concurrently open connections; 0 = unlimited
+    int stats_interval_s = 0;    // period of the stats dump to stderr; 0 = off
+    size_t umat_batch_size = 1;  // UMAT requests per batched forward; 1 = no batching
+    size_t umat_batch_wait_us = 500; // longest a UMAT request waits for its batch to fill
+    bool symmetric_ddsdde = false; // declare every model's DDSDDE symmetric
+    size_t intra_op_threads = 0; // LibTorch intra-op threads per forward; 0 = LibTorch default
+    size_t interop_threads = 0;  // LibTorch inter-op pool size; 0 = LibTorch default
+    size_t parallel_min_points = 0; // forwards over fewer points run single-threaded; 0 = off
+    bool module_replicas = false; // each worker runs forwards on its own clone of a model
+    bool optimize_models = false; // freeze and optimise models as they are loaded
+    bool inference_mode = true;   // run forwards of autograd-free models in c10::InferenceMode
+    std::string preload_manifest; // models to load and warm up before listening; empty = none
+    int watch_interval_s = 0;     // period of the model file check for hot reloads; 0 = off
+    size_t model_cache_bytes = 0; // budget for idle cached models; 0 = unlimited
+    size_t umat_result_cache = 0; // memoized single-point UMAT results; 0 = off
+};
 
-static std::map<std::string, torch::jit::Module> module_table;
-static std::shared_mutex module_table_mutex;
+static ServerOptions server_options;
+static std::unique_ptr<abqnn::server::WorkerPool> worker_pool;
+// Dynamic batcher for single-point UMAT requests; null unless --umat-batch-size > 1.
+static std::unique_ptr<abqnn::server::Batcher> umat_batcher;
+// Results of single-point UMAT requests; null unless --umat-result-cache > 0.
+static std::unique_ptr<abqnn::server::UmatResultCache> umat_result_cache;
 
 enum class RequestKind
 {
@@ -31,6 +78,237 @@ enum class RequestKind
     VUMAT
 };
 
+// One version of a cached model and what the server knows about it. Shared
+// by the module table, registered handles, parked batch requests and running
+// forwards; the struct is freed with the last of them. Once a version is
+// retired (replaced by a reload, or evicted from the cache) its `module` is
+// released as soon as no forward pins it, even while handles still refer to
+// the struct. A reload links the replaced version to its successor.
+struct LoadedModule
+{
+    // Unique to this version, never reused; identifies it where an address
+    // could be taken over by a later version (e.g. memoized results).
+    uint64_t version = 0;
+    torch::jit::Module module;
+    // Set instead of `module` for a native MLP energy model (a .mlp weight
+    // file); its forwards run on the CPU without TorchScript.
+    std::unique_ptr<abqnn::server::MlpEnergyModel> native;
+    // What the version was loaded from and as, for reloads.
+    std::string module_filename;
+    RequestKind kind = RequestKind::UMAT;
+    torch::ScalarType dtype = torch::kDouble;
+    std::filesystem::file_time_type file_time{};
+    // DDSDDE may be sent packed (see ABQNN_IPC_FLAG_PACKED_DDSDDE). Set by a
+    // boolean `ddsdde_symmetric` attribute on the model, or for every model
+    // by --symmetric-ddsdde 1.
+    bool ddsdde_symmetric = false;
+    // Set by a boolean `energy_only` attribute: a UMAT model whose forward
+    // returns only psi[B], or (psi[B], P[B, 3, 3] = dpsi/dF), for F[B, 3, 3].
+    // The server derives Cauchy and DDSDDE (see run_umat_energy_batch).
+    bool energy_only = false;
+    // The model differentiates inside forward (torch.autograd.grad), so its
+    // forwards cannot run in inference mode.
+    bool uses_autograd = false;
+    // Frozen and optimised by prepare_module_for_inference.
+    bool prepared = false;
+    // Results may be memoized (--umat-result-cache). A model opts out with a
+    // boolean `deterministic` attribute set to false.
+    bool memoize = true;
+    // Requests run on the model, the material points in them and their total
+    // forward time, for the stats (see ModelRunScope).
+    std::atomic<uint64_t> runs{0};
+    std::atomic<uint64_t> points{0};
+    std::atomic<uint64_t> run_ns{0};
+    // Tensor bytes held by the module, counted against --model-cache-mb.
+    size_t bytes = 0;
+    // Preloaded, so never evicted.
+    std::atomic<bool> pinned{false};
+    // Forwards running on the module (see ModelRunScope) and, for LRU
+    // eviction, when the last one started.
+    std::atomic<int32_t> users{0};
+    std::atomic<int64_t> last_used_ns{0};
+    // Set once a newer version took its place (see latest_version). Read and
+    // written with std::atomic_load/atomic_store.
+    std::shared_ptr<LoadedModule> replaced_by;
+    // No longer in the module table; `released` once `module` is dropped.
+    std::atomic<bool> retired{false};
+    std::atomic<bool> released{false};
+};
+
+// The newest version of a model, for holders of an older one.
+static std::shared_ptr<LoadedModule> latest_version(std::shared_ptr<LoadedModule> loaded)
+{
+    while (std::shared_ptr<LoadedModule> next = std::atomic_load(&loaded->replaced_by))
+    {
+        loaded = std::move(next);
+    }
+    return loaded;
+}
+
+// Cached models by module cache key. A table is immutable once published;
+// loads, reloads and evictions publish a modified copy. Readers take the
+// current table with std::atomic_load, never module_table_write_mutex, and
+// keep it alive while they look through it; a replaced table is freed with
+// its last reader.
+struct ModuleTable
+{
+    std::map<std::string, std::shared_ptr<LoadedModule>> models;
+};
+
+static std::shared_ptr<const ModuleTable> module_table = std::make_shared<ModuleTable>();
+// Serializes publishing and the registry of loads in flight; never taken by
+// a lookup of a cached model.
+static std::mutex module_table_write_mutex;
+static std::map<std::string, std::shared_future<int>> module_loads_in_flight;
+
+static std::shared_ptr<const ModuleTable> current_module_table()
+{
+    return std::atomic_load(&module_table);
+}
+
+static std::shared_ptr<LoadedModule> find_cached_module(const std::string &module_cache_key)
+{
+    std::shared_ptr<const ModuleTable> table = current_module_table();
+    auto it = table->models.find(module_cache_key);
+    return it != table->models.end() ? it->second : nullptr;
+}
+
+// Cache counters for the stats: lookups that found their model, lookups
+// that had to load it, and models evicted for --model-cache-mb.
+static std::atomic<uint64_t> model_cache_hits{0};
+static std::atomic<uint64_t> model_cache_misses{0};
+static std::atomic<uint64_t> model_cache_evictions{0};
+// Source of LoadedModule::version.
+static std::atomic<uint64_t> last_module_version{0};
+// Versions retired so far; workers sweep their module replicas when it moves.
+static std::atomic<uint64_t> module_retirements{0};
+
+static int64_t steady_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Drops the module of a retired version, and its memoized results, once.
+// Whoever sees the version both retired and unpinned calls this; pinning
+// checks `retired` after raising `users`, so no forward can still be using
+// the module or memoizing its results.
+static void release_module(LoadedModule *loaded)
+{
+    if (!loaded->released.exchange(true))
+    {
+        loaded->module = torch::jit::Module();
+        loaded->native.reset();
+        if (umat_result_cache)
+        {
+            umat_result_cache->erase_model(loaded->version);
+        }
+    }
+}
+
+// Called after the version has left the table. The caller holds
+// module_table_write_mutex.
+static void retire_module(LoadedModule *loaded)
+{
+    loaded->retired.store(true);
+    module_retirements.fetch_add(1, std::memory_order_release);
+    if (loaded->users.load() == 0)
+    {
+        release_module(loaded);
+    }
+}
+
+static void unpin_module(LoadedModule *loaded)
+{
+    if (loaded->users.fetch_sub(1) == 1 && loaded->retired.load())
+    {
+        release_module(loaded);
+    }
+}
+
+// Publishes `loaded` under `module_cache_key`, replacing and retiring any
+// current version. The caller holds module_table_write_mutex.
+static void publish_module(const std::string &module_cache_key, const std::shared_ptr<LoadedModule> &loaded)
+{
+    auto next = std::make_shared<ModuleTable>(*current_module_table());
+    std::shared_ptr<LoadedModule> &slot = next->models[module_cache_key];
+    std::shared_ptr<LoadedModule> replaced = std::move(slot);
+    slot = loaded;
+    std::atomic_store(&module_table, std::shared_ptr<const ModuleTable>(std::move(next)));
+    if (replaced)
+    {
+        std::atomic_store(&replaced->replaced_by, loaded);
+        retire_module(replaced.get());
+    }
+}
+
+// With --model-cache-mb, evicts least recently used models until the cached
+// tensor bytes fit the budget. Preloaded models, models with a forward
+// running and `keep` (the model just loaded) stay. An evicted model is loaded
+// again by its next request. The caller holds module_table_write_mutex.
+static void evict_idle_modules(const LoadedModule *keep)
+{
+    const size_t budget = server_options.model_cache_bytes;
+    if (budget == 0)
+    {
+        return;
+    }
+
+    std::shared_ptr<const ModuleTable> current = current_module_table();
+    size_t cached_bytes = 0;
+    for (const auto &[key, loaded] : current->models)
+    {
+        cached_bytes += loaded->bytes;
+    }
+    if (cached_bytes <= budget)
+    {
+        return;
+    }
+
+    auto next = std::make_shared<ModuleTable>(*current);
+    std::vector<std::shared_ptr<LoadedModule>> evicted;
+    while (cached_bytes > budget)
+    {
+        auto victim = next->models.end();
+        for (auto it = next->models.begin(); it != next->models.end(); ++it)
+        {
+            const LoadedModule *loaded = it->second.get();
+            if (loaded == keep || loaded->pinned.load(std::memory_order_relaxed) ||
+                loaded->users.load(std::memory_order_relaxed) != 0)
+            {
+                continue;
+            }
+            if (victim == next->models.end() ||
+                loaded->last_used_ns.load(std::memory_order_relaxed) <
+                    victim->second->last_used_ns.load(std::memory_order_relaxed))
+            {
+                victim = it;
+            }
+        }
+        if (victim == next->models.end())
+        {
+            break;
+        }
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: evicting %s (%zu bytes)\n", victim->first.c_str(), victim->second->bytes);
+#endif
+        cached_bytes -= victim->second->bytes;
+        evicted.push_back(victim->second);
+        next->models.erase(victim);
+    }
+    if (evicted.empty())
+    {
+        return;
+    }
+
+    std::atomic_store(&module_table, std::shared_ptr<const ModuleTable>(std::move(next)));
+    for (const std::shared_ptr<LoadedModule> &loaded : evicted)
+    {
+        retire_module(loaded.get());
+    }
+    model_cache_evictions.fetch_add(evicted.size(), std::memory_order_relaxed);
+}
+
 static const char *get_configured_device_name(RequestKind request_kind)
 {
     return request_kind == RequestKind::UMAT ? ABQNN_UMAT_TORCH_DEVICE : ABQNN_VUMAT_TORCH_DEVICE;
@@ -56,6 +334,7 @@ static int validate_inference_devices()
 
     if ((umat_wants_cuda || vumat_wants_cuda))
     {
+#ifdef _WIN32
         // Due to some reasons, we need to first load torch_cuda.dll manually 
         // before any CUDA-related API is called
         std::wstring dll_path_w = std::filesystem::path(ABQNN_LIBTORCH_LIB_PATH).wstring();
@@ -80,6 +359,7 @@ static int validate_inference_devices()
             std::fprintf(stderr, "server: successfully loaded torch_cuda.dll\n");
 #endif
         }
+#endif
 
         if(torch::cuda::is_available())
         {
@@ -96,43 +376,294 @@ static int validate_inference_devices()
     return 0;
 }
 
-static int try_load_module(const char *module_filename, RequestKind request_kind, torch::jit::Module *&out_module)
+// Writes "path|device" into `key`, with "|f32" appended for the float32 copy
+// of a model. Callers on the request path pass a reused (thread-local)
+// string, so building the key does not allocate.
+static void module_cache_key_for(std::string_view module_filename, RequestKind request_kind, std::string &key,
+                                 torch::ScalarType dtype = torch::kDouble)
 {
-    std::string module_filename_str(module_filename);
-    std::string module_cache_key = module_filename_str + "|" + get_configured_device_name(request_kind);
+    key.assign(module_filename.data(), module_filename.size());
+    key += '|';
+    key += get_configured_device_name(request_kind);
+    if (dtype == torch::kFloat)
+    {
+        key += "|f32";
+    }
+}
 
+// Whether a node of `block`, or of a block nested in one (loops, ifs),
+// differentiates or asks for gradients.
+static bool block_uses_autograd(const torch::jit::Block *block)
+{
+    static const c10::Symbol grad = c10::Symbol::fromQualString("aten::grad");
+    static const c10::Symbol backward = c10::Symbol::fromQualString("aten::backward");
+    static const c10::Symbol requires_grad = c10::Symbol::fromQualString("aten::requires_grad_");
+    for (const torch::jit::Node *node : block->nodes())
     {
-        std::shared_lock<std::shared_mutex> lock(module_table_mutex);
-        auto it = module_table.find(module_cache_key);
-        if (it != module_table.end())
+        const c10::Symbol kind = node->kind();
+        if (kind == grad || kind == backward || kind == requires_grad)
         {
-            out_module = &it->second;
-            return 0;
+            return true;
+        }
+        for (const torch::jit::Block *nested : node->blocks())
+        {
+            if (block_uses_autograd(nested))
+            {
+                return true;
+            }
         }
     }
+    return false;
+}
 
-    std::unique_lock<std::shared_mutex> lock(module_table_mutex);
-    auto it = module_table.find(module_cache_key);
-    if (it != module_table.end())
+// Whether any method of the module, with the functions and methods it calls
+// inlined, differentiates or asks for gradients.
+static bool module_uses_autograd(const torch::jit::Module &module)
+{
+    for (const torch::jit::Method &method : module.get_methods())
     {
-        out_module = &it->second;
-        return 0;
+        std::shared_ptr<torch::jit::Graph> graph = method.graph()->copy();
+        torch::jit::Inline(*graph);
+        if (block_uses_autograd(graph->block()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// --optimize-models: freezes the module, folding parameters and attributes
+// into its graphs as constants, then runs optimize_for_inference unless the
+// model differentiates inside forward. forward_batch is kept. On any failure
+// `module` is left as loaded and false is returned.
+static bool prepare_module_for_inference(torch::jit::Module &module, bool uses_autograd)
+{
+    std::vector<std::string> preserved;
+    if (module.find_method("forward_batch"))
+    {
+        preserved.push_back("forward_batch");
     }
 
     try
     {
-        std::filesystem::current_path(ABQNN_MODEL_PATH);
-        auto inference_device = get_inference_device(request_kind);
-        torch::jit::Module module = torch::jit::load(module_filename_str, inference_device);
-        module.to(inference_device);
-        module.eval();
+        // A module saved frozen has no `training` attribute; the passes below
+        // modify it in place, so work on a copy.
+        torch::jit::Module prepared = module.hasattr("training") ? torch::jit::freeze(module, preserved) : module.clone();
+        if (!uses_autograd)
+        {
+            prepared = torch::jit::optimize_for_inference(prepared, preserved);
+        }
+        module = prepared;
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: model preparation failed, keeping the loaded model: %s\n", e.what());
+#endif
+        return false;
+    }
+}
+
+#ifdef ENABLE_DEBUG_OUTPUT
+// Timed forwards per measurement, after one untimed run that the profiling
+// executor uses to record shapes.
+static constexpr int kPrepareTimingRuns = 5;
+
+// Mean wall time in microseconds of a forward on synthetic inputs near the
+// identity: one F for UMAT, a block of 16 for VUMAT, and mat_par all ones,
+// as many as the module's `n_mat_par` attribute says (8 without one). -1 if
+// the module does not take them. Debug builds log it before and after
+// --optimize-models preparation.
+static double time_synthetic_forwards(torch::jit::Module &module, RequestKind request_kind, torch::ScalarType dtype,
+                                      torch::Device device, bool uses_autograd)
+{
+    try
+    {
+        c10::InferenceMode guard(!uses_autograd);
+        int64_t n_mat_par = 8;
+        if (module.hasattr("n_mat_par") && module.attr("n_mat_par").isInt())
+        {
+            n_mat_par = module.attr("n_mat_par").toInt();
+        }
+        const auto options = torch::TensorOptions().dtype(dtype).device(device);
+        torch::Tensor mat_par = torch::ones({n_mat_par}, options);
+        torch::Tensor F = torch::eye(3, options);
+        F.index_put_({0, 1}, 0.01);
+        if (request_kind == RequestKind::VUMAT)
+        {
+            F = F.expand({16, 3, 3}).contiguous();
+        }
+
+        double total_us = 0.0;
+        for (int run = 0; run <= kPrepareTimingRuns; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            module.forward({F, mat_par});
+            if (device.is_cuda())
+            {
+                torch::cuda::synchronize();
+            }
+            if (run > 0)
+            {
+                total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+        return total_us / kPrepareTimingRuns;
+    }
+    catch (const std::exception &)
+    {
+        return -1.0;
+    }
+}
+#endif
+
+// Relative model names are taken relative to ABQNN_MODEL_PATH. Resolved per
+// call, so loading never touches the process working directory.
+static std::string resolve_model_path(std::string_view module_filename)
+{
+    std::filesystem::path path{std::string(module_filename)};
+    if (path.is_relative())
+    {
+        path = std::filesystem::path(ABQNN_MODEL_PATH) / path;
+    }
+    return path.string();
+}
+
+// Bytes of the tensors a module holds as parameters and buffers. Counted
+// before preparation, which folds them into graph constants.
+static size_t module_tensor_bytes(const torch::jit::Module &module)
+{
+    size_t bytes = 0;
+    for (const auto &attr : module.named_attributes(/*recurse=*/true))
+    {
+        if (attr.value.isTensor())
+        {
+            bytes += attr.value.toTensor().nbytes();
+        }
+    }
+    return bytes;
+}
+
+// A `.mlp` file holds the weights of a native MLP energy model (see
+// abqnn_mlp_energy.h) rather than a TorchScript model.
+static bool is_native_model_file(std::string_view module_filename)
+{
+    constexpr std::string_view suffix = ".mlp";
+    return module_filename.size() >= suffix.size() &&
+           module_filename.substr(module_filename.size() - suffix.size()) == suffix;
+}
 
-        auto [inserted_it, success] = module_table.emplace(module_cache_key, std::move(module));
-        if (!success)
+// Loads, converts and (with --optimize-models) prepares a model into `loaded`.
+// Runs without any lock held.
+static int load_module_into(LoadedModule &loaded, const std::string &module_cache_key,
+                            std::string_view module_filename, RequestKind request_kind, torch::ScalarType dtype)
+{
+    try
+    {
+        auto inference_device = get_inference_device(request_kind);
+        auto load_start = std::chrono::steady_clock::now();
+        const std::string path = resolve_model_path(module_filename);
+        std::error_code time_err;
+        const auto file_time = std::filesystem::last_write_time(path, time_err);
+        torch::jit::Module module;
+        std::unique_ptr<abqnn::server::MlpEnergyModel> native;
+        bool ddsdde_symmetric = server_options.symmetric_ddsdde;
+        bool energy_only = false;
+        bool memoize = true;
+        size_t bytes = 0;
+        bool uses_autograd = false;
+        bool prepared = false;
+        if (is_native_model_file(module_filename))
         {
-            return 102;
+            // Computes in double precision whatever the dtype; its tangent
+            // is symmetric by construction.
+            native = std::make_unique<abqnn::server::MlpEnergyModel>();
+            std::string error;
+            if (!native->load(path, error))
+            {
+                throw std::runtime_error(error);
+            }
+            ddsdde_symmetric = true;
+            bytes = native->weight_bytes();
+        }
+        else
+        {
+            module = torch::jit::load(path, inference_device);
+            module.to(inference_device);
+            if (dtype == torch::kFloat)
+            {
+                module.to(torch::kFloat);
+            }
+            module.eval();
+
+            if (module.hasattr("ddsdde_symmetric"))
+            {
+                torch::jit::IValue declared = module.attr("ddsdde_symmetric");
+                ddsdde_symmetric = ddsdde_symmetric || (declared.isBool() && declared.toBool());
+            }
+            if (module.hasattr("energy_only"))
+            {
+                torch::jit::IValue declared = module.attr("energy_only");
+                energy_only = declared.isBool() && declared.toBool();
+            }
+            if (module.hasattr("deterministic"))
+            {
+                torch::jit::IValue declared = module.attr("deterministic");
+                memoize = !declared.isBool() || declared.toBool();
+            }
+            bytes = module_tensor_bytes(module);
+            // The server differentiates an energy-only model's forward.
+            uses_autograd = energy_only || module_uses_autograd(module);
+            if (server_options.optimize_models)
+            {
+#ifdef ENABLE_DEBUG_OUTPUT
+                const double loaded_us =
+                    time_synthetic_forwards(module, request_kind, dtype, inference_device, uses_autograd);
+#endif
+                prepared = prepare_module_for_inference(module, uses_autograd);
+#ifdef ENABLE_DEBUG_OUTPUT
+                const double prepared_us =
+                    prepared ? time_synthetic_forwards(module, request_kind, dtype, inference_device, uses_autograd)
+                             : -1.0;
+                if (prepared && loaded_us >= 0.0 && prepared_us >= 0.0)
+                {
+                    std::fprintf(stderr, "server: %s synthetic forward: %.1f us as loaded, %.1f us prepared\n",
+                                 module_cache_key.c_str(), loaded_us, prepared_us);
+                }
+                else if (prepared)
+                {
+                    std::fprintf(stderr, "server: %s synthetic forward not timed (inputs not accepted)\n",
+                                 module_cache_key.c_str());
+                }
+#endif
+            }
         }
-        out_module = &inserted_it->second;
+
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: loaded %s in %.1f ms (%s, %s)\n", module_cache_key.c_str(),
+                     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count(),
+                     native ? "native MLP" : prepared ? "frozen and optimised" : "as saved",
+                     uses_autograd ? "uses autograd" : "inference mode");
+#else
+        (void)module_cache_key;
+        (void)load_start;
+#endif
+
+        loaded.version = last_module_version.fetch_add(1) + 1;
+        loaded.module = std::move(module);
+        loaded.native = std::move(native);
+        loaded.module_filename.assign(module_filename.data(), module_filename.size());
+        loaded.kind = request_kind;
+        loaded.dtype = dtype;
+        loaded.file_time = time_err ? std::filesystem::file_time_type{} : file_time;
+        loaded.ddsdde_symmetric = ddsdde_symmetric;
+        loaded.energy_only = energy_only;
+        loaded.uses_autograd = uses_autograd;
+        loaded.prepared = prepared;
+        loaded.memoize = memoize;
+        loaded.bytes = bytes;
+        loaded.last_used_ns.store(steady_now_ns(), std::memory_order_relaxed);
         return 0;
     }
     catch (const std::exception &e)
@@ -144,10 +675,221 @@ static int try_load_module(const char *module_filename, RequestKind request_kind
     }
 }
 
-static int build_defgrad_batch_tensor(const double *defgradF,
+// Models are cached as loaded; a float32 request gets its own copy of the
+// model converted to float32. With --optimize-models the cached copy is the
+// prepared one. The first request for a model loads it; requests for the
+// same model meanwhile wait for that load, all others carry on. A failed
+// load is not cached and is retried by the next request. The model returned
+// may be evicted at any time; ModelRunScope pins it for a forward.
+static int try_load_module(std::string_view module_filename, RequestKind request_kind,
+                           std::shared_ptr<LoadedModule> &out_module, torch::ScalarType dtype = torch::kDouble)
+{
+    thread_local std::string module_cache_key;
+    module_cache_key_for(module_filename, request_kind, module_cache_key, dtype);
+
+    if (std::shared_ptr<LoadedModule> cached = find_cached_module(module_cache_key))
+    {
+        model_cache_hits.fetch_add(1, std::memory_order_relaxed);
+        out_module = std::move(cached);
+        return 0;
+    }
+
+    const std::string key = module_cache_key;
+    std::promise<int> result;
+    {
+        std::unique_lock<std::mutex> lock(module_table_write_mutex);
+        if (std::shared_ptr<LoadedModule> cached = find_cached_module(key))
+        {
+            model_cache_hits.fetch_add(1, std::memory_order_relaxed);
+            out_module = std::move(cached);
+            return 0;
+        }
+        model_cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+        auto in_flight = module_loads_in_flight.find(key);
+        if (in_flight != module_loads_in_flight.end())
+        {
+            std::shared_future<int> load = in_flight->second;
+            lock.unlock();
+            const int status = load.get();
+            if (status != 0)
+            {
+                return status;
+            }
+            out_module = find_cached_module(key);
+            // Evicted again before this thread got to it: load it once more.
+            return out_module ? 0 : try_load_module(module_filename, request_kind, out_module, dtype);
+        }
+        module_loads_in_flight.emplace(key, result.get_future().share());
+    }
+
+    // This thread owns the load.
+    auto loaded = std::make_shared<LoadedModule>();
+    const int status = load_module_into(*loaded, key, module_filename, request_kind, dtype);
+    {
+        std::lock_guard<std::mutex> lock(module_table_write_mutex);
+        if (status == 0)
+        {
+            out_module = std::move(loaded);
+            publish_module(key, out_module);
+            evict_idle_modules(out_module.get());
+        }
+        module_loads_in_flight.erase(key);
+    }
+    result.set_value(status);
+    return status;
+}
+
+static bool runs_in_inference_mode(const LoadedModule &loaded)
+{
+    return server_options.inference_mode && !loaded.uses_autograd;
+}
+
+// The module a worker runs its forwards on: the cached one, or with
+// --module-replicas 1 the calling thread's own clone of it. A clone shares the
+// cached module's parameter tensors, which inference only reads, but has its
+// own methods and so its own graph executors and profiling state.
+static torch::jit::Module &module_for_thread(const std::shared_ptr<LoadedModule> &pinned)
+{
+    LoadedModule &loaded = *pinned;
+    if (!server_options.module_replicas)
+    {
+        return loaded.module;
+    }
+
+    // A replica does not keep its version's struct alive.
+    struct Replica
+    {
+        std::weak_ptr<const LoadedModule> of;
+        torch::jit::Module module;
+    };
+    thread_local std::unordered_map<uint64_t, Replica> replicas; // by LoadedModule::version
+    thread_local uint64_t retirements_seen = 0;
+
+    // Drop the replicas of retired versions as soon as any retires, so they
+    // do not hold an evicted model's tensors until this worker's next clone.
+    const uint64_t retirements = module_retirements.load(std::memory_order_acquire);
+    if (retirements != retirements_seen)
+    {
+        retirements_seen = retirements;
+        for (auto old = replicas.begin(); old != replicas.end();)
+        {
+            std::shared_ptr<const LoadedModule> of = old->second.of.lock();
+            old = !of || of->retired.load() ? replicas.erase(old) : std::next(old);
+        }
+    }
+
+    auto it = replicas.find(loaded.version);
+    if (it == replicas.end())
+    {
+        // Cloning adds methods to the module's compilation unit.
+        static std::mutex clone_mutex;
+        std::lock_guard<std::mutex> lock(clone_mutex);
+        try
+        {
+            it = replicas.emplace(loaded.version, Replica{pinned, loaded.module.clone(/*inplace=*/true)}).first;
+        }
+        catch (const std::exception &e)
+        {
+#ifdef ENABLE_DEBUG_OUTPUT
+            std::fprintf(stderr, "server: module clone failed, using the shared module: %s\n", e.what());
+#endif
+            return loaded.module;
+        }
+    }
+    return it->second.module;
+}
+
+// Pins the newest usable version of `loaded` against release: the one a
+// reload put in its place, or, if it was evicted, a freshly loaded copy.
+// Returns null with the load error in `status` if that load fails.
+static std::shared_ptr<LoadedModule> pin_module(std::shared_ptr<LoadedModule> loaded, int32_t &status)
+{
+    for (;;)
+    {
+        loaded = latest_version(std::move(loaded));
+        loaded->users.fetch_add(1);
+        if (!loaded->retired.load())
+        {
+            loaded->last_used_ns.store(steady_now_ns(), std::memory_order_relaxed);
+            status = 0;
+            return loaded;
+        }
+        unpin_module(loaded.get());
+        if (std::atomic_load(&loaded->replaced_by))
+        {
+            continue;
+        }
+
+        // Evicted: load it again, and lead later holders of `loaded` there.
+        std::shared_ptr<LoadedModule> reloaded;
+        status = try_load_module(loaded->module_filename, loaded->kind, reloaded, loaded->dtype);
+        if (status != 0)
+        {
+            return nullptr;
+        }
+        std::shared_ptr<LoadedModule> expected;
+        std::atomic_compare_exchange_strong(&loaded->replaced_by, &expected, reloaded);
+        loaded = std::move(reloaded);
+    }
+}
+
+// One request's forwards on a cached model, e.g. a block around the handler's
+// run_* calls. The model is pinned for the scope, so neither a reload nor an
+// eviction releases it under a running forward; run on module() (or
+// loaded()->native for a native model), not on the LoadedModule passed in.
+// The forwards run in c10::InferenceMode, so no autograd bookkeeping, unless
+// the model differentiates inside forward or --inference-mode is 0. Their
+// wall time is added to the model's statistics.
+class ModelRunScope
+{
+public:
+    ModelRunScope(const std::shared_ptr<LoadedModule> &loaded, int64_t points)
+        : loaded_(loaded ? pin_module(loaded, status_) : nullptr),
+          points_(points),
+          guard_(loaded_ != nullptr && runs_in_inference_mode(*loaded_)),
+          start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ModelRunScope()
+    {
+        if (!loaded_)
+        {
+            return;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+        loaded_->runs.fetch_add(1, std::memory_order_relaxed);
+        loaded_->points.fetch_add(static_cast<uint64_t>(points_), std::memory_order_relaxed);
+        loaded_->run_ns.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        unpin_module(loaded_.get());
+    }
+
+    ModelRunScope(const ModelRunScope &) = delete;
+    ModelRunScope &operator=(const ModelRunScope &) = delete;
+
+    // 0, or the error of reloading an evicted model.
+    int32_t status() const { return status_; }
+    // The calling thread's module of the pinned version (see module_for_thread).
+    torch::jit::Module &module() const { return module_for_thread(loaded_); }
+    const LoadedModule *loaded() const { return loaded_.get(); }
+
+private:
+    int32_t status_ = 0;
+    std::shared_ptr<LoadedModule> loaded_;
+    int64_t points_;
+    c10::InferenceMode guard_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// defgradF holds doubles or, for dtype kFloat, floats.
+// F_batch_tensor is a per-thread buffer, reused by the next request on the
+// same thread once the model outputs have been copied out.
+static int build_defgrad_batch_tensor(const void *defgradF,
                                       int nblock,
                                       int ndir,
                                       int nshr,
+                                      torch::ScalarType dtype,
                                       torch::Tensor &F_batch_tensor)
 {
     if (!defgradF || nblock <= 0)
@@ -161,31 +903,36 @@ static int build_defgrad_batch_tensor(const double *defgradF,
         return 111;
     }
 
-    auto defgrad_fortran = torch::from_blob((void *)defgradF, {ndefgrad, nblock}, torch::kDouble).t().contiguous();
-    auto options = torch::TensorOptions().dtype(torch::kDouble).device(torch::kCPU);
-    F_batch_tensor = torch::zeros({nblock, 3, 3}, options);
-
-    F_batch_tensor.index_put_({torch::indexing::Slice(), 0, 0}, defgrad_fortran.index({torch::indexing::Slice(), 0}));
-    F_batch_tensor.index_put_({torch::indexing::Slice(), 1, 1}, defgrad_fortran.index({torch::indexing::Slice(), 1}));
-    F_batch_tensor.index_put_({torch::indexing::Slice(), 2, 2}, defgrad_fortran.index({torch::indexing::Slice(), 2}));
-    F_batch_tensor.index_put_({torch::indexing::Slice(), 0, 1}, defgrad_fortran.index({torch::indexing::Slice(), 3}));
-    F_batch_tensor.index_put_({torch::indexing::Slice(), 1, 0}, defgrad_fortran.index({torch::indexing::Slice(), (ndir == 3 && nshr == 3) ? 6 : 4}));
-
-    if (ndir == 3 && nshr == 3)
+    thread_local torch::Tensor defgrad_buffer[2];
+    torch::Tensor &buffer = defgrad_buffer[dtype == torch::kFloat ? 1 : 0];
+    if (!buffer.defined() || buffer.use_count() > 1 || buffer.is_inference() != c10::InferenceMode::is_enabled())
+    {
+        // Still referenced (e.g. kept by the model), or made in the other
+        // inference mode: leave it and start a new one.
+        buffer = torch::empty({nblock, 3, 3}, torch::TensorOptions().dtype(dtype).device(torch::kCPU));
+    }
+    else if (buffer.size(0) != nblock)
     {
-        F_batch_tensor.index_put_({torch::indexing::Slice(), 1, 2}, defgrad_fortran.index({torch::indexing::Slice(), 4}));
-        F_batch_tensor.index_put_({torch::indexing::Slice(), 2, 0}, defgrad_fortran.index({torch::indexing::Slice(), 5}));
-        F_batch_tensor.index_put_({torch::indexing::Slice(), 2, 1}, defgrad_fortran.index({torch::indexing::Slice(), 7}));
-        F_batch_tensor.index_put_({torch::indexing::Slice(), 0, 2}, defgrad_fortran.index({torch::indexing::Slice(), 8}));
+        buffer.resize_({nblock, 3, 3});
     }
 
+    if (dtype == torch::kFloat)
+    {
+        abqnn::server::pack_vumat_defgrad(static_cast<const float *>(defgradF), nblock, ndir, nshr, buffer.data_ptr<float>());
+    }
+    else
+    {
+        abqnn::server::pack_vumat_defgrad(static_cast<const double *>(defgradF), nblock, ndir, nshr, buffer.data_ptr<double>());
+    }
+    F_batch_tensor = buffer;
     return 0;
 }
 
+// On success `cauchy` and `ddsdde` are flat, contiguous CPU double tensors.
 static int decode_umat_results(const torch::jit::IValue &results,
                                double &psi,
-                               std::vector<double> &cauchy,
-                               std::vector<double> &ddsdde)
+                               torch::Tensor &cauchy,
+                               torch::Tensor &ddsdde)
 {
     if (!results.isTuple())
     {
@@ -206,7 +953,7 @@ static int decode_umat_results(const torch::jit::IValue &results,
     }
     else if (psi_result.isTensor())
     {
-        auto psi_tensor = psi_result.toTensor().to(torch::kCPU).to(torch::kDouble);
+        auto psi_tensor = psi_result.toTensor().to(torch::kCPU, torch::kDouble);
         if (psi_tensor.numel() != 1)
         {
             return 111;
@@ -223,29 +970,95 @@ static int decode_umat_results(const torch::jit::IValue &results,
         return 111;
     }
 
-    auto cauchy_tensor = elements[1].toTensor().to(torch::kCPU).to(torch::kDouble).contiguous().reshape({-1});
-    auto ddsdde_tensor = elements[2].toTensor().to(torch::kCPU).to(torch::kDouble).contiguous().reshape({-1});
-    if (cauchy_tensor.numel() <= 0 || ddsdde_tensor.numel() <= 0)
+    // No copy for outputs that are already contiguous CPU doubles; otherwise
+    // one combined device and dtype conversion.
+    cauchy = elements[1].toTensor().to(torch::kCPU, torch::kDouble).contiguous().reshape({-1});
+    ddsdde = elements[2].toTensor().to(torch::kCPU, torch::kDouble).contiguous().reshape({-1});
+    if (cauchy.numel() <= 0 || ddsdde.numel() <= 0)
     {
         return 111;
     }
-
-    cauchy.resize(static_cast<size_t>(cauchy_tensor.numel()));
-    ddsdde.resize(static_cast<size_t>(ddsdde_tensor.numel()));
-    std::memcpy(cauchy.data(), cauchy_tensor.data_ptr<double>(), cauchy.size() * sizeof(double));
-    std::memcpy(ddsdde.data(), ddsdde_tensor.data_ptr<double>(), ddsdde.size() * sizeof(double));
     return 0;
 }
 
-static int decode_vumat_results(const torch::jit::IValue &results,
-                                int nblock,
-                                int nstress,
-                                std::vector<double> &energy,
-                                std::vector<double> &stress)
+// Writes the CPU matrix src[nrows, ncols] (any strides) to `out` in Fortran
+// order, out[j * nrows + i] = src[i][j], converting to Dst on the way. Rows
+// are taken a tile at a time so the tile's source lines stay in cache while
+// each column is written out. `out` may be unaligned.
+template <typename Src, typename Dst>
+static void copy_to_fortran_order(const Src *src, int64_t row_stride, int64_t col_stride,
+                                  int64_t nrows, int64_t ncols, char *out)
 {
-    if (!results.isTuple())
+    constexpr int64_t kTileRows = 64;
+    for (int64_t i0 = 0; i0 < nrows; i0 += kTileRows)
     {
-        return 111;
+        const int64_t i1 = std::min(nrows, i0 + kTileRows);
+        for (int64_t j = 0; j < ncols; ++j)
+        {
+            const Src *col = src + j * col_stride;
+            char *dst = out + static_cast<size_t>(j * nrows + i0) * sizeof(Dst);
+            for (int64_t i = i0; i < i1; ++i, dst += sizeof(Dst))
+            {
+                const Dst v = static_cast<Dst>(col[i * row_stride]);
+                std::memcpy(dst, &v, sizeof(Dst));
+            }
+        }
+    }
+}
+
+// copy_to_fortran_order for a 2-D CPU tensor of any real type, written as
+// `dtype` (kDouble or kFloat). Only types other than double and float are
+// converted by LibTorch first.
+static void copy_tensor_to_fortran_order(torch::Tensor t, torch::ScalarType dtype, char *out)
+{
+    if (t.scalar_type() != torch::kDouble && t.scalar_type() != torch::kFloat)
+    {
+        t = t.to(dtype);
+    }
+
+    const int64_t nrows = t.size(0);
+    const int64_t ncols = t.size(1);
+    const int64_t rs = t.stride(0);
+    const int64_t cs = t.stride(1);
+    if (t.scalar_type() == torch::kDouble)
+    {
+        if (dtype == torch::kFloat)
+        {
+            copy_to_fortran_order<double, float>(t.data_ptr<double>(), rs, cs, nrows, ncols, out);
+        }
+        else
+        {
+            copy_to_fortran_order<double, double>(t.data_ptr<double>(), rs, cs, nrows, ncols, out);
+        }
+    }
+    else
+    {
+        if (dtype == torch::kFloat)
+        {
+            copy_to_fortran_order<float, float>(t.data_ptr<float>(), rs, cs, nrows, ncols, out);
+        }
+        else
+        {
+            copy_to_fortran_order<float, double>(t.data_ptr<float>(), rs, cs, nrows, ncols, out);
+        }
+    }
+}
+
+// Copies energy[nblock] and stress[nstress, nblock] (Fortran order), as
+// `dtype`, to the given locations, which may be unaligned positions in a
+// response payload.
+static int decode_vumat_results(const torch::jit::IValue &results,
+                                int nblock,
+                                int nstress,
+                                torch::ScalarType dtype,
+                                char *energy,
+                                char *stress)
+{
+    const size_t real_size = dtype == torch::kFloat ? sizeof(float) : sizeof(double);
+
+    if (!results.isTuple())
+    {
+        return 111;
     }
 
     auto result_tuple = results.toTuple();
@@ -258,16 +1071,18 @@ static int decode_vumat_results(const torch::jit::IValue &results,
     const auto &energy_ivalue = elements[0];
     if (energy_ivalue.isTensor())
     {
-        auto e = energy_ivalue.toTensor().to(torch::kCPU).to(torch::kDouble).contiguous().reshape({-1});
+        auto e = energy_ivalue.toTensor().to(torch::kCPU);
         if (e.numel() != nblock)
         {
             return 111;
         }
-        std::memcpy(energy.data(), e.data_ptr<double>(), static_cast<size_t>(nblock) * sizeof(double));
+        copy_tensor_to_fortran_order(e.reshape({nblock, 1}), dtype, energy);
     }
     else if (energy_ivalue.isDouble() && nblock == 1)
     {
-        energy[0] = energy_ivalue.toDouble();
+        const double e = energy_ivalue.toDouble();
+        const float e_f32 = static_cast<float>(e);
+        std::memcpy(energy, dtype == torch::kFloat ? static_cast<const void *>(&e_f32) : &e, real_size);
     }
     else
     {
@@ -279,263 +1094,2425 @@ static int decode_vumat_results(const torch::jit::IValue &results,
         return 111;
     }
 
-    auto s = elements[1].toTensor().to(torch::kCPU).to(torch::kDouble).contiguous().reshape({nblock, nstress});
+    // Transposed and converted straight into the response; reshape only
+    // copies when the model output cannot be viewed as [nblock, nstress].
+    auto s = elements[1].toTensor().to(torch::kCPU);
     if (s.numel() != static_cast<int64_t>(nblock) * static_cast<int64_t>(nstress))
     {
         return 111;
     }
 
-    auto s_fortran = s.t().contiguous();
-    std::memcpy(stress.data(), s_fortran.data_ptr<double>(), stress.size() * sizeof(double));
+    copy_tensor_to_fortran_order(s.reshape({nblock, nstress}), dtype, stress);
     return 0;
 }
 
-static int handle_umat_request(const std::vector<char> &req, std::vector<char> &resp)
+// mat_par holds doubles or, for dtype kFloat, floats.
+static torch::Tensor make_mat_par_tensor(const void *mat_par, int32_t n_mat_par, torch::Device device,
+                                         torch::ScalarType dtype = torch::kDouble)
+{
+    torch::Tensor mat_par_tensor = (mat_par && n_mat_par > 0)
+        ? torch::from_blob(const_cast<void *>(mat_par), {n_mat_par}, dtype).contiguous()
+        : torch::empty({0}, dtype);
+    return mat_par_tensor.to(device);
+}
+
+// Forwards run by apply_thread_policy, by the intra-op thread count chosen.
+static std::atomic<uint64_t> single_thread_forwards{0};
+static std::atomic<uint64_t> intra_op_forwards{0};
+
+// Sets the LibTorch intra-op thread count of the calling worker for a forward
+// over `points` material points: one thread below --parallel-min-points,
+// --intra-op-threads (or LibTorch's default) otherwise. The count is only
+// changed when it differs from the thread's previous forward.
+// This needs the OpenMP backend of the stock LibTorch builds: there
+// at::set_num_threads sets the OpenMP and MKL counts of the calling thread,
+// plus a process-wide default that LibTorch applies to each thread on its
+// first parallel region (hence the lazy_init_num_threads call first). The
+// native thread pool takes one count per process and throws on a change once
+// parallel work has started, so with it the count main set is kept.
+static int apply_thread_policy(int64_t points)
+{
+#if AT_PARALLEL_OPENMP
+    thread_local int parallel_threads = 0;
+    thread_local int current_threads = 0;
+    if (current_threads == 0)
+    {
+        at::internal::lazy_init_num_threads();
+        current_threads = at::get_num_threads();
+        parallel_threads = server_options.intra_op_threads > 0 ? static_cast<int>(server_options.intra_op_threads)
+                                                               : current_threads;
+    }
+
+    const bool serial = server_options.parallel_min_points > 0 &&
+                        points < static_cast<int64_t>(server_options.parallel_min_points);
+    const int threads = serial ? 1 : parallel_threads;
+    if (threads != current_threads)
+    {
+        at::set_num_threads(threads);
+        current_threads = threads;
+    }
+#else
+    const int threads = at::get_num_threads();
+#endif
+
+#ifdef ENABLE_DEBUG_OUTPUT
+    std::fprintf(stderr, "server: forward over %lld point(s) on %d intra-op thread(s)\n",
+                 static_cast<long long>(points), threads);
+#endif
+    (threads == 1 ? single_thread_forwards : intra_op_forwards).fetch_add(1, std::memory_order_relaxed);
+    return threads;
+}
+
+// One UMAT forward for a column-major (Fortran) 3x3 F.
+static int run_umat_forward(torch::jit::Module &module,
+                            const double *F,
+                            const torch::Tensor &mat_par_tensor,
+                            double &psi,
+                            torch::Tensor &cauchy,
+                            torch::Tensor &ddsdde)
+{
+    try
+    {
+        torch::Tensor F_tensor = torch::from_blob((void *)F, {3, 3}, torch::kDouble).t().contiguous();
+        F_tensor = F_tensor.to(mat_par_tensor.device());
+
+        apply_thread_policy(1);
+        auto results = module.forward({F_tensor, mat_par_tensor});
+        return decode_umat_results(results, psi, cauchy, ddsdde);
+    }
+    catch (const std::exception &e)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: UMAT inference error: %s\n", e.what());
+#endif
+        return 105;
+    }
+}
+
+// Splits a single-point UMAT request; F and mat_par point into the payload.
+static bool parse_umat_request(abqnn::ipc::PayloadView req,
+                               std::string_view &module_name,
+                               const double *&F,
+                               const double *&mat_par,
+                               int32_t &n_mat_par)
 {
     size_t off = 0;
     uint32_t module_len = 0;
-    int32_t n_mat_par = 0;
 
-    if (!abqnn::ipc::read_scalar(req, off, module_len)) return 123;
-    if (off + module_len > req.size()) return 123;
+    if (!abqnn::ipc::read_scalar(req, off, module_len)) return false;
+    if (off + module_len > req.size) return false;
 
-    std::string module_name(req.data() + off, req.data() + off + module_len);
+    module_name = std::string_view(req.data + off, module_len);
     off += module_len;
 
-    if (!abqnn::ipc::read_scalar(req, off, n_mat_par)) return 123;
-    if (n_mat_par < 0) return 123;
-    if (off + 9 * sizeof(double) + static_cast<size_t>(n_mat_par) * sizeof(double) != req.size()) return 123;
+    if (!abqnn::ipc::read_scalar(req, off, n_mat_par)) return false;
+    if (n_mat_par < 0) return false;
+    if (off + 9 * sizeof(double) + static_cast<size_t>(n_mat_par) * sizeof(double) != req.size) return false;
 
-    const double *F = reinterpret_cast<const double *>(req.data() + off);
+    F = reinterpret_cast<const double *>(req.data + off);
     off += 9 * sizeof(double);
-    const double *mat_par = n_mat_par > 0 ? reinterpret_cast<const double *>(req.data() + off) : nullptr;
-
-    torch::jit::Module *mod_ptr = nullptr;
-    int mod_load_err = try_load_module(module_name.c_str(), RequestKind::UMAT, mod_ptr);
+    mat_par = n_mat_par > 0 ? reinterpret_cast<const double *>(req.data + off) : nullptr;
+    return true;
+}
 
-    int32_t status = mod_load_err;
-    double psi = 0.0;
-    std::vector<double> cauchy;
-    std::vector<double> ddsdde;
+// Order k of a k x k tangent of `ddsdde_n` entries when it may be sent as its
+// upper triangle, otherwise 0 (not asked for, or not square).
+static int32_t packed_ddsdde_order(bool pack, int32_t ddsdde_n)
+{
+    if (!pack)
+    {
+        return 0;
+    }
+    int32_t k = 1;
+    while (k * k < ddsdde_n)
+    {
+        ++k;
+    }
+    return k * k == ddsdde_n ? k : 0;
+}
 
-    if (status == 0)
+#ifdef ENABLE_DEBUG_OUTPUT
+// Checks a tangent declared symmetric before half of it is dropped.
+static bool ddsdde_is_symmetric(const double *ddsdde, int32_t k)
+{
+    double scale = 0.0;
+    double asymmetry = 0.0;
+    for (int32_t i = 0; i < k; ++i)
     {
-        try
+        for (int32_t j = 0; j < k; ++j)
         {
-            torch::Tensor F_tensor = torch::from_blob((void *)F, {3, 3}, torch::kDouble).t().contiguous();
-            torch::Tensor mat_par_tensor = (mat_par && n_mat_par > 0)
-                ? torch::from_blob((void *)mat_par, {n_mat_par}, torch::kDouble).contiguous()
-                : torch::empty({0}, torch::kDouble);
+            scale = std::max(scale, std::abs(ddsdde[i * k + j]));
+            asymmetry = std::max(asymmetry, std::abs(ddsdde[i * k + j] - ddsdde[j * k + i]));
+        }
+    }
+    return asymmetry <= 1e-10 * scale;
+}
+#endif
 
-            auto inference_device = get_inference_device(RequestKind::UMAT);
-            F_tensor = F_tensor.to(inference_device);
-            mat_par_tensor = mat_par_tensor.to(inference_device);
+// Writes a k x k tangent as its upper triangle, row by row.
+static void put_packed_ddsdde(abqnn::ipc::PayloadWriter &out, const double *ddsdde, int32_t k)
+{
+    for (int32_t i = 0; i < k; ++i)
+    {
+        out.put_bytes(ddsdde + i * k + i, static_cast<size_t>(k - i) * sizeof(double));
+    }
+}
 
-            auto results = mod_ptr->forward({F_tensor, mat_par_tensor});
-            status = decode_umat_results(results, psi, cauchy, ddsdde);
-        }
-        catch (const std::exception &e)
-        {
+// `pack` sends a square tangent as its upper triangle; only set it for a
+// request flagged ABQNN_IPC_FLAG_PACKED_DDSDDE to a model declared symmetric.
+static void encode_umat_response(std::vector<char> &resp,
+                                 int32_t status,
+                                 double psi,
+                                 const double *cauchy,
+                                 int32_t cauchy_n,
+                                 const double *ddsdde,
+                                 int32_t ddsdde_n,
+                                 bool pack = false)
+{
+    int32_t k = status == 0 ? packed_ddsdde_order(pack, ddsdde_n) : 0;
 #ifdef ENABLE_DEBUG_OUTPUT
-            std::fprintf(stderr, "server: UMAT inference error: %s\n", e.what());
+    if (k != 0 && !ddsdde_is_symmetric(ddsdde, k))
+    {
+        std::fprintf(stderr, "server: DDSDDE declared symmetric is not, sending it in full\n");
+        k = 0;
+    }
 #endif
-            status = 105;
-        }
+    const int32_t wire_n = k != 0 ? -(k * (k + 1) / 2) : ddsdde_n;
+
+    size_t size = sizeof(status);
+    if (status == 0)
+    {
+        size += sizeof(psi) + sizeof(cauchy_n) + sizeof(wire_n) +
+                (static_cast<size_t>(cauchy_n) + static_cast<size_t>(std::abs(wire_n))) * sizeof(double);
     }
 
-    abqnn::ipc::append_scalar(resp, status);
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(resp, size);
+    out.put(status);
     if (status == 0)
     {
-        int32_t cauchy_n = static_cast<int32_t>(cauchy.size());
-        int32_t ddsdde_n = static_cast<int32_t>(ddsdde.size());
-        abqnn::ipc::append_scalar(resp, psi);
-        abqnn::ipc::append_scalar(resp, cauchy_n);
-        abqnn::ipc::append_scalar(resp, ddsdde_n);
-        abqnn::ipc::append_bytes(resp, cauchy.data(), cauchy.size() * sizeof(double));
-        abqnn::ipc::append_bytes(resp, ddsdde.data(), ddsdde.size() * sizeof(double));
+        out.put(psi);
+        out.put(cauchy_n);
+        out.put(wire_n);
+        out.put_bytes(cauchy, static_cast<size_t>(cauchy_n) * sizeof(double));
+        if (k != 0)
+        {
+            put_packed_ddsdde(out, ddsdde, k);
+        }
+        else
+        {
+            out.put_bytes(ddsdde, static_cast<size_t>(ddsdde_n) * sizeof(double));
+        }
     }
+}
 
-    return 0;
+// With --umat-result-cache, answers a single-point UMAT request from the result
+// of an earlier one on the same model version with bit-identical F and
+// mat_par, without running the model. Returns false on a miss, and for
+// models that opted out.
+static bool serve_memoized_umat(const std::shared_ptr<LoadedModule> &module, const double *F, const double *mat_par,
+                                int32_t n_mat_par, uint32_t request_flags, std::vector<char> &resp)
+{
+    if (!umat_result_cache)
+    {
+        return false;
+    }
+    std::shared_ptr<LoadedModule> loaded = latest_version(module);
+    if (!loaded->memoize)
+    {
+        return false;
+    }
+
+    thread_local abqnn::server::UmatResult result;
+    if (!umat_result_cache->lookup(loaded->version, F, mat_par, n_mat_par, result))
+    {
+        return false;
+    }
+    const bool pack = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && loaded->ddsdde_symmetric;
+    encode_umat_response(resp, 0, result.psi, result.cauchy(), result.cauchy_n, result.ddsdde(), result.ddsdde_n, pack);
+    return true;
 }
 
-static int handle_vumat_request(const std::vector<char> &req, std::vector<char> &resp)
+// Call with `loaded` pinned (inside its ModelRunScope): the results of a
+// version are dropped when it is released.
+static void memoize_umat_result(const LoadedModule *loaded, const double *F, const double *mat_par, int32_t n_mat_par,
+                                double psi, const double *cauchy, int32_t cauchy_n, const double *ddsdde, int32_t ddsdde_n)
 {
-    size_t off = 0;
-    uint32_t module_len = 0;
-    int32_t nblock = 0, ndir = 0, nshr = 0, n_mat_par = 0;
+    if (umat_result_cache && loaded->memoize)
+    {
+        umat_result_cache->insert(loaded->version, F, mat_par, n_mat_par, psi, cauchy, cauchy_n, ddsdde, ddsdde_n);
+    }
+}
 
-    if (!abqnn::ipc::read_scalar(req, off, module_len)) return 123;
-    if (off + module_len > req.size()) return 123;
+// Results of a UMAT batch, one row per point. Handlers keep one per thread so
+// the vectors keep their capacity between batches.
+struct UmatBatchResults
+{
+    std::vector<int32_t> status;
+    std::vector<double> psi;
+    std::vector<double> cauchy;
+    std::vector<double> ddsdde;
+    int32_t cauchy_n = 0;
+    int32_t ddsdde_n = 0;
+};
 
-    std::string module_name(req.data() + off, req.data() + off + module_len);
-    off += module_len;
+// Energy-only model (see LoadedModule::energy_only) on a batch of column-major
+// F. P = dpsi/dF comes from autograd unless forward returns it; d2psi/dF2
+// from nine more backward passes over the whole batch, one per component of
+// P, which requires the points to be independent of each other in forward.
+// umat_from_energy_derivatives then forms every point's Cauchy stress and
+// DDSDDE in one loop. A point with det F <= 0 only fails itself.
+static int run_umat_energy_batch(torch::jit::Module &module,
+                                 const double *F,
+                                 int32_t count,
+                                 const torch::Tensor &mat_par_tensor,
+                                 UmatBatchResults &out)
+{
+    try
+    {
+        torch::Tensor F_batch = torch::from_blob((void *)F, {count, 3, 3}, torch::kDouble).transpose(1, 2).contiguous();
+        F_batch = F_batch.to(mat_par_tensor.device()).requires_grad_(true);
+
+        apply_thread_policy(count);
+        auto results = module.forward({F_batch, mat_par_tensor});
+        torch::Tensor psi;
+        torch::Tensor P;
+        if (results.isTensor())
+        {
+            psi = results.toTensor();
+        }
+        else if (results.isTuple())
+        {
+            const auto &elements = results.toTuple()->elements();
+            if (elements.empty() || elements.size() > 2 || !elements[0].isTensor() ||
+                (elements.size() == 2 && !elements[1].isTensor()))
+            {
+                return 111;
+            }
+            psi = elements[0].toTensor();
+            if (elements.size() == 2)
+            {
+                P = elements[1].toTensor();
+            }
+        }
+        if (!psi.defined())
+        {
+            return 111;
+        }
+        psi = psi.reshape({-1});
+        if (psi.numel() != count || !psi.requires_grad())
+        {
+            return 111;
+        }
 
-    if (!abqnn::ipc::read_scalar(req, off, nblock) || !abqnn::ipc::read_scalar(req, off, ndir) || !abqnn::ipc::read_scalar(req, off, nshr) || !abqnn::ipc::read_scalar(req, off, n_mat_par)) return 123;
-    if (nblock <= 0 || n_mat_par < 0) return 123;
+        if (!P.defined())
+        {
+            P = torch::autograd::grad({psi.sum()}, {F_batch}, {}, /*retain_graph=*/true, /*create_graph=*/true)[0];
+        }
+        if (P.dim() != 3 || P.size(0) != count || P.size(1) != 3 || P.size(2) != 3)
+        {
+            return 111;
+        }
 
-    const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
-    if (off + ndefgrad * sizeof(double) + static_cast<size_t>(n_mat_par) * sizeof(double) != req.size()) return 123;
+        // A[b][iJ][kL] = dP_iJ / dF_kL. Summing over the batch before each
+        // pass keeps every point's derivative in its own row. P of an energy
+        // linear in F does not depend on F at all.
+        torch::Tensor P_flat = P.reshape({count, 9});
+        std::vector<torch::Tensor> rows(9);
+        for (int64_t c = 0; c < 9; ++c)
+        {
+            torch::Tensor row;
+            if (P_flat.requires_grad())
+            {
+                row = torch::autograd::grad({P_flat.select(1, c).sum()}, {F_batch}, {}, /*retain_graph=*/true,
+                                            /*create_graph=*/false, /*allow_unused=*/true)[0];
+            }
+            rows[c] = row.defined() ? row.reshape({count, 9})
+                                    : torch::zeros({count, 9}, torch::dtype(torch::kDouble).device(F_batch.device()));
+        }
+
+        torch::Tensor F_cpu = F_batch.detach().to(torch::kCPU, torch::kDouble).contiguous();
+        torch::Tensor P_cpu = P.detach().to(torch::kCPU, torch::kDouble).contiguous();
+        torch::Tensor A_cpu = torch::stack(rows, 1).to(torch::kCPU, torch::kDouble).contiguous();
+        torch::Tensor psi_cpu = psi.detach().to(torch::kCPU, torch::kDouble).contiguous();
+
+        const size_t n = static_cast<size_t>(count);
+        out.cauchy_n = 6;
+        out.ddsdde_n = 36;
+        out.status.resize(n);
+        out.psi.assign(psi_cpu.data_ptr<double>(), psi_cpu.data_ptr<double>() + n);
+        out.cauchy.resize(n * 6);
+        out.ddsdde.resize(n * 36);
+        abqnn::server::umat_from_energy_derivatives(F_cpu.data_ptr<double>(), P_cpu.data_ptr<double>(),
+                                                    A_cpu.data_ptr<double>(), count, out.status.data(),
+                                                    out.cauchy.data(), out.ddsdde.data());
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: energy-only UMAT error: %s\n", e.what());
+#endif
+        return 105;
+    }
+}
+
+// Serves a single-point UMAT request on an energy-only model.
+static void serve_energy_umat(const ModelRunScope &run, const double *F, const torch::Tensor &mat_par_tensor,
+                              const double *mat_par, int32_t n_mat_par, uint32_t request_flags,
+                              std::vector<char> &resp)
+{
+    thread_local UmatBatchResults results;
+    int32_t status = run_umat_energy_batch(run.module(), F, 1, mat_par_tensor, results);
+    if (status == 0)
+    {
+        status = results.status[0];
+    }
+    if (status != 0)
+    {
+        encode_umat_response(resp, status, 0.0, nullptr, 0, nullptr, 0);
+        return;
+    }
+    memoize_umat_result(run.loaded(), F, mat_par, n_mat_par, results.psi[0], results.cauchy.data(), 6,
+                        results.ddsdde.data(), 36);
+    const bool pack = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && run.loaded()->ddsdde_symmetric;
+    encode_umat_response(resp, 0, results.psi[0], results.cauchy.data(), 6, results.ddsdde.data(), 36, pack);
+}
 
-    const double *defgradF = reinterpret_cast<const double *>(req.data() + off);
-    off += ndefgrad * sizeof(double);
-    const double *mat_par = n_mat_par > 0 ? reinterpret_cast<const double *>(req.data() + off) : nullptr;
+// Serves a single-point UMAT request on a native model: no tensors, one tile.
+static void serve_native_umat(const LoadedModule &loaded, const double *F, const double *mat_par, int32_t n_mat_par,
+                              uint32_t request_flags, std::vector<char> &resp)
+{
+    double psi = 0.0;
+    double cauchy[6];
+    double ddsdde[36];
+    int32_t point_status = 0;
+    int32_t status = loaded.native->umat(F, 1, mat_par, n_mat_par, &point_status, &psi, cauchy, ddsdde);
+    if (status == 0)
+    {
+        status = point_status;
+    }
+    if (status == 0)
+    {
+        memoize_umat_result(&loaded, F, mat_par, n_mat_par, psi, cauchy, 6, ddsdde, 36);
+    }
+    const bool pack = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && loaded.ddsdde_symmetric;
+    encode_umat_response(resp, status, psi, cauchy, 6, ddsdde, 36, pack);
+}
+
+// Encodes the outcome of run_umat_forward; the tensors are only read on success.
+static void encode_umat_result(std::vector<char> &resp,
+                               int32_t status,
+                               double psi,
+                               const torch::Tensor &cauchy,
+                               const torch::Tensor &ddsdde,
+                               bool pack)
+{
+    if (status != 0)
+    {
+        encode_umat_response(resp, status, 0.0, nullptr, 0, nullptr, 0);
+        return;
+    }
+    encode_umat_response(resp, status, psi,
+                         cauchy.data_ptr<double>(), static_cast<int32_t>(cauchy.numel()),
+                         ddsdde.data_ptr<double>(), static_cast<int32_t>(ddsdde.numel()), pack);
+}
+
+static int handle_umat_request(abqnn::ipc::PayloadView req, std::vector<char> &resp, uint32_t request_flags)
+{
+    std::string_view module_name;
+    const double *F = nullptr;
+    const double *mat_par = nullptr;
+    int32_t n_mat_par = 0;
+    if (!parse_umat_request(req, module_name, F, mat_par, n_mat_par)) return 123;
 
-    torch::jit::Module *mod_ptr = nullptr;
-    int mod_load_err = try_load_module(module_name.c_str(), RequestKind::VUMAT, mod_ptr);
+    std::shared_ptr<LoadedModule> mod_ptr;
+    int mod_load_err = try_load_module(module_name, RequestKind::UMAT, mod_ptr);
+    if (mod_load_err == 0 && serve_memoized_umat(mod_ptr, F, mat_par, n_mat_par, request_flags, resp))
+    {
+        return 0;
+    }
 
     int32_t status = mod_load_err;
-    const int nstress = ndir + nshr;
-    std::vector<double> energy(static_cast<size_t>(nblock), 0.0);
-    std::vector<double> stress(static_cast<size_t>(nblock) * static_cast<size_t>(nstress), 0.0);
+    bool ddsdde_symmetric = false;
+    double psi = 0.0;
+    torch::Tensor cauchy;
+    torch::Tensor ddsdde;
 
     if (status == 0)
     {
         try
         {
-            torch::Tensor F_batch_tensor;
-            status = build_defgrad_batch_tensor(defgradF, nblock, ndir, nshr, F_batch_tensor);
-
+            ModelRunScope run(mod_ptr, 1);
+            status = run.status();
+            if (status == 0 && run.loaded()->native)
+            {
+                serve_native_umat(*run.loaded(), F, mat_par, n_mat_par, request_flags, resp);
+                return 0;
+            }
             if (status == 0)
             {
-                torch::Tensor mat_par_tensor = (mat_par && n_mat_par > 0)
-                    ? torch::from_blob((void *)mat_par, {n_mat_par}, torch::kDouble).contiguous()
-                    : torch::empty({0}, torch::kDouble);
-
-                auto inference_device = get_inference_device(RequestKind::VUMAT);
-                F_batch_tensor = F_batch_tensor.to(inference_device);
-                mat_par_tensor = mat_par_tensor.to(inference_device);
-
-                auto results = mod_ptr->forward({F_batch_tensor, mat_par_tensor});
-                status = decode_vumat_results(results, nblock, nstress, energy, stress);
+                torch::Tensor mat_par_tensor = make_mat_par_tensor(mat_par, n_mat_par, get_inference_device(RequestKind::UMAT));
+                if (run.loaded()->energy_only)
+                {
+                    serve_energy_umat(run, F, mat_par_tensor, mat_par, n_mat_par, request_flags, resp);
+                    return 0;
+                }
+                ddsdde_symmetric = run.loaded()->ddsdde_symmetric;
+                status = run_umat_forward(run.module(), F, mat_par_tensor, psi, cauchy, ddsdde);
+            }
+            if (status == 0)
+            {
+                memoize_umat_result(run.loaded(), F, mat_par, n_mat_par, psi,
+                                    cauchy.data_ptr<double>(), static_cast<int32_t>(cauchy.numel()),
+                                    ddsdde.data_ptr<double>(), static_cast<int32_t>(ddsdde.numel()));
             }
         }
         catch (const std::exception &e)
         {
 #ifdef ENABLE_DEBUG_OUTPUT
-            std::fprintf(stderr, "server: VUMAT inference error: %s\n", e.what());
+            std::fprintf(stderr, "server: UMAT inference error: %s\n", e.what());
 #endif
             status = 105;
         }
     }
 
-    abqnn::ipc::append_scalar(resp, status);
-    if (status == 0)
-    {
-        abqnn::ipc::append_scalar(resp, nblock);
-        abqnn::ipc::append_scalar(resp, ndir);
-        abqnn::ipc::append_scalar(resp, nshr);
-        abqnn::ipc::append_bytes(resp, energy.data(), energy.size() * sizeof(double));
-        abqnn::ipc::append_bytes(resp, stress.data(), stress.size() * sizeof(double));
-    }
-
+    const bool pack = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && status == 0 && ddsdde_symmetric;
+    encode_umat_result(resp, status, psi, cauchy, ddsdde, pack);
     return 0;
 }
 
-static int handle_client(HANDLE pipe)
+// Models registered with ABQNN_MSG_REGISTER_REQ. A handle is an index into
+// registered_models; entries are published once and never go away, so handle
+// requests look them up without taking a lock. Only `module` changes, see
+// registered_version.
+struct RegisteredModel
 {
-    AbqnnIpcHeader req_hdr{};
-    if (!abqnn::ipc::read_all(pipe, &req_hdr, sizeof(req_hdr)))
+    RequestKind kind = RequestKind::UMAT;
+    // A version of the model, read and written with std::atomic_load/atomic_store.
+    mutable std::shared_ptr<LoadedModule> module;
+    std::vector<double> mat_par;
+    torch::Tensor mat_par_tensor; // on the inference device
+    std::string batch_key;        // module cache key, as defer_umat_request uses it
+};
+
+static constexpr int32_t kMaxRegisteredModels = 4096;
+static std::unique_ptr<RegisteredModel> registered_models[kMaxRegisteredModels];
+static std::atomic<int32_t> registered_model_count{0};
+// Serializes registrations and maps "cache key\0mat_par bytes" to its handle,
+// so a model registered by many clients (or threads) takes a single entry.
+static std::mutex registration_mutex;
+static std::map<std::string, int32_t> registration_index;
+// Set once at startup. Clients send it back with every handle, so a handle
+// issued by an earlier server process is refused rather than misread.
+static uint32_t registry_epoch = 1;
+
+static const RegisteredModel *find_registered_model(int32_t handle, uint32_t epoch, RequestKind kind)
+{
+    if (epoch != registry_epoch || handle < 0 || handle >= registered_model_count.load(std::memory_order_acquire))
     {
-        return 1;
+        return nullptr;
     }
+    const RegisteredModel *model = registered_models[handle].get();
+    return model->kind == kind ? model : nullptr;
+}
 
-    if (req_hdr.magic != ABQNN_IPC_MAGIC ||
-        req_hdr.version != ABQNN_IPC_VERSION ||
-        req_hdr.payload_size > ABQNN_IPC_MAX_PAYLOAD)
+// The newest version of a registered model. The handle is moved on to it, so
+// each reload or eviction adds at most one step to the next request's walk,
+// and the versions it passed are freed once nothing else holds them.
+static std::shared_ptr<LoadedModule> registered_version(const RegisteredModel &model)
+{
+    std::shared_ptr<LoadedModule> registered = std::atomic_load(&model.module);
+    std::shared_ptr<LoadedModule> latest = latest_version(registered);
+    if (latest != registered)
     {
-        return 1;
+        // Another request may have moved it on already; either is current.
+        std::atomic_compare_exchange_strong(&model.module, &registered, latest);
     }
+    return latest;
+}
 
-    std::vector<char> req(req_hdr.payload_size);
-    if (req_hdr.payload_size > 0 && !abqnn::ipc::read_all(pipe, req.data(), req.size()))
+static int register_model(RequestKind kind, std::string_view module_name,
+                          const double *mat_par, int32_t n_mat_par, int32_t &handle)
+{
+    std::shared_ptr<LoadedModule> module;
+    int status = try_load_module(module_name, kind, module);
+    if (status != 0)
     {
-        return 1;
+        return status;
     }
 
-    std::vector<char> resp;
-    uint32_t resp_type = 0;
+    std::string key;
+    module_cache_key_for(module_name, kind, key);
+    const size_t module_key_len = key.size();
+    key.push_back('\0');
+    key.append(reinterpret_cast<const char *>(mat_par), static_cast<size_t>(n_mat_par) * sizeof(double));
 
-    switch (req_hdr.message_type)
+    std::lock_guard<std::mutex> lock(registration_mutex);
+    auto it = registration_index.find(key);
+    if (it != registration_index.end())
     {
-    case ABQNN_MSG_UMAT_REQ:
-        resp_type = ABQNN_MSG_UMAT_RESP;
-        handle_umat_request(req, resp);
-        break;
-    case ABQNN_MSG_VUMAT_REQ:
-        resp_type = ABQNN_MSG_VUMAT_RESP;
-        handle_vumat_request(req, resp);
-        break;
-    default:
-        return 1;
+        handle = it->second;
+        return 0;
     }
 
-    AbqnnIpcHeader resp_hdr{};
-    resp_hdr.magic = ABQNN_IPC_MAGIC;
-    resp_hdr.version = ABQNN_IPC_VERSION;
-    resp_hdr.message_type = resp_type;
-    resp_hdr.payload_size = static_cast<uint32_t>(resp.size());
+    const int32_t count = registered_model_count.load(std::memory_order_relaxed);
+    if (count >= kMaxRegisteredModels)
+    {
+        return 102;
+    }
 
-    if (!abqnn::ipc::write_all(pipe, &resp_hdr, sizeof(resp_hdr)) ||
-        (!resp.empty() && !abqnn::ipc::write_all(pipe, resp.data(), resp.size())))
+    auto model = std::make_unique<RegisteredModel>();
+    model->kind = kind;
+    model->module = module;
+    model->mat_par.assign(mat_par, mat_par + n_mat_par);
+    model->batch_key = key.substr(0, module_key_len);
+    try
+    {
+        model->mat_par_tensor = make_mat_par_tensor(model->mat_par.data(), n_mat_par, get_inference_device(kind));
+    }
+    catch (const std::exception &e)
     {
-        return 1;
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: model registration failed: %s\n", e.what());
+#endif
+        return 105;
     }
 
+    registered_models[count] = std::move(model);
+    registered_model_count.store(count + 1, std::memory_order_release);
+    registration_index.emplace(std::move(key), count);
+    handle = count;
     return 0;
 }
 
-int main()
+static int handle_register_request(abqnn::ipc::PayloadView req, std::vector<char> &resp)
 {
-#ifdef ENABLE_DEBUG_OUTPUT
-    std::filesystem::create_directories(ABQNN_LOG_PATH);
-    auto log_file = (std::filesystem::path(ABQNN_LOG_PATH) / "ipc_server_err.txt").string();
-    std::freopen(log_file.c_str(), "a", stderr);
-    std::fprintf(stderr, "ABQnn IPC server starting...\n");
-    std::fprintf(stderr, "ABQnn UMAT device: %s\n", ABQNN_UMAT_TORCH_DEVICE);
-    std::fprintf(stderr, "ABQnn VUMAT device: %s\n", ABQNN_VUMAT_TORCH_DEVICE);
-#endif
+    size_t off = 0;
+    int32_t kind = 0;
+    uint32_t module_len = 0;
+    int32_t n_mat_par = 0;
 
-    int device_err = validate_inference_devices();
-    if (device_err != 0)
-    {
-        return device_err;
-    }
+    if (!abqnn::ipc::read_scalar(req, off, kind) || !abqnn::ipc::read_scalar(req, off, module_len)) return 123;
+    if ((kind != 0 && kind != 1) || off + module_len > req.size) return 123;
 
-    auto serve_client = [](HANDLE pipe)
-    {
-        handle_client(pipe);
-        FlushFileBuffers(pipe);
-        DisconnectNamedPipe(pipe);
-        CloseHandle(pipe);
-    };
+    std::string_view module_name(req.data + off, module_len);
+    off += module_len;
 
-    while (true)
-    {
-        HANDLE pipe = CreateNamedPipeA(
-            ABQNN_DEFAULT_PIPE_NAME,
-            PIPE_ACCESS_DUPLEX,
-            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
-            PIPE_UNLIMITED_INSTANCES,
-            ABQNN_IPC_MAX_PAYLOAD,
-            ABQNN_IPC_MAX_PAYLOAD,
-            0,
-            NULL);
+    if (!abqnn::ipc::read_scalar(req, off, n_mat_par)) return 123;
+    if (n_mat_par < 0 || off + static_cast<size_t>(n_mat_par) * sizeof(double) != req.size) return 123;
+
+    // mat_par is copied out of the payload, which may sit at any alignment.
+    thread_local std::vector<double> mat_par;
+    mat_par.resize(static_cast<size_t>(n_mat_par));
+    std::memcpy(mat_par.data(), req.data + off, mat_par.size() * sizeof(double));
+
+    int32_t handle = -1;
+    int32_t status = register_model(kind == 0 ? RequestKind::UMAT : RequestKind::VUMAT,
+                                    module_name, mat_par.data(), n_mat_par, handle);
+
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(
+        resp, sizeof(status) + (status == 0 ? sizeof(handle) + sizeof(registry_epoch) : 0));
+    out.put(status);
+    if (status == 0)
+    {
+        out.put(handle);
+        out.put(registry_epoch);
+    }
+    return 0;
+}
+
+// Splits a UMAT handle request. Returns 123 for a malformed payload and 113
+// for a handle this server did not issue.
+static int parse_umat_handle_request(abqnn::ipc::PayloadView req, const RegisteredModel *&model, const double *&F)
+{
+    size_t off = 0;
+    int32_t handle = -1;
+    uint32_t epoch = 0;
+
+    if (!abqnn::ipc::read_scalar(req, off, handle) || !abqnn::ipc::read_scalar(req, off, epoch)) return 123;
+    if (off + 9 * sizeof(double) != req.size) return 123;
+
+    F = reinterpret_cast<const double *>(req.data + off);
+    model = find_registered_model(handle, epoch, RequestKind::UMAT);
+    return model ? 0 : 113;
+}
+
+static int handle_umat_handle_request(abqnn::ipc::PayloadView req, std::vector<char> &resp, uint32_t request_flags)
+{
+    const RegisteredModel *model = nullptr;
+    const double *F = nullptr;
+    int32_t status = parse_umat_handle_request(req, model, F);
+    if (status == 123) return 123;
+    std::shared_ptr<LoadedModule> module;
+    if (status == 0)
+    {
+        module = registered_version(*model);
+    }
+    if (status == 0 && serve_memoized_umat(module, F, model->mat_par.data(),
+                                           static_cast<int32_t>(model->mat_par.size()), request_flags, resp))
+    {
+        return 0;
+    }
+
+    bool ddsdde_symmetric = false;
+    double psi = 0.0;
+    torch::Tensor cauchy;
+    torch::Tensor ddsdde;
+    if (status == 0)
+    {
+        ModelRunScope run(module, 1);
+        status = run.status();
+        if (status == 0 && run.loaded()->native)
+        {
+            serve_native_umat(*run.loaded(), F, model->mat_par.data(), static_cast<int32_t>(model->mat_par.size()),
+                              request_flags, resp);
+            return 0;
+        }
+        if (status == 0 && run.loaded()->energy_only)
+        {
+            serve_energy_umat(run, F, model->mat_par_tensor, model->mat_par.data(),
+                              static_cast<int32_t>(model->mat_par.size()), request_flags, resp);
+            return 0;
+        }
+        if (status == 0)
+        {
+            ddsdde_symmetric = run.loaded()->ddsdde_symmetric;
+            status = run_umat_forward(run.module(), F, model->mat_par_tensor, psi, cauchy, ddsdde);
+        }
+        if (status == 0)
+        {
+            memoize_umat_result(run.loaded(), F, model->mat_par.data(), static_cast<int32_t>(model->mat_par.size()), psi,
+                                cauchy.data_ptr<double>(), static_cast<int32_t>(cauchy.numel()),
+                                ddsdde.data_ptr<double>(), static_cast<int32_t>(ddsdde.numel()));
+        }
+    }
+
+    const bool pack = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && status == 0 && ddsdde_symmetric;
+    encode_umat_result(resp, status, psi, cauchy, ddsdde, pack);
+    return 0;
+}
+
+static int decode_umat_batch_results(const torch::jit::IValue &results, int32_t count, UmatBatchResults &out)
+{
+    if (!results.isTuple())
+    {
+        return 111;
+    }
+
+    const auto &elements = results.toTuple()->elements();
+    if (elements.size() < 3 || !elements[0].isTensor() || !elements[1].isTensor() || !elements[2].isTensor())
+    {
+        return 111;
+    }
+
+    auto psi_tensor = elements[0].toTensor().to(torch::kCPU, torch::kDouble).contiguous().reshape({-1});
+    auto cauchy_tensor = elements[1].toTensor().to(torch::kCPU, torch::kDouble).contiguous().reshape({-1});
+    auto ddsdde_tensor = elements[2].toTensor().to(torch::kCPU, torch::kDouble).contiguous().reshape({-1});
+    if (psi_tensor.numel() != count ||
+        cauchy_tensor.numel() <= 0 || cauchy_tensor.numel() % count != 0 ||
+        ddsdde_tensor.numel() <= 0 || ddsdde_tensor.numel() % count != 0)
+    {
+        return 111;
+    }
+
+    out.cauchy_n = static_cast<int32_t>(cauchy_tensor.numel() / count);
+    out.ddsdde_n = static_cast<int32_t>(ddsdde_tensor.numel() / count);
+    out.psi.assign(psi_tensor.data_ptr<double>(), psi_tensor.data_ptr<double>() + count);
+    out.cauchy.assign(cauchy_tensor.data_ptr<double>(), cauchy_tensor.data_ptr<double>() + cauchy_tensor.numel());
+    out.ddsdde.assign(ddsdde_tensor.data_ptr<double>(), ddsdde_tensor.data_ptr<double>() + ddsdde_tensor.numel());
+    out.status.assign(static_cast<size_t>(count), 0);
+    return 0;
+}
+
+// Runs the batch through the model's optional forward_batch method,
+// forward_batch(F[count, 3, 3], mat_par) -> (psi[count], Cauchy[count, ...],
+// DDSDDE[count, ...]). Returns non-zero if the model has none or it failed.
+static int run_umat_forward_batch(torch::jit::Module &module,
+                                  const double *F,
+                                  int32_t count,
+                                  const torch::Tensor &mat_par_tensor,
+                                  UmatBatchResults &out)
+{
+    auto method = module.find_method("forward_batch");
+    if (!method)
+    {
+        return 111;
+    }
+
+    try
+    {
+        torch::Tensor F_batch = torch::from_blob((void *)F, {count, 3, 3}, torch::kDouble).transpose(1, 2).contiguous();
+        F_batch = F_batch.to(mat_par_tensor.device());
+
+        apply_thread_policy(count);
+        auto results = (*method)({F_batch, mat_par_tensor});
+        return decode_umat_batch_results(results, count, out);
+    }
+    catch (const std::exception &e)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: UMAT forward_batch error, evaluating points one by one: %s\n", e.what());
+#endif
+        return 105;
+    }
+}
+
+// Fallback for models without forward_batch: one forward per point, still in
+// one request and one pool task. A failing point only fails itself.
+static void run_umat_forward_each(torch::jit::Module &module,
+                                  const double *F,
+                                  int32_t count,
+                                  const torch::Tensor &mat_par_tensor,
+                                  UmatBatchResults &out)
+{
+    out.cauchy_n = 0;
+    out.ddsdde_n = 0;
+    out.status.assign(static_cast<size_t>(count), 0);
+    out.psi.assign(static_cast<size_t>(count), 0.0);
+
+    torch::Tensor cauchy;
+    torch::Tensor ddsdde;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        int status = run_umat_forward(module, F + 9 * static_cast<size_t>(i), mat_par_tensor, out.psi[i], cauchy, ddsdde);
+        if (status == 0 && out.cauchy_n == 0)
+        {
+            out.cauchy_n = static_cast<int32_t>(cauchy.numel());
+            out.ddsdde_n = static_cast<int32_t>(ddsdde.numel());
+            out.cauchy.assign(static_cast<size_t>(count) * out.cauchy_n, 0.0);
+            out.ddsdde.assign(static_cast<size_t>(count) * out.ddsdde_n, 0.0);
+        }
+        if (status == 0 && (cauchy.numel() != out.cauchy_n || ddsdde.numel() != out.ddsdde_n))
+        {
+            status = 111;
+        }
+
+        out.status[i] = status;
+        if (status == 0)
+        {
+            std::memcpy(&out.cauchy[static_cast<size_t>(i) * out.cauchy_n], cauchy.data_ptr<double>(), out.cauchy_n * sizeof(double));
+            std::memcpy(&out.ddsdde[static_cast<size_t>(i) * out.ddsdde_n], ddsdde.data_ptr<double>(), out.ddsdde_n * sizeof(double));
+        }
+    }
+}
+
+// The whole batch on a native model, in tiles of points. A point with
+// det F <= 0 only fails itself.
+static int run_native_umat_batch(const LoadedModule &loaded,
+                                 const double *F,
+                                 int32_t count,
+                                 const double *mat_par,
+                                 int32_t n_mat_par,
+                                 UmatBatchResults &out)
+{
+    const size_t n = static_cast<size_t>(count);
+    out.cauchy_n = 6;
+    out.ddsdde_n = 36;
+    out.status.resize(n);
+    out.psi.resize(n);
+    out.cauchy.resize(n * 6);
+    out.ddsdde.resize(n * 36);
+    return loaded.native->umat(F, count, mat_par, n_mat_par, out.status.data(), out.psi.data(), out.cauchy.data(),
+                               out.ddsdde.data());
+}
+
+static int handle_umat_batch_request(abqnn::ipc::PayloadView req, std::vector<char> &resp, uint32_t request_flags)
+{
+    size_t off = 0;
+    uint32_t module_len = 0;
+    int32_t n_mat_par = 0;
+    int32_t count = 0;
+
+    if (!abqnn::ipc::read_scalar(req, off, module_len)) return 123;
+    if (off + module_len > req.size) return 123;
 
-        if (pipe == INVALID_HANDLE_VALUE)
+    std::string_view module_name(req.data + off, module_len);
+    off += module_len;
+
+    if (!abqnn::ipc::read_scalar(req, off, n_mat_par) || !abqnn::ipc::read_scalar(req, off, count)) return 123;
+    if (n_mat_par < 0 || count <= 0) return 123;
+    if (off + static_cast<size_t>(n_mat_par) * sizeof(double) + static_cast<size_t>(count) * 9 * sizeof(double) != req.size) return 123;
+
+    const double *mat_par = n_mat_par > 0 ? reinterpret_cast<const double *>(req.data + off) : nullptr;
+    off += static_cast<size_t>(n_mat_par) * sizeof(double);
+    const double *F = reinterpret_cast<const double *>(req.data + off);
+
+    std::shared_ptr<LoadedModule> mod_ptr;
+    int32_t status = try_load_module(module_name, RequestKind::UMAT, mod_ptr);
+
+    thread_local UmatBatchResults results;
+    bool ddsdde_symmetric = false;
+    if (status == 0)
+    {
+        try
+        {
+            ModelRunScope run(mod_ptr, count);
+            status = run.status();
+            ddsdde_symmetric = status == 0 && run.loaded()->ddsdde_symmetric;
+            if (status == 0 && run.loaded()->native)
+            {
+                status = run_native_umat_batch(*run.loaded(), F, count, mat_par, n_mat_par, results);
+            }
+            else
+            {
+                torch::Tensor mat_par_tensor = make_mat_par_tensor(mat_par, n_mat_par, get_inference_device(RequestKind::UMAT));
+                if (status == 0 && run.loaded()->energy_only)
+                {
+                    status = run_umat_energy_batch(run.module(), F, count, mat_par_tensor, results);
+                }
+                else if (status == 0 && run_umat_forward_batch(run.module(), F, count, mat_par_tensor, results) != 0)
+                {
+                    run_umat_forward_each(run.module(), F, count, mat_par_tensor, results);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+#ifdef ENABLE_DEBUG_OUTPUT
+            std::fprintf(stderr, "server: UMAT batch inference error: %s\n", e.what());
+#endif
+            status = 105;
+        }
+    }
+
+    const size_t n = static_cast<size_t>(count);
+    // Every row goes out packed or none does, since they share ddsdde_n.
+    int32_t k = 0;
+    if (status == 0)
+    {
+        k = packed_ddsdde_order((request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0 && ddsdde_symmetric,
+                                results.ddsdde_n);
+#ifdef ENABLE_DEBUG_OUTPUT
+        for (size_t i = 0; k != 0 && i < n; ++i)
         {
-            return 2;
+            if (!ddsdde_is_symmetric(&results.ddsdde[i * results.ddsdde_n], k))
+            {
+                std::fprintf(stderr, "server: DDSDDE declared symmetric is not, sending the batch in full\n");
+                k = 0;
+            }
         }
+#endif
+    }
+    const int32_t ddsdde_wire_n = k != 0 ? -(k * (k + 1) / 2) : results.ddsdde_n;
+
+    size_t size = sizeof(status);
+    if (status == 0)
+    {
+        size += 3 * sizeof(int32_t) + n * sizeof(int32_t) +
+                n * (1 + static_cast<size_t>(results.cauchy_n) + static_cast<size_t>(std::abs(ddsdde_wire_n))) * sizeof(double);
+    }
 
-        BOOL connected = ConnectNamedPipe(pipe, NULL) ? TRUE : (GetLastError() == ERROR_PIPE_CONNECTED);
-        if (connected)
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(resp, size);
+    out.put(status);
+    if (status == 0)
+    {
+        out.put(count);
+        out.put(results.cauchy_n);
+        out.put(ddsdde_wire_n);
+        out.put_bytes(results.status.data(), n * sizeof(int32_t));
+        out.put_bytes(results.psi.data(), n * sizeof(double));
+        out.put_bytes(results.cauchy.data(), n * results.cauchy_n * sizeof(double));
+        if (k != 0)
         {
-            std::thread(serve_client, pipe).detach();
+            for (size_t i = 0; i < n; ++i)
+            {
+                put_packed_ddsdde(out, &results.ddsdde[i * results.ddsdde_n], k);
+            }
         }
         else
         {
-            CloseHandle(pipe);
+            out.put_bytes(results.ddsdde.data(), n * results.ddsdde_n * sizeof(double));
         }
     }
 
     return 0;
 }
+
+// A single-point UMAT request parked in the dynamic batcher. F and mat_par
+// point into the request payload, which the owner keeps alive until
+// finish(owner) has been called with the response encoded into *resp.
+struct PendingUmat
+{
+    // Dropped before finish(owner), so a recycled request holds no version.
+    std::shared_ptr<LoadedModule> module;
+    const double *F = nullptr;
+    const double *mat_par = nullptr;
+    int32_t n_mat_par = 0;
+    // Prebuilt mat_par tensor of a registered model; null for named requests.
+    const torch::Tensor *mat_par_tensor = nullptr;
+    // The client accepts DDSDDE packed; it is sent packed if the version the
+    // batch runs on is symmetric.
+    bool pack_ddsdde = false;
+    std::vector<char> *resp = nullptr;
+    void (*finish)(void *owner) = nullptr;
+    void *owner = nullptr;
+};
+
+static bool same_mat_par(const PendingUmat &a, const PendingUmat &b)
+{
+    return a.n_mat_par == b.n_mat_par &&
+           (a.n_mat_par == 0 || std::memcmp(a.mat_par, b.mat_par, static_cast<size_t>(a.n_mat_par) * sizeof(double)) == 0);
+}
+
+// Runs `count` requests that share one module and mat_par as one batch.
+static void run_umat_group(void *const *items, size_t count)
+{
+    const PendingUmat &first = *static_cast<PendingUmat *>(items[0]);
+    const int32_t n = static_cast<int32_t>(count);
+
+    thread_local std::vector<double> F_batch;
+    F_batch.resize(count * 9);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(&F_batch[i * 9], static_cast<PendingUmat *>(items[i])->F, 9 * sizeof(double));
+    }
+
+    int32_t status = 0;
+    bool ddsdde_symmetric = false;
+    thread_local UmatBatchResults results;
+    try
+    {
+        ModelRunScope run(first.module, n);
+        status = run.status();
+        const LoadedModule *ran = run.loaded();
+        ddsdde_symmetric = status == 0 && ran->ddsdde_symmetric;
+        if (status == 0 && ran->native)
+        {
+            status = run_native_umat_batch(*ran, F_batch.data(), n, first.mat_par, first.n_mat_par, results);
+        }
+        else
+        {
+            torch::Tensor mat_par_tensor = first.mat_par_tensor
+                ? *first.mat_par_tensor
+                : make_mat_par_tensor(first.mat_par, first.n_mat_par, get_inference_device(RequestKind::UMAT));
+            if (status == 0 && ran->energy_only)
+            {
+                status = run_umat_energy_batch(run.module(), F_batch.data(), n, mat_par_tensor, results);
+            }
+            else if (status == 0 &&
+                     (count == 1 || run_umat_forward_batch(run.module(), F_batch.data(), n, mat_par_tensor, results) != 0))
+            {
+                run_umat_forward_each(run.module(), F_batch.data(), n, mat_par_tensor, results);
+            }
+        }
+
+        for (size_t i = 0; status == 0 && i < count; ++i)
+        {
+            const PendingUmat &item = *static_cast<PendingUmat *>(items[i]);
+            if (results.status[i] == 0)
+            {
+                memoize_umat_result(ran, item.F, item.mat_par, item.n_mat_par, results.psi[i],
+                                    &results.cauchy[i * results.cauchy_n], results.cauchy_n,
+                                    &results.ddsdde[i * results.ddsdde_n], results.ddsdde_n);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: UMAT batch inference error: %s\n", e.what());
+#endif
+        status = 105;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // finish() may release the item, so read it first.
+        PendingUmat &item = *static_cast<PendingUmat *>(items[i]);
+        const int32_t item_status = status != 0 ? status : results.status[i];
+        encode_umat_response(*item.resp, item_status,
+                             item_status == 0 ? results.psi[i] : 0.0,
+                             item_status == 0 ? &results.cauchy[i * results.cauchy_n] : nullptr, results.cauchy_n,
+                             item_status == 0 ? &results.ddsdde[i * results.ddsdde_n] : nullptr, results.ddsdde_n,
+                             item.pack_ddsdde && ddsdde_symmetric);
+        item.module.reset();
+        item.finish(item.owner);
+    }
+}
+
+// Batcher callback. All items share a model; requests with different mat_par
+// go through separate forwards, since forward_batch takes one mat_par.
+static void run_umat_batch(std::vector<void *> &items)
+{
+    auto begin = items.begin();
+    while (begin != items.end())
+    {
+        const PendingUmat &head = *static_cast<PendingUmat *>(*begin);
+        auto end = std::partition(begin, items.end(), [&](void *item) {
+            return same_mat_par(head, *static_cast<PendingUmat *>(item));
+        });
+        run_umat_group(&*begin, static_cast<size_t>(end - begin));
+        begin = end;
+    }
+}
+
+// Hands a UMAT request (named or by handle) to the dynamic batcher.
+// pending.finish and pending.owner must be set; they are called once the
+// response is in `resp`, possibly before this returns. Returns false when the
+// request is not batched, and the caller serves it directly.
+static bool defer_umat_request(uint32_t message_type, uint32_t request_flags, abqnn::ipc::PayloadView req,
+                               std::vector<char> &resp, PendingUmat &pending)
+{
+    if (!umat_batcher)
+    {
+        return false;
+    }
+
+    // Malformed requests, load errors and unknown handles are answered by the
+    // regular handlers.
+    thread_local std::string batch_key;
+    if (message_type == ABQNN_MSG_UMAT_HANDLE_REQ)
+    {
+        const RegisteredModel *model = nullptr;
+        if (parse_umat_handle_request(req, model, pending.F) != 0)
+        {
+            return false;
+        }
+        pending.module = registered_version(*model);
+        pending.mat_par = model->mat_par.data();
+        pending.n_mat_par = static_cast<int32_t>(model->mat_par.size());
+        pending.mat_par_tensor = &model->mat_par_tensor;
+        batch_key = model->batch_key;
+    }
+    else
+    {
+        std::string_view module_name;
+        if (!parse_umat_request(req, module_name, pending.F, pending.mat_par, pending.n_mat_par) ||
+            try_load_module(module_name, RequestKind::UMAT, pending.module) != 0)
+        {
+            return false;
+        }
+        pending.mat_par_tensor = nullptr;
+        module_cache_key_for(module_name, RequestKind::UMAT, batch_key);
+    }
+
+    // A memoized result needs no batch.
+    if (serve_memoized_umat(pending.module, pending.F, pending.mat_par, pending.n_mat_par, request_flags, resp))
+    {
+        pending.module.reset();
+        pending.finish(pending.owner);
+        return true;
+    }
+
+    pending.pack_ddsdde = (request_flags & ABQNN_IPC_FLAG_PACKED_DDSDDE) != 0;
+    pending.resp = &resp;
+    umat_batcher->add(batch_key, &pending);
+    return true;
+}
+
+// One VUMAT block on a native model, written straight into the response's
+// energy and stress arrays. Runs on the CPU whatever the inference device.
+static int run_native_vumat(const abqnn::server::MlpEnergyModel &model,
+                            const void *defgradF,
+                            int32_t nblock,
+                            int32_t ndir,
+                            int32_t nshr,
+                            torch::ScalarType dtype,
+                            const torch::Tensor &mat_par_tensor,
+                            char *energy,
+                            char *stress)
+{
+    torch::Tensor mat_par = mat_par_tensor.to(torch::kCPU, torch::kDouble).contiguous();
+    const double *mat_par_data = mat_par.numel() > 0 ? mat_par.data_ptr<double>() : nullptr;
+    const int32_t n_mat_par = static_cast<int32_t>(mat_par.numel());
+    if (dtype == torch::kFloat)
+    {
+        return model.vumat(static_cast<const float *>(defgradF), nblock, ndir, nshr, mat_par_data, n_mat_par,
+                           reinterpret_cast<float *>(energy), reinterpret_cast<float *>(stress));
+    }
+    return model.vumat(static_cast<const double *>(defgradF), nblock, ndir, nshr, mat_par_data, n_mat_par,
+                       reinterpret_cast<double *>(energy), reinterpret_cast<double *>(stress));
+}
+
+// Runs one VUMAT block and encodes the response, or just `status` when it is
+// already non-zero. defgradF and the outputs are doubles, or floats for dtype
+// kFloat.
+static void run_vumat_request(int32_t status,
+                              const std::shared_ptr<LoadedModule> &loaded,
+                              const void *defgradF,
+                              int32_t nblock,
+                              int32_t ndir,
+                              int32_t nshr,
+                              torch::ScalarType dtype,
+                              const torch::Tensor &mat_par_tensor,
+                              std::vector<char> &resp)
+{
+    const int nstress = ndir + nshr;
+    const size_t real_size = dtype == torch::kFloat ? sizeof(float) : sizeof(double);
+
+    // Size the response for success and let the model outputs be copied
+    // straight into it: status, nblock, ndir, nshr, energy, stress.
+    const size_t prefix = 4 * sizeof(int32_t);
+    const size_t energy_bytes = static_cast<size_t>(nblock) * real_size;
+    const size_t stress_bytes = static_cast<size_t>(nblock) * static_cast<size_t>(nstress) * real_size;
+    resp.resize(prefix + energy_bytes + stress_bytes);
+
+    if (status == 0)
+    {
+        try
+        {
+            ModelRunScope run(loaded, nblock);
+            status = run.status();
+            if (status == 0 && run.loaded()->native)
+            {
+                status = run_native_vumat(*run.loaded()->native, defgradF, nblock, ndir, nshr, dtype, mat_par_tensor,
+                                          resp.data() + prefix, resp.data() + prefix + energy_bytes);
+            }
+            else if (status == 0)
+            {
+                torch::Tensor F_batch_tensor;
+                status = build_defgrad_batch_tensor(defgradF, nblock, ndir, nshr, dtype, F_batch_tensor);
+                if (status == 0)
+                {
+                    F_batch_tensor = F_batch_tensor.to(mat_par_tensor.device());
+
+                    apply_thread_policy(nblock);
+                    auto results = run.module().forward({F_batch_tensor, mat_par_tensor});
+                    status = decode_vumat_results(results, nblock, nstress, dtype,
+                                                  resp.data() + prefix, resp.data() + prefix + energy_bytes);
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+#ifdef ENABLE_DEBUG_OUTPUT
+            std::fprintf(stderr, "server: VUMAT inference error: %s\n", e.what());
+#endif
+            status = 105;
+        }
+    }
+
+    if (status != 0)
+    {
+        resp.resize(sizeof(status));
+    }
+    abqnn::ipc::PayloadWriter out(resp.data(), status == 0 ? prefix : sizeof(status));
+    out.put(status);
+    if (status == 0)
+    {
+        out.put(nblock);
+        out.put(ndir);
+        out.put(nshr);
+    }
+}
+
+// Serves ABQNN_MSG_VUMAT_REQ (dtype kDouble) and ABQNN_MSG_VUMAT_F32_REQ
+// (kFloat), whose defgradF, mat_par and outputs are all single precision.
+static int handle_vumat_request(abqnn::ipc::PayloadView req, std::vector<char> &resp, torch::ScalarType dtype)
+{
+    const size_t real_size = dtype == torch::kFloat ? sizeof(float) : sizeof(double);
+    size_t off = 0;
+    uint32_t module_len = 0;
+    int32_t nblock = 0, ndir = 0, nshr = 0, n_mat_par = 0;
+
+    if (!abqnn::ipc::read_scalar(req, off, module_len)) return 123;
+    if (off + module_len > req.size) return 123;
+
+    std::string_view module_name(req.data + off, module_len);
+    off += module_len;
+
+    if (!abqnn::ipc::read_scalar(req, off, nblock) || !abqnn::ipc::read_scalar(req, off, ndir) || !abqnn::ipc::read_scalar(req, off, nshr) || !abqnn::ipc::read_scalar(req, off, n_mat_par)) return 123;
+    if (nblock <= 0 || n_mat_par < 0) return 123;
+
+    const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
+    if (off + ndefgrad * real_size + static_cast<size_t>(n_mat_par) * real_size != req.size) return 123;
+
+    const char *defgradF = req.data + off;
+    off += ndefgrad * real_size;
+    const char *mat_par = n_mat_par > 0 ? req.data + off : nullptr;
+
+    std::shared_ptr<LoadedModule> mod_ptr;
+    int32_t status = try_load_module(module_name, RequestKind::VUMAT, mod_ptr, dtype);
+
+    torch::Tensor mat_par_tensor;
+    if (status == 0)
+    {
+        try
+        {
+            mat_par_tensor = make_mat_par_tensor(mat_par, n_mat_par, get_inference_device(RequestKind::VUMAT), dtype);
+        }
+        catch (const std::exception &e)
+        {
+#ifdef ENABLE_DEBUG_OUTPUT
+            std::fprintf(stderr, "server: VUMAT inference error: %s\n", e.what());
+#endif
+            status = 105;
+        }
+    }
+
+    run_vumat_request(status, mod_ptr, defgradF, nblock, ndir, nshr, dtype, mat_par_tensor, resp);
+    return 0;
+}
+
+static int handle_vumat_handle_request(abqnn::ipc::PayloadView req, std::vector<char> &resp)
+{
+    size_t off = 0;
+    int32_t handle = -1;
+    uint32_t epoch = 0;
+    int32_t nblock = 0, ndir = 0, nshr = 0;
+
+    if (!abqnn::ipc::read_scalar(req, off, handle) || !abqnn::ipc::read_scalar(req, off, epoch)) return 123;
+    if (!abqnn::ipc::read_scalar(req, off, nblock) || !abqnn::ipc::read_scalar(req, off, ndir) || !abqnn::ipc::read_scalar(req, off, nshr)) return 123;
+    if (nblock <= 0) return 123;
+
+    const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
+    if (off + ndefgrad * sizeof(double) != req.size) return 123;
+
+    const char *defgradF = req.data + off;
+    const RegisteredModel *model = find_registered_model(handle, epoch, RequestKind::VUMAT);
+    if (!model)
+    {
+        run_vumat_request(113, nullptr, defgradF, nblock, ndir, nshr, torch::kDouble, torch::Tensor(), resp);
+        return 0;
+    }
+
+    run_vumat_request(0, registered_version(*model), defgradF, nblock, ndir, nshr, torch::kDouble, model->mat_par_tensor, resp);
+    return 0;
+}
+
+// Shared-memory data path (see abqnn_ipc_shm.h). Disabled when the region
+// cannot be created; clients then stay on the stream transport.
+static std::unique_ptr<abqnn::ipc::shm::Region> shm_region;
+
+// Per-slot state for requests claimed from the region. `detached` is set when
+// the owning connection closes while a worker holds the slot; the worker then
+// frees the slot instead of replying.
+struct ShmSlotJob
+{
+    uint32_t slot = 0;
+    std::vector<char> resp;
+    std::mutex mutex;
+    bool detached = false;
+    PendingUmat pending;
+    uint32_t pending_resp_type = 0;
+};
+static std::unique_ptr<ShmSlotJob[]> shm_slot_jobs;
+
+static std::unique_ptr<abqnn::ipc::Reactor> reactor;
+
+// One model of the --preload manifest. A line reads
+//   <umat|vumat> <model file> [mat_par=v,...] [batch=n,...] [nblock=n,...] [nshr=3|1] [dtype=f64|f32]
+// `batch` lists UMAT batch sizes (1 = single-point forward), `nblock` VUMAT
+// block sizes; '#' starts a comment. The device is the one configured for
+// the kind, as for requests.
+struct PreloadEntry
+{
+    RequestKind kind = RequestKind::UMAT;
+    std::string module_filename;
+    std::vector<double> mat_par;
+    std::vector<int32_t> sizes{1};
+    int32_t nshr = 3;
+    torch::ScalarType dtype = torch::kDouble;
+};
+
+// Comma-separated list of numbers; false on anything else.
+template <typename T>
+static bool parse_number_list(const std::string &text, std::vector<T> &out)
+{
+    out.clear();
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ','))
+    {
+        char *end = nullptr;
+        const double v = std::strtod(item.c_str(), &end);
+        if (item.empty() || *end != '\0')
+        {
+            return false;
+        }
+        out.push_back(static_cast<T>(v));
+    }
+    return !out.empty();
+}
+
+// The parsed --preload manifest; reloads warm new versions up with it. Set
+// before the server starts listening and read-only afterwards.
+static std::vector<PreloadEntry> preload_entries;
+
+static bool parse_preload_manifest(const std::string &path, std::vector<PreloadEntry> &entries)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::fprintf(stderr, "server: cannot open preload manifest %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    for (int line_no = 1; std::getline(in, line); ++line_no)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind))
+        {
+            continue;
+        }
+
+        PreloadEntry entry;
+        bool ok = (kind == "umat" || kind == "vumat") && static_cast<bool>(fields >> entry.module_filename);
+        entry.kind = kind == "vumat" ? RequestKind::VUMAT : RequestKind::UMAT;
+
+        std::string option;
+        while (ok && fields >> option)
+        {
+            const size_t eq = option.find('=');
+            const std::string name = option.substr(0, eq);
+            const std::string value = eq == std::string::npos ? std::string() : option.substr(eq + 1);
+            if (name == "mat_par")
+            {
+                ok = parse_number_list(value, entry.mat_par);
+            }
+            else if (name == "batch" || name == "nblock")
+            {
+                ok = parse_number_list(value, entry.sizes) &&
+                     std::all_of(entry.sizes.begin(), entry.sizes.end(), [](int32_t n) { return n > 0; });
+            }
+            else if (name == "nshr")
+            {
+                ok = value == "3" || value == "1";
+                entry.nshr = value == "1" ? 1 : 3;
+            }
+            else if (name == "dtype")
+            {
+                ok = value == "f64" || value == "f32";
+                entry.dtype = value == "f32" ? torch::kFloat : torch::kDouble;
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+        if (!ok || (entry.kind == RequestKind::UMAT && entry.dtype != torch::kDouble))
+        {
+            std::fprintf(stderr, "server: %s:%d: invalid preload entry\n", path.c_str(), line_no);
+            return false;
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+// Forwards per size; the profiling executor optimises a graph after it has
+// seen a few runs with the same shapes.
+static constexpr int kWarmUpRuns = 3;
+
+// Runs a loaded model on synthetic inputs near the identity for every size
+// the entry lists. Warms the shared module; replicas (--module-replicas) are
+// still cloned on each worker's first request.
+static bool warm_up_module(const PreloadEntry &entry, LoadedModule &loaded)
+{
+    if (loaded.native)
+    {
+        // Nothing to profile; one point checks that the entry's mat_par fits.
+        const double F[9] = {1.0, 0.0, 0.0, 0.01, 1.0, 0.0, 0.0, 0.0, 1.0};
+        double psi = 0.0;
+        double cauchy[6];
+        double ddsdde[36];
+        int32_t point_status = 0;
+        const int32_t status = loaded.native->umat(F, 1, entry.mat_par.data(), static_cast<int32_t>(entry.mat_par.size()),
+                                                   &point_status, &psi, cauchy, ddsdde);
+        if (status != 0 || point_status != 0)
+        {
+            std::fprintf(stderr, "server: warm-up of %s failed: status %d\n", entry.module_filename.c_str(),
+                         status != 0 ? status : point_status);
+            return false;
+        }
+        return true;
+    }
+
+    int32_t status = 0;
+    try
+    {
+        c10::InferenceMode guard(runs_in_inference_mode(loaded));
+        torch::jit::Module &module = loaded.module;
+        torch::Tensor mat_par_tensor =
+            make_mat_par_tensor(entry.mat_par.data(), static_cast<int32_t>(entry.mat_par.size()),
+                                get_inference_device(entry.kind))
+                .to(entry.dtype);
+        const bool has_forward_batch = module.find_method("forward_batch").has_value();
+
+        for (int run = 0; run < kWarmUpRuns && status == 0; ++run)
+        {
+            for (int32_t n : entry.sizes)
+            {
+                if (entry.kind == RequestKind::UMAT)
+                {
+                    // Column-major F = I with a small F12 shear, n times.
+                    std::vector<double> F(static_cast<size_t>(n) * 9, 0.0);
+                    for (int32_t i = 0; i < n; ++i)
+                    {
+                        double *Fi = &F[static_cast<size_t>(i) * 9];
+                        Fi[0] = Fi[4] = Fi[8] = 1.0;
+                        Fi[3] = 0.01;
+                    }
+                    if (loaded.energy_only)
+                    {
+                        thread_local UmatBatchResults results;
+                        status = run_umat_energy_batch(module, F.data(), n, mat_par_tensor, results);
+                    }
+                    else if (n == 1)
+                    {
+                        double psi = 0.0;
+                        torch::Tensor cauchy, ddsdde;
+                        status = run_umat_forward(module, F.data(), mat_par_tensor, psi, cauchy, ddsdde);
+                    }
+                    else if (has_forward_batch)
+                    {
+                        thread_local UmatBatchResults results;
+                        status = run_umat_forward_batch(module, F.data(), n, mat_par_tensor, results);
+                    }
+                }
+                else
+                {
+                    // Fortran defgradF(n, ndefgrad): unit stretches, F12 = 0.01.
+                    const int32_t ndefgrad = 3 + 2 * entry.nshr;
+                    std::vector<double> defgrad(static_cast<size_t>(ndefgrad) * n, 0.0);
+                    std::fill(defgrad.begin(), defgrad.begin() + 3 * static_cast<size_t>(n), 1.0);
+                    std::fill(defgrad.begin() + 3 * static_cast<size_t>(n), defgrad.begin() + 4 * static_cast<size_t>(n), 0.01);
+                    std::vector<float> defgrad_f32(defgrad.begin(), defgrad.end());
+                    const void *defgradF = entry.dtype == torch::kFloat ? static_cast<const void *>(defgrad_f32.data())
+                                                                        : static_cast<const void *>(defgrad.data());
+
+                    torch::Tensor F_batch_tensor;
+                    status = build_defgrad_batch_tensor(defgradF, n, 3, entry.nshr, entry.dtype, F_batch_tensor);
+                    if (status == 0)
+                    {
+                        auto results = module.forward({F_batch_tensor.to(mat_par_tensor.device()), mat_par_tensor});
+                        const int32_t nstress = 3 + entry.nshr;
+                        const size_t real_size = entry.dtype == torch::kFloat ? sizeof(float) : sizeof(double);
+                        std::vector<char> out(static_cast<size_t>(n) * (1 + nstress) * real_size);
+                        status = decode_vumat_results(results, n, nstress, entry.dtype, out.data(),
+                                                      out.data() + static_cast<size_t>(n) * real_size);
+                    }
+                }
+                if (status != 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "server: warm-up of %s failed: %s\n", entry.module_filename.c_str(), e.what());
+        return false;
+    }
+    return status == 0;
+}
+
+// Loads (and with --optimize-models prepares) the model through the module
+// cache, warms it up, then pins it against eviction. A model that fails to
+// warm up stays unpinned, so the cache can evict it like any other. Nothing
+// runs meanwhile: the server is not listening yet.
+static bool warm_up_model(const PreloadEntry &entry)
+{
+    std::shared_ptr<LoadedModule> loaded;
+    if (try_load_module(entry.module_filename, entry.kind, loaded, entry.dtype) != 0)
+    {
+        return false;
+    }
+    if (!warm_up_module(entry, *loaded))
+    {
+        return false;
+    }
+    loaded->pinned.store(true);
+    return true;
+}
+
+// Runs the --preload manifest. The server only starts listening afterwards,
+// so its endpoint appearing means the listed models are ready. A model that
+// fails to warm up is reported and left to load on demand.
+static bool preload_models(const std::string &manifest)
+{
+    if (!parse_preload_manifest(manifest, preload_entries))
+    {
+        return false;
+    }
+
+    for (const PreloadEntry &entry : preload_entries)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const bool warmed = warm_up_model(entry);
+        if (!warmed)
+        {
+            std::fprintf(stderr, "server: could not preload %s\n", entry.module_filename.c_str());
+        }
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: preloaded %s in %.1f ms%s\n", entry.module_filename.c_str(),
+                     std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                     warmed ? "" : " (failed)");
+#else
+        (void)start;
+#endif
+    }
+    return true;
+}
+
+// Serializes reloads, so two reloads of one file publish in order.
+static std::mutex module_reload_mutex;
+
+// Loads every cached version of `module_filename` (one per kind, device and
+// dtype it is cached under) afresh, warms each up with the matching --preload
+// entries, then publishes them. Requests already running on an old version
+// finish on it, and it is released after the last; later ones, registered
+// handles included, run the new one.
+// Nothing is published unless every version loads. A model that is not
+// cached yet has nothing to reload: its first request loads the file.
+static int32_t reload_model(std::string_view module_filename)
+{
+    std::lock_guard<std::mutex> reload_lock(module_reload_mutex);
+
+    std::vector<std::pair<std::string, std::shared_ptr<LoadedModule>>> versions;
+    std::shared_ptr<const ModuleTable> table = current_module_table();
+    for (const auto &[key, current] : table->models)
+    {
+        if (current->module_filename != module_filename)
+        {
+            continue;
+        }
+
+        auto loaded = std::make_shared<LoadedModule>();
+        if (load_module_into(*loaded, key, module_filename, current->kind, current->dtype) != 0)
+        {
+            return 101;
+        }
+        loaded->pinned.store(current->pinned.load());
+        for (const PreloadEntry &entry : preload_entries)
+        {
+            if (entry.module_filename == module_filename && entry.kind == current->kind &&
+                entry.dtype == current->dtype && !warm_up_module(entry, *loaded))
+            {
+                return 101;
+            }
+        }
+        versions.emplace_back(key, std::move(loaded));
+    }
+
+    std::lock_guard<std::mutex> lock(module_table_write_mutex);
+    for (auto &[key, loaded] : versions)
+    {
+        publish_module(key, loaded);
+    }
+    evict_idle_modules(nullptr);
+#ifdef ENABLE_DEBUG_OUTPUT
+    std::fprintf(stderr, "server: reloaded %zu version(s) of %.*s\n", versions.size(),
+                 static_cast<int>(module_filename.size()), module_filename.data());
+#endif
+    return 0;
+}
+
+static int handle_reload_request(abqnn::ipc::PayloadView req, std::vector<char> &resp)
+{
+    size_t off = 0;
+    uint32_t module_len = 0;
+    if (!abqnn::ipc::read_scalar(req, off, module_len) || off + module_len != req.size) return 123;
+
+    int32_t status = reload_model(std::string_view(req.data + off, module_len));
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(resp, sizeof(status));
+    out.put(status);
+    return 0;
+}
+
+// One --watch-interval pass: reloads each cached model whose file's
+// modification time changed. A file that fails to reload is retried once it
+// changes again; `failed` remembers it until then.
+static void reload_changed_model_files(std::map<std::string, std::filesystem::file_time_type> &failed)
+{
+    std::map<std::string, std::filesystem::file_time_type> changed;
+    std::shared_ptr<const ModuleTable> table = current_module_table();
+    for (const auto &[key, loaded] : table->models)
+    {
+        std::error_code err;
+        const auto file_time = std::filesystem::last_write_time(resolve_model_path(loaded->module_filename), err);
+        auto it = failed.find(loaded->module_filename);
+        if (!err && file_time != loaded->file_time && (it == failed.end() || it->second != file_time))
+        {
+            changed.emplace(loaded->module_filename, file_time);
+        }
+    }
+
+    for (const auto &[module_filename, file_time] : changed)
+    {
+        if (reload_model(module_filename) == 0)
+        {
+            failed.erase(module_filename);
+        }
+        else
+        {
+            std::fprintf(stderr, "server: could not reload %s\n", module_filename.c_str());
+            failed[module_filename] = file_time;
+        }
+    }
+}
+
+static std::string format_server_stats()
+{
+    abqnn::server::WorkerPoolStats pool = worker_pool->stats();
+    std::shared_ptr<const ModuleTable> table = current_module_table();
+    size_t cached_bytes = 0;
+    for (const auto &[key, loaded] : table->models)
+    {
+        cached_bytes += loaded->bytes;
+    }
+
+    char buf[1024];
+    std::snprintf(buf, sizeof(buf),
+                  "workers=%zu\n"
+                  "queue_depth=%zu\n"
+                  "max_queue_depth=%zu\n"
+                  "busy_workers=%zu\n"
+                  "tasks_completed=%llu\n"
+                  "tasks_stolen=%llu\n"
+                  "worker_utilisation=%.4f\n"
+                  "active_connections=%zu\n"
+                  "registered_models=%d\n"
+                  "intra_op_threads=%d\n"
+                  "parallel_min_points=%zu\n"
+                  "single_thread_forwards=%llu\n"
+                  "intra_op_forwards=%llu\n"
+                  "cached_models=%zu\n"
+                  "model_cache_bytes=%zu\n"
+                  "model_cache_budget_bytes=%zu\n"
+                  "model_cache_hits=%llu\n"
+                  "model_cache_misses=%llu\n"
+                  "model_cache_evictions=%llu\n",
+                  pool.workers,
+                  pool.queue_depth,
+                  pool.max_queue_depth,
+                  pool.busy_workers,
+                  static_cast<unsigned long long>(pool.tasks_completed),
+                  static_cast<unsigned long long>(pool.tasks_stolen),
+                  pool.utilisation(),
+                  reactor ? reactor->connection_count() : size_t(0),
+                  static_cast<int>(registered_model_count.load(std::memory_order_relaxed)),
+                  server_options.intra_op_threads > 0 ? static_cast<int>(server_options.intra_op_threads) : at::get_num_threads(),
+                  server_options.parallel_min_points,
+                  static_cast<unsigned long long>(single_thread_forwards.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(intra_op_forwards.load(std::memory_order_relaxed)),
+                  table->models.size(),
+                  cached_bytes,
+                  server_options.model_cache_bytes,
+                  static_cast<unsigned long long>(model_cache_hits.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(model_cache_misses.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(model_cache_evictions.load(std::memory_order_relaxed)));
+    std::string text = buf;
+
+    if (umat_batcher)
+    {
+        abqnn::server::BatcherStats batches = umat_batcher->stats();
+        std::snprintf(buf, sizeof(buf),
+                      "umat_batches=%llu\n"
+                      "umat_batched_requests=%llu\n"
+                      "umat_mean_batch_size=%.2f\n"
+                      "umat_full_batches=%llu\n"
+                      "umat_timed_out_batches=%llu\n",
+                      static_cast<unsigned long long>(batches.batches),
+                      static_cast<unsigned long long>(batches.items),
+                      batches.mean_batch_size(),
+                      static_cast<unsigned long long>(batches.full_batches),
+                      static_cast<unsigned long long>(batches.timed_out_batches));
+        text += buf;
+
+        // Batch size histogram, keyed by the upper bound of each bucket.
+        text += "umat_batch_size_histogram=";
+        for (size_t i = 0; i < abqnn::server::kBatchSizeBuckets; ++i)
+        {
+            const bool last = i + 1 == abqnn::server::kBatchSizeBuckets;
+            std::snprintf(buf, sizeof(buf), "%s%s%zu:%llu", i == 0 ? "" : ",", last ? ">" : "",
+                          last ? (size_t(1) << (i - 1)) : (size_t(1) << i),
+                          static_cast<unsigned long long>(batches.size_histogram[i]));
+            text += buf;
+        }
+        text += "\n";
+    }
+
+    if (umat_result_cache)
+    {
+        abqnn::server::ResultCacheStats results = umat_result_cache->stats();
+        std::snprintf(buf, sizeof(buf),
+                      "umat_result_cache_entries=%zu\n"
+                      "umat_result_cache_bytes=%zu\n"
+                      "umat_result_cache_lookups=%llu\n"
+                      "umat_result_cache_hits=%llu\n"
+                      "umat_result_cache_hit_rate=%.4f\n"
+                      "umat_result_cache_evictions=%llu\n",
+                      results.entries,
+                      results.bytes,
+                      static_cast<unsigned long long>(results.lookups),
+                      static_cast<unsigned long long>(results.hits),
+                      results.hit_rate(),
+                      static_cast<unsigned long long>(results.evictions));
+        text += buf;
+    }
+
+    // One line per cached model: whether it was prepared and runs in
+    // inference mode, whether it is pinned, its tensor bytes, requests and
+    // points run on it, and their mean time.
+    for (const auto &[key, loaded_ptr] : table->models)
+    {
+        const LoadedModule &loaded = *loaded_ptr;
+        const uint64_t runs = loaded.runs.load(std::memory_order_relaxed);
+        const uint64_t points = loaded.points.load(std::memory_order_relaxed);
+        const double run_us = static_cast<double>(loaded.run_ns.load(std::memory_order_relaxed)) * 1e-3;
+        std::snprintf(buf, sizeof(buf),
+                      "model[%s]=native:%d,prepared:%d,inference_mode:%d,pinned:%d,bytes:%zu,runs:%llu,points:%llu,"
+                      "mean_run_us:%.2f,mean_point_us:%.3f\n",
+                      key.c_str(), loaded.native ? 1 : 0, loaded.prepared ? 1 : 0,
+                      runs_in_inference_mode(loaded) ? 1 : 0,
+                      loaded.pinned.load(std::memory_order_relaxed) ? 1 : 0, loaded.bytes,
+                      static_cast<unsigned long long>(runs), static_cast<unsigned long long>(points),
+                      runs == 0 ? 0.0 : run_us / static_cast<double>(runs),
+                      points == 0 ? 0.0 : run_us / static_cast<double>(points));
+        text += buf;
+    }
+    return text;
+}
+
+static void handle_stats_request(std::vector<char> &resp)
+{
+    std::string text = format_server_stats();
+    int32_t status = 0;
+    uint32_t text_len = static_cast<uint32_t>(text.size());
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(resp, sizeof(status) + sizeof(text_len) + text.size());
+    out.put(status);
+    out.put(text_len);
+    out.put_bytes(text.data(), text.size());
+}
+
+// Decodes one request payload, runs it and encodes the response payload.
+// `request_flags` are the ABQNN_IPC_FLAG_* bits of the request header.
+// Returns false for message types the server does not know.
+static bool dispatch_request(uint32_t message_type, uint32_t request_flags, abqnn::ipc::PayloadView req,
+                             std::vector<char> &resp, uint32_t &resp_type)
+{
+    switch (message_type)
+    {
+    case ABQNN_MSG_UMAT_REQ:
+        resp_type = ABQNN_MSG_UMAT_RESP;
+        handle_umat_request(req, resp, request_flags);
+        return true;
+    case ABQNN_MSG_VUMAT_REQ:
+        resp_type = ABQNN_MSG_VUMAT_RESP;
+        handle_vumat_request(req, resp, torch::kDouble);
+        return true;
+    case ABQNN_MSG_VUMAT_F32_REQ:
+        resp_type = ABQNN_MSG_VUMAT_F32_RESP;
+        handle_vumat_request(req, resp, torch::kFloat);
+        return true;
+    case ABQNN_MSG_UMAT_BATCH_REQ:
+        resp_type = ABQNN_MSG_UMAT_BATCH_RESP;
+        handle_umat_batch_request(req, resp, request_flags);
+        return true;
+    case ABQNN_MSG_REGISTER_REQ:
+        resp_type = ABQNN_MSG_REGISTER_RESP;
+        handle_register_request(req, resp);
+        return true;
+    case ABQNN_MSG_UMAT_HANDLE_REQ:
+        resp_type = ABQNN_MSG_UMAT_HANDLE_RESP;
+        handle_umat_handle_request(req, resp, request_flags);
+        return true;
+    case ABQNN_MSG_VUMAT_HANDLE_REQ:
+        resp_type = ABQNN_MSG_VUMAT_HANDLE_RESP;
+        handle_vumat_handle_request(req, resp);
+        return true;
+    case ABQNN_MSG_STATS_REQ:
+        resp_type = ABQNN_MSG_STATS_RESP;
+        handle_stats_request(resp);
+        return true;
+    case ABQNN_MSG_RELOAD_REQ:
+        resp_type = ABQNN_MSG_RELOAD_RESP;
+        handle_reload_request(req, resp);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Publishes the response in job->resp (or the failure) to the slot.
+static void finish_shm_slot_request(ShmSlotJob *job, bool handled, uint32_t resp_type)
+{
+    using namespace abqnn::ipc::shm;
+
+    SlotHeader *hdr = shm_region->slot(job->slot);
+    const uint64_t capacity = shm_region->header()->slot_capacity;
+
+    SlotState reply = SLOT_RESPONSE;
+    if (!handled)
+    {
+        reply = SLOT_ERROR;
+    }
+    else if (job->resp.size() > capacity)
+    {
+        reply = SLOT_OVERFLOW;
+    }
+    else
+    {
+        std::memcpy(shm_region->slot_data(job->slot), job->resp.data(), job->resp.size());
+        hdr->message_type = resp_type;
+        hdr->payload_size = static_cast<uint32_t>(job->resp.size());
+    }
+
+    std::lock_guard<std::mutex> lock(job->mutex);
+    if (job->detached)
+    {
+        hdr->state.store(SLOT_FREE, std::memory_order_release);
+        return;
+    }
+    shm_region->post_reply(job->slot, reply);
+}
+
+static void finish_batched_shm_umat(void *owner)
+{
+    auto *job = static_cast<ShmSlotJob *>(owner);
+    finish_shm_slot_request(job, true, job->pending_resp_type);
+}
+
+// Pool task for a request claimed from a shared-memory slot. The request is
+// decoded straight from the mapped memory.
+static void run_shm_slot_request(void *context)
+{
+    using namespace abqnn::ipc::shm;
+
+    auto *job = static_cast<ShmSlotJob *>(context);
+    SlotHeader *hdr = shm_region->slot(job->slot);
+    const uint64_t capacity = shm_region->header()->slot_capacity;
+
+    abqnn::ipc::PayloadView req{shm_region->slot_data(job->slot), std::min<uint64_t>(hdr->payload_size, capacity)};
+    job->resp.clear();
+
+    if (hdr->message_type == ABQNN_MSG_UMAT_REQ || hdr->message_type == ABQNN_MSG_UMAT_HANDLE_REQ)
+    {
+        job->pending.finish = &finish_batched_shm_umat;
+        job->pending.owner = job;
+        job->pending_resp_type = hdr->message_type == ABQNN_MSG_UMAT_REQ ? ABQNN_MSG_UMAT_RESP : ABQNN_MSG_UMAT_HANDLE_RESP;
+        if (defer_umat_request(hdr->message_type, hdr->flags, req, job->resp, job->pending))
+        {
+            return;
+        }
+    }
+
+    uint32_t resp_type = 0;
+    bool handled = dispatch_request(hdr->message_type, hdr->flags, req, job->resp, resp_type);
+    finish_shm_slot_request(job, handled, resp_type);
+}
+
+// Watches the region's doorbell and hands every posted slot request to the
+// pool, so all slots are served by this one thread plus the workers.
+static void dispatch_shm_slots()
+{
+    using namespace abqnn::ipc::shm;
+    constexpr int kPollMs = 100;
+
+    const uint32_t slot_count = shm_region->header()->slot_count;
+    uint32_t seen = shm_region->header()->doorbell.load(std::memory_order_acquire);
+    while (true)
+    {
+        for (uint32_t i = 0; i < slot_count; ++i)
+        {
+            std::atomic<uint32_t> &state = shm_region->slot(i)->state;
+            uint32_t expected = SLOT_REQUEST;
+            if (state.load(std::memory_order_relaxed) == SLOT_REQUEST &&
+                state.compare_exchange_strong(expected, SLOT_BUSY, std::memory_order_acq_rel))
+            {
+                worker_pool->submit(abqnn::server::Task{&run_shm_slot_request, &shm_slot_jobs[i]});
+            }
+        }
+        shm_region->wait_for_requests(seen, kPollMs);
+    }
+}
+
+static void handle_shm_attach(abqnn::ipc::ReactorConnection &conn, std::vector<char> &resp)
+{
+    using namespace abqnn::ipc::shm;
+
+    int32_t status = 123;
+    uint32_t slot = 0;
+
+    if (shm_region && conn.user_slot < 0)
+    {
+        for (uint32_t i = 0; i < shm_region->header()->slot_count; ++i)
+        {
+            uint32_t expected = SLOT_FREE;
+            if (shm_region->slot(i)->state.compare_exchange_strong(expected, SLOT_IDLE))
+            {
+                slot = i;
+                status = 0;
+                break;
+            }
+        }
+    }
+
+    if (status == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(shm_slot_jobs[slot].mutex);
+            shm_slot_jobs[slot].detached = false;
+        }
+        conn.user_slot = static_cast<int>(slot);
+    }
+
+    const uint64_t server_pid = status == 0 ? shm_region->header()->server_pid : 0;
+    abqnn::ipc::PayloadWriter out = abqnn::ipc::begin_payload(
+        resp, sizeof(status) + (status == 0 ? sizeof(server_pid) + sizeof(slot) : 0));
+    out.put(status);
+    if (status == 0)
+    {
+        out.put(server_pid);
+        out.put(slot);
+    }
+}
+
+static void release_shm_slot(int attached_slot)
+{
+    using namespace abqnn::ipc::shm;
+
+    if (attached_slot < 0)
+    {
+        return;
+    }
+
+    ShmSlotJob &job = shm_slot_jobs[attached_slot];
+    std::atomic<uint32_t> &state = shm_region->slot(static_cast<uint32_t>(attached_slot))->state;
+
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.detached = true;
+    // A BUSY slot is freed by the worker holding it (run_shm_slot_request).
+    uint32_t cur = state.load(std::memory_order_acquire);
+    while (cur != SLOT_BUSY && !state.compare_exchange_weak(cur, SLOT_FREE, std::memory_order_acq_rel))
+    {
+    }
+}
+
+// A stream UMAT request parked in the batcher. Recycled like reactor requests.
+struct BatchedStreamUmat
+{
+    PendingUmat pending;
+    abqnn::ipc::ReactorRequest *request = nullptr;
+};
+
+static std::mutex batched_stream_mutex;
+static std::vector<std::unique_ptr<BatchedStreamUmat>> free_batched_stream;
+
+static BatchedStreamUmat *acquire_batched_stream_umat()
+{
+    {
+        std::lock_guard<std::mutex> lock(batched_stream_mutex);
+        if (!free_batched_stream.empty())
+        {
+            BatchedStreamUmat *batched = free_batched_stream.back().release();
+            free_batched_stream.pop_back();
+            return batched;
+        }
+    }
+    return new BatchedStreamUmat();
+}
+
+static void recycle_batched_stream_umat(BatchedStreamUmat *batched)
+{
+    std::lock_guard<std::mutex> lock(batched_stream_mutex);
+    free_batched_stream.emplace_back(batched);
+}
+
+static void finish_batched_stream_umat(void *owner)
+{
+    auto *batched = static_cast<BatchedStreamUmat *>(owner);
+    reactor->reply(batched->request);
+    recycle_batched_stream_umat(batched);
+}
+
+// Pool task for a request that arrived over the stream transport.
+static void run_stream_request(void *context)
+{
+    auto *request = static_cast<abqnn::ipc::ReactorRequest *>(context);
+    abqnn::ipc::PayloadView req{request->payload.data(), request->payload.size()};
+
+    const uint32_t message_type = request->header.message_type;
+    if (umat_batcher && (message_type == ABQNN_MSG_UMAT_REQ || message_type == ABQNN_MSG_UMAT_HANDLE_REQ))
+    {
+        BatchedStreamUmat *batched = acquire_batched_stream_umat();
+        batched->request = request;
+        batched->pending.finish = &finish_batched_stream_umat;
+        batched->pending.owner = batched;
+        request->response_type = message_type == ABQNN_MSG_UMAT_REQ ? ABQNN_MSG_UMAT_RESP : ABQNN_MSG_UMAT_HANDLE_RESP;
+        if (defer_umat_request(message_type, request->header.flags, req, request->response, batched->pending))
+        {
+            return;
+        }
+        recycle_batched_stream_umat(batched);
+    }
+
+    if (dispatch_request(message_type, request->header.flags, req, request->response, request->response_type))
+    {
+        reactor->reply(request);
+    }
+    else
+    {
+        reactor->reject(request);
+    }
+}
+
+// RELOAD_REQ frames from stream clients, waiting for the reload thread.
+// Never destroyed, like the thread itself.
+struct ReloadQueue
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<abqnn::ipc::ReactorRequest *> requests;
+};
+static ReloadQueue *const reload_queue = new ReloadQueue();
+
+// The server's one reload thread: answers queued RELOAD_REQ frames in order
+// and, with --watch-interval, polls the model files between them. Loading a
+// model thus never takes a worker, and reloads never pile up threads.
+static void run_reload_thread()
+{
+    const bool watching = server_options.watch_interval_s > 0;
+    const auto interval = std::chrono::seconds(server_options.watch_interval_s);
+    auto next_check = std::chrono::steady_clock::now() + interval;
+    std::map<std::string, std::filesystem::file_time_type> failed;
+    for (;;)
+    {
+        abqnn::ipc::ReactorRequest *request = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(reload_queue->mutex);
+            auto queued = []() { return !reload_queue->requests.empty(); };
+            if (watching)
+            {
+                reload_queue->ready.wait_until(lock, next_check, queued);
+            }
+            else
+            {
+                reload_queue->ready.wait(lock, queued);
+            }
+            if (!reload_queue->requests.empty())
+            {
+                request = reload_queue->requests.front();
+                reload_queue->requests.pop_front();
+            }
+        }
+
+        if (request)
+        {
+            run_stream_request(request);
+        }
+        if (watching && std::chrono::steady_clock::now() >= next_check)
+        {
+            reload_changed_model_files(failed);
+            next_check = std::chrono::steady_clock::now() + interval;
+        }
+    }
+}
+
+// Glue between the reactor's I/O threads and the inference pool. Inference
+// requests are queued; cheap bookkeeping requests are answered in place.
+// Reloads go to the reload thread, so loading a model never takes a worker.
+class ServerHandler final : public abqnn::ipc::ReactorHandler
+{
+public:
+    void on_request(abqnn::ipc::ReactorRequest *request) override
+    {
+        switch (request->header.message_type)
+        {
+        case ABQNN_MSG_SHM_ATTACH_REQ:
+            request->response_type = ABQNN_MSG_SHM_ATTACH_RESP;
+            handle_shm_attach(*request->connection, request->response);
+            reactor->reply(request);
+            break;
+        case ABQNN_MSG_STATS_REQ:
+            request->response_type = ABQNN_MSG_STATS_RESP;
+            handle_stats_request(request->response);
+            reactor->reply(request);
+            break;
+        case ABQNN_MSG_RELOAD_REQ:
+        {
+            std::lock_guard<std::mutex> lock(reload_queue->mutex);
+            reload_queue->requests.push_back(request);
+            reload_queue->ready.notify_one();
+            break;
+        }
+        default:
+            worker_pool->submit(abqnn::server::Task{&run_stream_request, request});
+            break;
+        }
+    }
+
+    // An attached shared-memory slot lives exactly as long as its connection.
+    void on_close(abqnn::ipc::ReactorConnection &connection) override
+    {
+        release_shm_slot(connection.user_slot);
+        connection.user_slot = -1;
+    }
+};
+
+static bool parse_size_arg(const char *text, size_t &out)
+{
+    char *end = nullptr;
+    unsigned long long v = std::strtoull(text, &end, 10);
+    if (!end || *end != '\0' || end == text)
+    {
+        return false;
+    }
+    out = static_cast<size_t>(v);
+    return true;
+}
+
+// A size in MiB, to the byte; fractions allow budgets below 1 MiB.
+static bool parse_mib_arg(const char *text, size_t &out)
+{
+    char *end = nullptr;
+    double v = std::strtod(text, &end);
+    if (!end || *end != '\0' || end == text || !(v >= 0.0))
+    {
+        return false;
+    }
+    out = static_cast<size_t>(std::ceil(v * 1024.0 * 1024.0));
+    return true;
+}
+
+// Usage: abqnn_inference_server [--workers N] [--io-threads N] [--max-connections N]
+//                               [--stats-interval SECONDS]
+//                               [--umat-batch-size N] [--umat-batch-wait-us MICROSECONDS]
+//                               [--symmetric-ddsdde 0|1]
+//                               [--intra-op-threads N] [--interop-threads N]
+//                               [--parallel-min-points N] [--module-replicas 0|1]
+//                               [--optimize-models 0|1] [--inference-mode 0|1]
+//                               [--preload MANIFEST] [--watch-interval SECONDS]
+//                               [--model-cache-mb N] [--umat-result-cache N]
+static bool parse_server_options(int argc, char **argv, ServerOptions &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--preload" && i + 1 < argc)
+        {
+            opts.preload_manifest = argv[++i];
+            continue;
+        }
+        if (arg == "--model-cache-mb")
+        {
+            if (i + 1 >= argc || !parse_mib_arg(argv[i + 1], opts.model_cache_bytes))
+            {
+                std::fprintf(stderr, "server: missing or invalid value for %s\n", arg.c_str());
+                return false;
+            }
+            ++i;
+            continue;
+        }
+
+        size_t value = 0;
+        if (i + 1 >= argc || !parse_size_arg(argv[i + 1], value))
+        {
+            std::fprintf(stderr, "server: missing or invalid value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--workers")
+        {
+            opts.workers = value;
+        }
+        else if (arg == "--io-threads")
+        {
+            opts.io_threads = std::max<size_t>(1, value);
+        }
+        else if (arg == "--max-connections")
+        {
+            opts.max_connections = value;
+        }
+        else if (arg == "--stats-interval")
+        {
+            opts.stats_interval_s = static_cast<int>(value);
+        }
+        else if (arg == "--umat-batch-size")
+        {
+            opts.umat_batch_size = std::max<size_t>(1, value);
+        }
+        else if (arg == "--umat-batch-wait-us")
+        {
+            opts.umat_batch_wait_us = value;
+        }
+        else if (arg == "--symmetric-ddsdde")
+        {
+            opts.symmetric_ddsdde = value != 0;
+        }
+        else if (arg == "--intra-op-threads")
+        {
+            opts.intra_op_threads = value;
+        }
+        else if (arg == "--interop-threads")
+        {
+            opts.interop_threads = value;
+        }
+        else if (arg == "--parallel-min-points")
+        {
+            opts.parallel_min_points = value;
+        }
+        else if (arg == "--module-replicas")
+        {
+            opts.module_replicas = value != 0;
+        }
+        else if (arg == "--optimize-models")
+        {
+            opts.optimize_models = value != 0;
+        }
+        else if (arg == "--inference-mode")
+        {
+            opts.inference_mode = value != 0;
+        }
+        else if (arg == "--watch-interval")
+        {
+            opts.watch_interval_s = static_cast<int>(value);
+        }
+        else if (arg == "--umat-result-cache")
+        {
+            opts.umat_result_cache = value;
+        }
+        else
+        {
+            std::fprintf(stderr, "server: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opts.workers == 0)
+    {
+        opts.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_server_options(argc, argv, server_options))
+    {
+        return 3;
+    }
+
+#ifdef ENABLE_DEBUG_OUTPUT
+    std::filesystem::create_directories(ABQNN_LOG_PATH);
+    auto log_file = (std::filesystem::path(ABQNN_LOG_PATH) / "ipc_server_err.txt").string();
+    std::freopen(log_file.c_str(), "a", stderr);
+    std::fprintf(stderr, "ABQnn IPC server starting...\n");
+    std::fprintf(stderr, "ABQnn UMAT device: %s\n", ABQNN_UMAT_TORCH_DEVICE);
+    std::fprintf(stderr, "ABQnn VUMAT device: %s\n", ABQNN_VUMAT_TORCH_DEVICE);
+#endif
+
+    int device_err = validate_inference_devices();
+    if (device_err != 0)
+    {
+        return device_err;
+    }
+
+#ifndef _WIN32
+    // A client that disappears mid-response must not take the server down.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+    {
+        using namespace abqnn::ipc::shm;
+        shm_region = Region::create(region_name_for_pid(current_pid()), DEFAULT_SLOT_COUNT, DEFAULT_SLOT_CAPACITY);
+        if (shm_region)
+        {
+            shm_slot_jobs = std::make_unique<ShmSlotJob[]>(DEFAULT_SLOT_COUNT);
+            for (uint32_t i = 0; i < DEFAULT_SLOT_COUNT; ++i)
+            {
+                shm_slot_jobs[i].slot = i;
+            }
+        }
+#ifdef ENABLE_DEBUG_OUTPUT
+        if (!shm_region)
+        {
+            std::fprintf(stderr, "server: shared-memory region unavailable, using stream transport only\n");
+        }
+#endif
+    }
+#endif
+
+    // Any value that differs between server runs will do; 0 is left unused.
+    registry_epoch = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count() ^
+                                           (std::chrono::steady_clock::now().time_since_epoch().count() << 7));
+    registry_epoch = registry_epoch == 0 ? 1 : registry_epoch;
+
+    // The inter-op pool can only be sized before any inference has run.
+    if (server_options.interop_threads > 0)
+    {
+        at::set_num_interop_threads(static_cast<int>(server_options.interop_threads));
+    }
+#if !AT_PARALLEL_OPENMP
+    // Without OpenMP the intra-op count is per process and fixed once work
+    // starts (see apply_thread_policy).
+    if (server_options.intra_op_threads > 0)
+    {
+        at::set_num_threads(static_cast<int>(server_options.intra_op_threads));
+    }
+    if (server_options.parallel_min_points > 0)
+    {
+        std::fprintf(stderr, "server: --parallel-min-points needs LibTorch's OpenMP backend; ignored\n");
+    }
+#endif
+
+    worker_pool = std::make_unique<abqnn::server::WorkerPool>(server_options.workers);
+#ifdef ENABLE_DEBUG_OUTPUT
+    std::fprintf(stderr, "ABQnn inference workers: %zu\n", worker_pool->size());
+    std::fprintf(stderr, "ABQnn intra-op threads: %zu (0 = LibTorch default), single-threaded below %zu points\n",
+                 server_options.intra_op_threads, server_options.parallel_min_points);
+#endif
+
+    if (server_options.umat_batch_size > 1)
+    {
+        umat_batcher = std::make_unique<abqnn::server::Batcher>(
+            *worker_pool, &run_umat_batch, server_options.umat_batch_size,
+            std::chrono::microseconds(server_options.umat_batch_wait_us));
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "ABQnn UMAT batching: up to %zu requests, %zu us wait\n",
+                     server_options.umat_batch_size, server_options.umat_batch_wait_us);
+#endif
+    }
+
+    if (server_options.umat_result_cache > 0)
+    {
+        umat_result_cache = std::make_unique<abqnn::server::UmatResultCache>(server_options.umat_result_cache);
+    }
+
+    // Before listening: clients only see the endpoint once this is done.
+    if (!server_options.preload_manifest.empty() && !preload_models(server_options.preload_manifest))
+    {
+        return 3;
+    }
+
+    if (server_options.stats_interval_s > 0)
+    {
+        std::thread([]() {
+            while (true)
+            {
+                std::this_thread::sleep_for(std::chrono::seconds(server_options.stats_interval_s));
+                std::string text = format_server_stats();
+                std::fprintf(stderr, "server stats:\n%s", text.c_str());
+                std::fflush(stderr);
+            }
+        }).detach();
+    }
+
+    // Also the --watch-interval poller.
+    std::thread(run_reload_thread).detach();
+
+    if (shm_region)
+    {
+        std::thread(dispatch_shm_slots).detach();
+    }
+
+    static ServerHandler handler;
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    reactor = abqnn::ipc::Reactor::create(endpoint, handler, server_options.io_threads, server_options.max_connections);
+    if (!reactor)
+    {
+#ifdef ENABLE_DEBUG_OUTPUT
+        std::fprintf(stderr, "server: failed to listen on %s (is another server using it?)\n", endpoint);
+#endif
+        return 2;
+    }
+
+    return reactor->run();
+}
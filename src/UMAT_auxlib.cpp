@@ -1,13 +1,20 @@
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
 #include <string>
+#include <algorithm>
 #include <filesystem>
 #include <vector>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <ctime>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -20,38 +27,56 @@
 
 static std::once_flag init_flag;
 static int initialization_error = 0;
-static const char *kPipeName = ABQNN_DEFAULT_PIPE_NAME;
+
+// Coalescing of concurrent invoke_pt calls, off unless ABQNN_COALESCE_WINDOW_US
+// is set. Read once by initialize_library.
+static long coalesce_window_us = 0;
+static size_t coalesce_max_batch = 64;
+// Cleared when the server does not know ABQNN_MSG_UMAT_BATCH_REQ.
+static std::atomic<bool> coalesce_supported{true};
 
 static int initialize_library()
 {
 #ifdef ENABLE_DEBUG_OUTPUT
     std::filesystem::create_directories(ABQNN_LOG_PATH);
-    char log_file_path[MAX_PATH];
-    std::snprintf(log_file_path, MAX_PATH, "%s/auxlib_err.txt", ABQNN_LOG_PATH);
-    std::freopen(log_file_path, "a", stderr);
+    auto log_file = (std::filesystem::path(ABQNN_LOG_PATH) / "auxlib_err.txt").string();
+    std::freopen(log_file.c_str(), "a", stderr);
 
     time_t now = time(NULL);
     std::fprintf(stderr, "UMAT_auxlib.cpp: %s", ctime(&now));
     std::fprintf(stderr, "Initializing IPC client.\n");
-    std::fprintf(stderr, "Pipe endpoint: %s\n", ABQNN_DEFAULT_PIPE_NAME);
+    std::fprintf(stderr, "IPC endpoint: %s\n", abqnn::ipc::default_endpoint());
+#endif
+
+    if (const char *window = std::getenv("ABQNN_COALESCE_WINDOW_US"))
+    {
+        coalesce_window_us = std::max(0L, std::strtol(window, nullptr, 10));
+    }
+    if (const char *max_batch = std::getenv("ABQNN_COALESCE_MAX_BATCH"))
+    {
+        coalesce_max_batch = static_cast<size_t>(std::max(1L, std::strtol(max_batch, nullptr, 10)));
+    }
+#ifdef ENABLE_DEBUG_OUTPUT
+    if (coalesce_window_us > 0)
+    {
+        std::fprintf(stderr, "Coalescing invoke_pt calls: window %ld us, at most %zu per batch\n",
+                     coalesce_window_us, coalesce_max_batch);
+    }
 #endif
     return 0;
 }
 
-int invoke_pt(const char *module_filename,
-              const double *F, const double *mat_par, int n_mat_par,
-              double *psi, double *Cauchy, double *DDSDDE)
+static int ensure_initialized()
 {
     std::call_once(init_flag, []() {
         initialization_error = initialize_library();
     });
-    
-    // Check if initialization failed
-    if (initialization_error != 0)
-    {
-        return initialization_error;
-    }
-    
+    return initialization_error;
+}
+
+static int check_umat_args(const char *module_filename, const double *F, const double *mat_par, int n_mat_par,
+                           double *psi, double *Cauchy, double *DDSDDE)
+{
     if (!module_filename || !F || !psi || !Cauchy || !DDSDDE)
     {
         return 110;
@@ -64,30 +89,78 @@ int invoke_pt(const char *module_filename,
     {
         return 110;
     }
+    return 0;
+}
 
+static size_t umat_request_size(const char *module_filename, int n_mat_par)
+{
+    return sizeof(uint32_t) + std::strlen(module_filename) + sizeof(int32_t) + 9 * sizeof(double) +
+           static_cast<size_t>(n_mat_par) * sizeof(double);
+}
+
+static void write_umat_request(abqnn::ipc::PayloadWriter &req, const char *module_filename,
+                               const double *F, const double *mat_par, int n_mat_par)
+{
     uint32_t module_len = static_cast<uint32_t>(std::strlen(module_filename));
     int32_t n_mat_par_i32 = static_cast<int32_t>(n_mat_par);
 
-    std::vector<char> req;
-    req.reserve(sizeof(module_len) + module_len + sizeof(n_mat_par_i32) + 9 * sizeof(double) +
-                static_cast<size_t>(n_mat_par > 0 ? n_mat_par : 0) * sizeof(double));
+    req.put(module_len);
+    req.put_bytes(module_filename, module_len);
+    req.put(n_mat_par_i32);
+    req.put_bytes(F, 9 * sizeof(double));
+    req.put_bytes(mat_par, static_cast<size_t>(n_mat_par) * sizeof(double));
+}
 
-    abqnn::ipc::append_scalar(req, module_len);
-    abqnn::ipc::append_bytes(req, module_filename, module_len);
-    abqnn::ipc::append_scalar(req, n_mat_par_i32);
-    abqnn::ipc::append_bytes(req, F, 9 * sizeof(double));
-    if (mat_par && n_mat_par > 0)
+// Order k of a symmetric matrix whose upper triangle has `packed` entries, or
+// 0 when no matrix has that many.
+static size_t packed_ddsdde_order(size_t packed)
+{
+    size_t k = 0;
+    while (k * (k + 1) / 2 < packed)
     {
-        abqnn::ipc::append_bytes(req, mat_par, static_cast<size_t>(n_mat_par) * sizeof(double));
+        ++k;
     }
+    return k * (k + 1) / 2 == packed ? k : 0;
+}
 
-    std::vector<char> resp;
-    int tx_err = abqnn::ipc::transact_blocking(kPipeName, ABQNN_MSG_UMAT_REQ, req, ABQNN_MSG_UMAT_RESP, resp);
-    if (tx_err != 0)
+// Doubles a tangent announced as `ddsdde_n` occupies in a response: a negative
+// count is a symmetric matrix sent as its -ddsdde_n upper-triangle entries.
+// Returns 0 for a count no tangent can have.
+static size_t ddsdde_wire_count(int32_t ddsdde_n)
+{
+    if (ddsdde_n >= 0)
     {
-        return tx_err;
+        return static_cast<size_t>(ddsdde_n);
     }
+    const size_t packed = static_cast<size_t>(-static_cast<int64_t>(ddsdde_n));
+    return packed_ddsdde_order(packed) != 0 ? packed : 0;
+}
+
+// Copies a tangent from the response into the caller's full matrix.
+static void copy_ddsdde(const char *src, int32_t ddsdde_n, double *DDSDDE)
+{
+    if (ddsdde_n >= 0)
+    {
+        std::memcpy(DDSDDE, src, static_cast<size_t>(ddsdde_n) * sizeof(double));
+        return;
+    }
+
+    const size_t k = packed_ddsdde_order(ddsdde_wire_count(ddsdde_n));
+    for (size_t i = 0; i < k; ++i)
+    {
+        for (size_t j = i; j < k; ++j)
+        {
+            double v = 0.0;
+            std::memcpy(&v, src, sizeof(double));
+            src += sizeof(double);
+            DDSDDE[i * k + j] = v;
+            DDSDDE[j * k + i] = v;
+        }
+    }
+}
 
+static int decode_umat_response(const abqnn::ipc::PayloadView &resp, double *psi, double *Cauchy, double *DDSDDE)
+{
     size_t off = 0;
     int32_t status = 0;
     if (!abqnn::ipc::read_scalar(resp, off, status))
@@ -111,45 +184,269 @@ int invoke_pt(const char *module_filename,
         return abqnn::ipc::ERR_IPC_PROTOCOL;
     }
 
-    if (cauchy_n <= 0 || ddsdde_n <= 0)
+    const size_t ddsdde_count = ddsdde_wire_count(ddsdde_n);
+    if (cauchy_n <= 0 || ddsdde_count == 0)
     {
         return abqnn::ipc::ERR_IPC_PROTOCOL;
     }
 
     size_t cauchy_bytes = static_cast<size_t>(cauchy_n) * sizeof(double);
-    size_t ddsdde_bytes = static_cast<size_t>(ddsdde_n) * sizeof(double);
+    size_t ddsdde_bytes = ddsdde_count * sizeof(double);
 
-    if (off + cauchy_bytes + ddsdde_bytes != resp.size())
+    if (off + cauchy_bytes + ddsdde_bytes != resp.size)
     {
         return abqnn::ipc::ERR_IPC_PROTOCOL;
     }
 
-    std::memcpy(Cauchy, resp.data() + off, cauchy_bytes);
+    std::memcpy(Cauchy, resp.data + off, cauchy_bytes);
     off += cauchy_bytes;
-    std::memcpy(DDSDDE, resp.data() + off, ddsdde_bytes);
+    copy_ddsdde(resp.data + off, ddsdde_n, DDSDDE);
 
     return 0;
 }
 
-int invoke_pt_vumat_batch(const char *module_filename,
-                          const double *defgradF,
-                          int nblock,
-                          int ndir,
-                          int nshr,
-                          const double *mat_par,
-                          int n_mat_par,
-                          double *enerInternNew,
-                          double *stressNew)
+static int invoke_pt_single(const char *module_filename,
+                            const double *F, const double *mat_par, int n_mat_par,
+                            double *psi, double *Cauchy, double *DDSDDE)
 {
-    std::call_once(init_flag, []() {
-        initialization_error = initialize_library();
-    });
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    const size_t req_size = umat_request_size(module_filename, n_mat_par);
+
+    abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+    write_umat_request(req, module_filename, F, mat_par, n_mat_par);
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_UMAT_REQ, req.size(), ABQNN_MSG_UMAT_RESP, resp,
+                                               ABQNN_IPC_FLAG_PACKED_DDSDDE);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    return decode_umat_response(resp, psi, Cauchy, DDSDDE);
+}
+
+// One invoke_pt call parked in a batch. The pointers stay valid because the
+// caller blocks until the batch is done.
+struct CoalescedCall
+{
+    const double *F;
+    double *psi;
+    double *Cauchy;
+    double *DDSDDE;
+    int status;
+};
+
+// Sentinel status: the batch was not sent, evaluate the call on its own.
+static constexpr int kCoalesceRetrySingle = -1;
+
+// Calls with the same module and mat_par collected during one window. The
+// first caller leads: it waits out the window (or until the batch is full),
+// sends the batch and scatters the results; the others wait for `done`.
+struct CoalescedBatch
+{
+    std::vector<CoalescedCall *> calls;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+static std::mutex coalesce_mutex;
+static std::unordered_map<std::string, std::shared_ptr<CoalescedBatch>> open_batches;
+
+// Sends the batch as one ABQNN_MSG_UMAT_BATCH_REQ and fills every call's
+// outputs and status.
+static void send_coalesced_batch(const char *module_filename, const double *mat_par, int n_mat_par,
+                                 CoalescedBatch &batch)
+{
+    uint32_t module_len = static_cast<uint32_t>(std::strlen(module_filename));
+    int32_t n_mat_par_i32 = static_cast<int32_t>(n_mat_par);
+    int32_t count = static_cast<int32_t>(batch.calls.size());
+
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    const size_t req_size = sizeof(module_len) + module_len + sizeof(n_mat_par_i32) + sizeof(count) +
+                            static_cast<size_t>(n_mat_par) * sizeof(double) +
+                            batch.calls.size() * 9 * sizeof(double);
+
+    abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+    req.put(module_len);
+    req.put_bytes(module_filename, module_len);
+    req.put(n_mat_par_i32);
+    req.put(count);
+    req.put_bytes(mat_par, static_cast<size_t>(n_mat_par) * sizeof(double));
+    for (CoalescedCall *call : batch.calls)
+    {
+        req.put_bytes(call->F, 9 * sizeof(double));
+    }
+
+    auto fail_all = [&](int status) {
+        for (CoalescedCall *call : batch.calls)
+        {
+            call->status = status;
+        }
+    };
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_UMAT_BATCH_REQ, req.size(), ABQNN_MSG_UMAT_BATCH_RESP, resp,
+                                               ABQNN_IPC_FLAG_PACKED_DDSDDE);
+    if (tx_err == abqnn::ipc::ERR_IPC_PROTOCOL || tx_err == abqnn::ipc::ERR_IPC_UNSUPPORTED)
+    {
+        // A server without batch support (see register_with_server): stop
+        // coalescing and send the calls on their own.
+        coalesce_supported.store(false);
+        fail_all(kCoalesceRetrySingle);
+        return;
+    }
+    if (tx_err != 0)
+    {
+        fail_all(tx_err);
+        return;
+    }
 
-    if (initialization_error != 0)
+    size_t off = 0;
+    int32_t status = 0;
+    int32_t resp_count = 0;
+    int32_t cauchy_n = 0;
+    int32_t ddsdde_n = 0;
+    if (!abqnn::ipc::read_scalar(resp, off, status))
+    {
+        fail_all(abqnn::ipc::ERR_IPC_PROTOCOL);
+        return;
+    }
+    if (status != 0)
+    {
+        fail_all(status);
+        return;
+    }
+    if (!abqnn::ipc::read_scalar(resp, off, resp_count) || !abqnn::ipc::read_scalar(resp, off, cauchy_n) ||
+        !abqnn::ipc::read_scalar(resp, off, ddsdde_n) || resp_count != count || cauchy_n < 0 ||
+        (ddsdde_n < 0 && ddsdde_wire_count(ddsdde_n) == 0))
+    {
+        fail_all(abqnn::ipc::ERR_IPC_PROTOCOL);
+        return;
+    }
+    const size_t ddsdde_count = ddsdde_wire_count(ddsdde_n);
+    if (off + batch.calls.size() * (sizeof(int32_t) + (1 + static_cast<size_t>(cauchy_n) + ddsdde_count) * sizeof(double)) != resp.size)
+    {
+        fail_all(abqnn::ipc::ERR_IPC_PROTOCOL);
+        return;
+    }
+
+    const char *point_status = resp.data + off;
+    const char *psi = point_status + batch.calls.size() * sizeof(int32_t);
+    const char *cauchy = psi + batch.calls.size() * sizeof(double);
+    const char *ddsdde = cauchy + batch.calls.size() * cauchy_n * sizeof(double);
+    for (size_t i = 0; i < batch.calls.size(); ++i)
+    {
+        CoalescedCall *call = batch.calls[i];
+        int32_t s = 0;
+        std::memcpy(&s, point_status + i * sizeof(int32_t), sizeof(s));
+        if (s == 0 && (cauchy_n <= 0 || ddsdde_count == 0))
+        {
+            s = abqnn::ipc::ERR_IPC_PROTOCOL;
+        }
+        call->status = s;
+        if (s != 0)
+        {
+            continue;
+        }
+        std::memcpy(call->psi, psi + i * sizeof(double), sizeof(double));
+        std::memcpy(call->Cauchy, cauchy + i * cauchy_n * sizeof(double), cauchy_n * sizeof(double));
+        copy_ddsdde(ddsdde + i * ddsdde_count * sizeof(double), ddsdde_n, call->DDSDDE);
+    }
+}
+
+// Parks the call in the open batch for its module and mat_par, trading up to
+// one window of latency for a single round trip and model call per batch.
+// Returns kCoalesceRetrySingle if the call has to be sent on its own.
+static int invoke_pt_coalesced(const char *module_filename,
+                               const double *F, const double *mat_par, int n_mat_par,
+                               double *psi, double *Cauchy, double *DDSDDE)
+{
+    std::string key(module_filename);
+    key.push_back('\0');
+    if (n_mat_par > 0)
     {
-        return initialization_error;
+        key.append(reinterpret_cast<const char *>(mat_par), static_cast<size_t>(n_mat_par) * sizeof(double));
     }
 
+    CoalescedCall call{F, psi, Cauchy, DDSDDE, kCoalesceRetrySingle};
+
+    std::unique_lock<std::mutex> lock(coalesce_mutex);
+    std::shared_ptr<CoalescedBatch> &open = open_batches[key];
+    if (open)
+    {
+        std::shared_ptr<CoalescedBatch> batch = open;
+        batch->calls.push_back(&call);
+        if (batch->calls.size() >= coalesce_max_batch)
+        {
+            // Full: close it to newcomers and wake the leader early.
+            open_batches.erase(key);
+            batch->cv.notify_all();
+        }
+        batch->cv.wait(lock, [&]() { return batch->done; });
+        return call.status;
+    }
+
+    std::shared_ptr<CoalescedBatch> batch = std::make_shared<CoalescedBatch>();
+    batch->calls.push_back(&call);
+    open = batch;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(coalesce_window_us);
+    batch->cv.wait_until(lock, deadline, [&]() { return batch->calls.size() >= coalesce_max_batch; });
+
+    auto it = open_batches.find(key);
+    if (it != open_batches.end() && it->second == batch)
+    {
+        open_batches.erase(it);
+    }
+    if (batch->calls.size() == 1)
+    {
+        // Nobody joined; a plain request is cheaper than a batch of one.
+        return kCoalesceRetrySingle;
+    }
+    lock.unlock();
+
+    send_coalesced_batch(module_filename, mat_par, n_mat_par, *batch);
+
+    lock.lock();
+    batch->done = true;
+    batch->cv.notify_all();
+    return call.status;
+}
+
+int invoke_pt(const char *module_filename,
+              const double *F, const double *mat_par, int n_mat_par,
+              double *psi, double *Cauchy, double *DDSDDE)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+
+    err = check_umat_args(module_filename, F, mat_par, n_mat_par, psi, Cauchy, DDSDDE);
+    if (err != 0)
+    {
+        return err;
+    }
+
+    if (coalesce_window_us > 0 && coalesce_supported.load(std::memory_order_relaxed))
+    {
+        err = invoke_pt_coalesced(module_filename, F, mat_par, n_mat_par, psi, Cauchy, DDSDDE);
+        if (err != kCoalesceRetrySingle)
+        {
+            return err;
+        }
+    }
+
+    return invoke_pt_single(module_filename, F, mat_par, n_mat_par, psi, Cauchy, DDSDDE);
+}
+
+// The VUMAT helpers take Real = double, or float for the float32 variant.
+template <typename Real>
+static int check_vumat_args(const char *module_filename, const Real *defgradF, int nblock, int ndir, int nshr,
+                            const Real *mat_par, int n_mat_par, Real *enerInternNew, Real *stressNew)
+{
     if (!module_filename || !defgradF || !enerInternNew || !stressNew || nblock <= 0)
     {
         return 110;
@@ -167,7 +464,22 @@ int invoke_pt_vumat_batch(const char *module_filename,
     {
         return 111;
     }
+    return 0;
+}
 
+template <typename Real>
+static size_t vumat_request_size(const char *module_filename, int nblock, int ndir, int nshr, int n_mat_par)
+{
+    const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
+    return sizeof(uint32_t) + std::strlen(module_filename) + 4 * sizeof(int32_t) +
+           ndefgrad * sizeof(Real) + static_cast<size_t>(n_mat_par) * sizeof(Real);
+}
+
+template <typename Real>
+static void write_vumat_request(abqnn::ipc::PayloadWriter &req, const char *module_filename,
+                                const Real *defgradF, int nblock, int ndir, int nshr,
+                                const Real *mat_par, int n_mat_par)
+{
     uint32_t module_len = static_cast<uint32_t>(std::strlen(module_filename));
     int32_t nblock_i32 = static_cast<int32_t>(nblock);
     int32_t ndir_i32 = static_cast<int32_t>(ndir);
@@ -175,28 +487,190 @@ int invoke_pt_vumat_batch(const char *module_filename,
     int32_t n_mat_par_i32 = static_cast<int32_t>(n_mat_par);
 
     const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
+
+    req.put(module_len);
+    req.put_bytes(module_filename, module_len);
+    req.put(nblock_i32);
+    req.put(ndir_i32);
+    req.put(nshr_i32);
+    req.put(n_mat_par_i32);
+    req.put_bytes(defgradF, ndefgrad * sizeof(Real));
+    req.put_bytes(mat_par, static_cast<size_t>(n_mat_par) * sizeof(Real));
+}
+
+template <typename Real>
+static int decode_vumat_response(const abqnn::ipc::PayloadView &resp, int nblock, int ndir, int nshr,
+                                 Real *enerInternNew, Real *stressNew)
+{
     const size_t nstress = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + nshr);
 
-    std::vector<char> req;
-    req.reserve(sizeof(module_len) + module_len +
-                sizeof(nblock_i32) + sizeof(ndir_i32) + sizeof(nshr_i32) + sizeof(n_mat_par_i32) +
-                ndefgrad * sizeof(double) +
-                static_cast<size_t>(n_mat_par > 0 ? n_mat_par : 0) * sizeof(double));
+    size_t off = 0;
+    int32_t status = 0;
+    if (!abqnn::ipc::read_scalar(resp, off, status))
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+
+    int32_t resp_nblock = 0;
+    int32_t resp_ndir = 0;
+    int32_t resp_nshr = 0;
+    if (!abqnn::ipc::read_scalar(resp, off, resp_nblock) || !abqnn::ipc::read_scalar(resp, off, resp_ndir) || !abqnn::ipc::read_scalar(resp, off, resp_nshr))
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+
+    if (resp_nblock != nblock || resp_ndir != ndir || resp_nshr != nshr)
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+
+    if (off + static_cast<size_t>(nblock) * sizeof(Real) + nstress * sizeof(Real) != resp.size)
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+
+    std::memcpy(enerInternNew, resp.data + off, static_cast<size_t>(nblock) * sizeof(Real));
+    off += static_cast<size_t>(nblock) * sizeof(Real);
+    std::memcpy(stressNew, resp.data + off, nstress * sizeof(Real));
+
+    return 0;
+}
+
+template <typename Real>
+static int invoke_vumat_batch(const char *module_filename,
+                              const Real *defgradF,
+                              int nblock,
+                              int ndir,
+                              int nshr,
+                              const Real *mat_par,
+                              int n_mat_par,
+                              Real *enerInternNew,
+                              Real *stressNew,
+                              uint32_t request_type,
+                              uint32_t expected_response_type)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+
+    err = check_vumat_args(module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par, enerInternNew, stressNew);
+    if (err != 0)
+    {
+        return err;
+    }
+
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    const size_t req_size = vumat_request_size<Real>(module_filename, nblock, ndir, nshr, n_mat_par);
+
+    abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+    write_vumat_request(req, module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par);
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, request_type, req.size(), expected_response_type, resp);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    return decode_vumat_response(resp, nblock, ndir, nshr, enerInternNew, stressNew);
+}
+
+int invoke_pt_vumat_batch(const char *module_filename,
+                          const double *defgradF,
+                          int nblock,
+                          int ndir,
+                          int nshr,
+                          const double *mat_par,
+                          int n_mat_par,
+                          double *enerInternNew,
+                          double *stressNew)
+{
+    return invoke_vumat_batch(module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par,
+                              enerInternNew, stressNew, ABQNN_MSG_VUMAT_REQ, ABQNN_MSG_VUMAT_RESP);
+}
+
+int invoke_pt_vumat_batch_f32(const char *module_filename,
+                              const float *defgradF,
+                              int nblock,
+                              int ndir,
+                              int nshr,
+                              const float *mat_par,
+                              int n_mat_par,
+                              float *enerInternNew,
+                              float *stressNew)
+{
+    return invoke_vumat_batch(module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par,
+                              enerInternNew, stressNew, ABQNN_MSG_VUMAT_F32_REQ, ABQNN_MSG_VUMAT_F32_RESP);
+}
+
+// Models registered with invoke_pt_register / invoke_pt_vumat_register. A
+// client handle is the entry's index plus one; entries are published once and
+// never change, so calls look them up without taking a lock.
+struct RegisteredModel
+{
+    std::string module_filename;
+    std::vector<double> mat_par;
+    bool vumat = false;
+    // The server's handle in the low 32 bits and its epoch in the high 32;
+    // 0 until the model has been registered with the running server.
+    std::atomic<uint64_t> server_ref{0};
+};
 
-    abqnn::ipc::append_scalar(req, module_len);
-    abqnn::ipc::append_bytes(req, module_filename, module_len);
-    abqnn::ipc::append_scalar(req, nblock_i32);
-    abqnn::ipc::append_scalar(req, ndir_i32);
-    abqnn::ipc::append_scalar(req, nshr_i32);
-    abqnn::ipc::append_scalar(req, n_mat_par_i32);
-    abqnn::ipc::append_bytes(req, defgradF, ndefgrad * sizeof(double));
-    if (mat_par && n_mat_par > 0)
+static constexpr int kMaxRegisteredModels = 4096;
+static std::unique_ptr<RegisteredModel> registered_models[kMaxRegisteredModels];
+static std::atomic<int> registered_model_count{0};
+static std::mutex registration_mutex;
+static std::unordered_map<std::string, int> registration_index;
+// Cleared when the server does not know ABQNN_MSG_REGISTER_REQ; handle calls
+// are then sent as named requests.
+static std::atomic<bool> handles_supported{true};
+
+// Sentinel status: the server takes no handles, send a named request instead.
+static constexpr int kHandleRetryNamed = -1;
+
+static RegisteredModel *find_registered_model(int handle, bool vumat)
+{
+    if (handle <= 0 || handle > registered_model_count.load(std::memory_order_acquire))
     {
-        abqnn::ipc::append_bytes(req, mat_par, static_cast<size_t>(n_mat_par) * sizeof(double));
+        return nullptr;
     }
+    RegisteredModel *model = registered_models[handle - 1].get();
+    return model->vumat == vumat ? model : nullptr;
+}
+
+// Registers the model with the server and caches the server's handle.
+static int register_with_server(RegisteredModel &model, uint64_t &server_ref)
+{
+    int32_t kind = model.vumat ? 1 : 0;
+    uint32_t module_len = static_cast<uint32_t>(model.module_filename.size());
+    int32_t n_mat_par = static_cast<int32_t>(model.mat_par.size());
 
-    std::vector<char> resp;
-    int tx_err = abqnn::ipc::transact_blocking(kPipeName, ABQNN_MSG_VUMAT_REQ, req, ABQNN_MSG_VUMAT_RESP, resp);
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    const size_t req_size = sizeof(kind) + sizeof(module_len) + module_len + sizeof(n_mat_par) +
+                            model.mat_par.size() * sizeof(double);
+
+    abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+    req.put(kind);
+    req.put(module_len);
+    req.put_bytes(model.module_filename.data(), module_len);
+    req.put(n_mat_par);
+    req.put_bytes(model.mat_par.data(), model.mat_par.size() * sizeof(double));
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_REGISTER_REQ, req.size(), ABQNN_MSG_REGISTER_RESP, resp);
+    if (tx_err == abqnn::ipc::ERR_IPC_PROTOCOL || tx_err == abqnn::ipc::ERR_IPC_UNSUPPORTED)
+    {
+        // A server without registration support: a v2 one answers with an
+        // error, an older one drops the connection.
+        handles_supported.store(false);
+        return kHandleRetryNamed;
+    }
     if (tx_err != 0)
     {
         return tx_err;
@@ -204,6 +678,8 @@ int invoke_pt_vumat_batch(const char *module_filename,
 
     size_t off = 0;
     int32_t status = 0;
+    int32_t handle = 0;
+    uint32_t epoch = 0;
     if (!abqnn::ipc::read_scalar(resp, off, status))
     {
         return abqnn::ipc::ERR_IPC_PROTOCOL;
@@ -212,28 +688,463 @@ int invoke_pt_vumat_batch(const char *module_filename,
     {
         return status;
     }
-
-    int32_t resp_nblock = 0;
-    int32_t resp_ndir = 0;
-    int32_t resp_nshr = 0;
-    if (!abqnn::ipc::read_scalar(resp, off, resp_nblock) || !abqnn::ipc::read_scalar(resp, off, resp_ndir) || !abqnn::ipc::read_scalar(resp, off, resp_nshr))
+    if (!abqnn::ipc::read_scalar(resp, off, handle) || !abqnn::ipc::read_scalar(resp, off, epoch) ||
+        off != resp.size || handle < 0 || epoch == 0)
     {
         return abqnn::ipc::ERR_IPC_PROTOCOL;
     }
 
-    if (resp_nblock != nblock_i32 || resp_ndir != ndir_i32 || resp_nshr != nshr_i32)
+    server_ref = (static_cast<uint64_t>(epoch) << 32) | static_cast<uint32_t>(handle);
+    model.server_ref.store(server_ref, std::memory_order_release);
+    return 0;
+}
+
+// Runs send(handle, epoch) with the model's server handle, registering the
+// model first if needed. When the server answers 113 it has been restarted
+// and forgot the handle; the model is registered again and the call retried.
+template <typename Send>
+static int call_with_server_handle(RegisteredModel &model, Send send)
+{
+    if (!handles_supported.load(std::memory_order_relaxed))
     {
-        return abqnn::ipc::ERR_IPC_PROTOCOL;
+        return kHandleRetryNamed;
     }
 
-    if (off + static_cast<size_t>(nblock) * sizeof(double) + nstress * sizeof(double) != resp.size())
+    for (int attempt = 0;; ++attempt)
     {
-        return abqnn::ipc::ERR_IPC_PROTOCOL;
+        uint64_t server_ref = model.server_ref.load(std::memory_order_acquire);
+        if (server_ref == 0)
+        {
+            int err = register_with_server(model, server_ref);
+            if (err != 0)
+            {
+                return err;
+            }
+        }
+
+        int err = send(static_cast<int32_t>(server_ref & 0xFFFFFFFFu), static_cast<uint32_t>(server_ref >> 32));
+        if (err != 113 || attempt > 0)
+        {
+            return err;
+        }
+        model.server_ref.compare_exchange_strong(server_ref, 0);
     }
+}
 
-    std::memcpy(enerInternNew, resp.data() + off, static_cast<size_t>(nblock) * sizeof(double));
-    off += static_cast<size_t>(nblock) * sizeof(double);
-    std::memcpy(stressNew, resp.data() + off, nstress * sizeof(double));
+static int register_model(const char *module_filename, const double *mat_par, int n_mat_par, bool vumat, int *handle)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+    if (!handle || !module_filename || n_mat_par < 0 || (n_mat_par > 0 && !mat_par))
+    {
+        return 110;
+    }
+    *handle = 0;
 
+    std::string key(module_filename);
+    key.push_back(vumat ? 'V' : 'U');
+    key.append(reinterpret_cast<const char *>(mat_par), static_cast<size_t>(n_mat_par) * sizeof(double));
+
+    RegisteredModel *model = nullptr;
+    int index = 0;
+    {
+        std::lock_guard<std::mutex> lock(registration_mutex);
+        auto it = registration_index.find(key);
+        if (it != registration_index.end())
+        {
+            index = it->second;
+        }
+        else
+        {
+            index = registered_model_count.load(std::memory_order_relaxed);
+            if (index >= kMaxRegisteredModels)
+            {
+                return 110;
+            }
+
+            auto entry = std::make_unique<RegisteredModel>();
+            entry->module_filename = module_filename;
+            entry->mat_par.assign(mat_par, mat_par + n_mat_par);
+            entry->vumat = vumat;
+            registered_models[index] = std::move(entry);
+            registered_model_count.store(index + 1, std::memory_order_release);
+            registration_index.emplace(std::move(key), index);
+        }
+        model = registered_models[index].get();
+    }
+
+    // Resolve the server handle now, so that a model the server cannot load
+    // is reported here rather than by the first call.
+    uint64_t server_ref = model->server_ref.load(std::memory_order_acquire);
+    if (server_ref == 0 && handles_supported.load(std::memory_order_relaxed))
+    {
+        err = register_with_server(*model, server_ref);
+        if (err != 0 && err != kHandleRetryNamed)
+        {
+            return err;
+        }
+    }
+
+    *handle = index + 1;
+    return 0;
+}
+
+int invoke_pt_register(const char *module_filename, const double *mat_par, int n_mat_par, int *handle)
+{
+    return register_model(module_filename, mat_par, n_mat_par, false, handle);
+}
+
+int invoke_pt_vumat_register(const char *module_filename, const double *mat_par, int n_mat_par, int *handle)
+{
+    return register_model(module_filename, mat_par, n_mat_par, true, handle);
+}
+
+int invoke_pt_by_handle(int handle, const double *F, double *psi, double *Cauchy, double *DDSDDE)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+
+    RegisteredModel *model = find_registered_model(handle, false);
+    if (!model || !F || !psi || !Cauchy || !DDSDDE)
+    {
+        return 110;
+    }
+    const int n_mat_par = static_cast<int>(model->mat_par.size());
+
+    // Coalesced batches name their model once per batch anyway.
+    if (coalesce_window_us > 0 && coalesce_supported.load(std::memory_order_relaxed))
+    {
+        return invoke_pt(model->module_filename.c_str(), F, model->mat_par.data(), n_mat_par, psi, Cauchy, DDSDDE);
+    }
+
+    err = call_with_server_handle(*model, [&](int32_t server_handle, uint32_t epoch) {
+        const char *endpoint = abqnn::ipc::default_endpoint();
+        const size_t req_size = sizeof(server_handle) + sizeof(epoch) + 9 * sizeof(double);
+
+        abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+        req.put(server_handle);
+        req.put(epoch);
+        req.put_bytes(F, 9 * sizeof(double));
+
+        abqnn::ipc::PayloadView resp;
+        int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_UMAT_HANDLE_REQ, req.size(), ABQNN_MSG_UMAT_HANDLE_RESP,
+                                                   resp, ABQNN_IPC_FLAG_PACKED_DDSDDE);
+        if (tx_err != 0)
+        {
+            return tx_err;
+        }
+        return decode_umat_response(resp, psi, Cauchy, DDSDDE);
+    });
+    if (err != kHandleRetryNamed)
+    {
+        return err;
+    }
+
+    return invoke_pt_single(model->module_filename.c_str(), F, model->mat_par.data(), n_mat_par, psi, Cauchy, DDSDDE);
+}
+
+int invoke_pt_vumat_batch_by_handle(int handle,
+                                    const double *defgradF,
+                                    int nblock,
+                                    int ndir,
+                                    int nshr,
+                                    double *enerInternNew,
+                                    double *stressNew)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+
+    RegisteredModel *model = find_registered_model(handle, true);
+    if (!model)
+    {
+        return 110;
+    }
+    const int n_mat_par = static_cast<int>(model->mat_par.size());
+
+    err = check_vumat_args(model->module_filename.c_str(), defgradF, nblock, ndir, nshr,
+                           model->mat_par.data(), n_mat_par, enerInternNew, stressNew);
+    if (err != 0)
+    {
+        return err;
+    }
+
+    err = call_with_server_handle(*model, [&](int32_t server_handle, uint32_t epoch) {
+        int32_t nblock_i32 = static_cast<int32_t>(nblock);
+        int32_t ndir_i32 = static_cast<int32_t>(ndir);
+        int32_t nshr_i32 = static_cast<int32_t>(nshr);
+        const size_t ndefgrad = static_cast<size_t>(nblock) * static_cast<size_t>(ndir + 2 * nshr);
+
+        const char *endpoint = abqnn::ipc::default_endpoint();
+        const size_t req_size = sizeof(server_handle) + sizeof(epoch) + 3 * sizeof(int32_t) + ndefgrad * sizeof(double);
+
+        abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+        req.put(server_handle);
+        req.put(epoch);
+        req.put(nblock_i32);
+        req.put(ndir_i32);
+        req.put(nshr_i32);
+        req.put_bytes(defgradF, ndefgrad * sizeof(double));
+
+        abqnn::ipc::PayloadView resp;
+        int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_VUMAT_HANDLE_REQ, req.size(), ABQNN_MSG_VUMAT_HANDLE_RESP, resp);
+        if (tx_err != 0)
+        {
+            return tx_err;
+        }
+        return decode_vumat_response(resp, nblock, ndir, nshr, enerInternNew, stressNew);
+    });
+    if (err != kHandleRetryNamed)
+    {
+        return err;
+    }
+
+    return invoke_pt_vumat_batch(model->module_filename.c_str(), defgradF, nblock, ndir, nshr,
+                                 model->mat_par.data(), n_mat_par, enerInternNew, stressNew);
+}
+
+// A submitted call waiting for invoke_pt_wait. Its output pointers must stay
+// valid until then.
+struct AsyncCall
+{
+    abqnn::ipc::PendingTransaction tx;
+    bool vumat = false;
+
+    double *psi = nullptr;
+    double *Cauchy = nullptr;
+    double *DDSDDE = nullptr;
+
+    int nblock = 0;
+    int ndir = 0;
+    int nshr = 0;
+    double *enerInternNew = nullptr;
+    double *stressNew = nullptr;
+};
+
+static std::mutex async_mutex;
+static std::unordered_map<int, std::unique_ptr<AsyncCall>> async_calls;
+static int last_ticket = 0;
+
+// Sends the serialized call and files it under a new ticket (always > 0).
+static int submit_async_call(std::unique_ptr<AsyncCall> call, uint32_t request_type,
+                             uint32_t expected_response_type, int *ticket)
+{
+    int tx_err = abqnn::ipc::transact_submit(abqnn::ipc::default_endpoint(), request_type,
+                                             expected_response_type, call->tx);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    std::lock_guard<std::mutex> lock(async_mutex);
+    do
+    {
+        last_ticket = last_ticket == INT_MAX ? 1 : last_ticket + 1;
+    } while (async_calls.count(last_ticket) != 0);
+    *ticket = last_ticket;
+    async_calls.emplace(last_ticket, std::move(call));
     return 0;
-}
\ No newline at end of file
+}
+
+int invoke_pt_submit(const char *module_filename,
+                     const double *F, const double *mat_par, int n_mat_par,
+                     double *psi, double *Cauchy, double *DDSDDE,
+                     int *ticket)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+    if (!ticket)
+    {
+        return 110;
+    }
+    *ticket = 0;
+
+    err = check_umat_args(module_filename, F, mat_par, n_mat_par, psi, Cauchy, DDSDDE);
+    if (err != 0)
+    {
+        return err;
+    }
+
+    auto call = std::make_unique<AsyncCall>();
+    call->psi = psi;
+    call->Cauchy = Cauchy;
+    call->DDSDDE = DDSDDE;
+
+    const size_t req_size = umat_request_size(module_filename, n_mat_par);
+    call->tx.request.resize(req_size);
+    abqnn::ipc::PayloadWriter req(call->tx.request.data(), req_size);
+    write_umat_request(req, module_filename, F, mat_par, n_mat_par);
+    call->tx.request_flags = ABQNN_IPC_FLAG_PACKED_DDSDDE;
+
+    return submit_async_call(std::move(call), ABQNN_MSG_UMAT_REQ, ABQNN_MSG_UMAT_RESP, ticket);
+}
+
+int invoke_pt_vumat_batch_submit(const char *module_filename,
+                                 const double *defgradF,
+                                 int nblock,
+                                 int ndir,
+                                 int nshr,
+                                 const double *mat_par,
+                                 int n_mat_par,
+                                 double *enerInternNew,
+                                 double *stressNew,
+                                 int *ticket)
+{
+    int err = ensure_initialized();
+    if (err != 0)
+    {
+        return err;
+    }
+    if (!ticket)
+    {
+        return 110;
+    }
+    *ticket = 0;
+
+    err = check_vumat_args(module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par, enerInternNew, stressNew);
+    if (err != 0)
+    {
+        return err;
+    }
+
+    auto call = std::make_unique<AsyncCall>();
+    call->vumat = true;
+    call->nblock = nblock;
+    call->ndir = ndir;
+    call->nshr = nshr;
+    call->enerInternNew = enerInternNew;
+    call->stressNew = stressNew;
+
+    const size_t req_size = vumat_request_size<double>(module_filename, nblock, ndir, nshr, n_mat_par);
+    call->tx.request.resize(req_size);
+    abqnn::ipc::PayloadWriter req(call->tx.request.data(), req_size);
+    write_vumat_request(req, module_filename, defgradF, nblock, ndir, nshr, mat_par, n_mat_par);
+
+    return submit_async_call(std::move(call), ABQNN_MSG_VUMAT_REQ, ABQNN_MSG_VUMAT_RESP, ticket);
+}
+
+int invoke_pt_poll(int ticket, int *done)
+{
+    if (!done)
+    {
+        return 110;
+    }
+
+    std::lock_guard<std::mutex> lock(async_mutex);
+    auto it = async_calls.find(ticket);
+    if (it == async_calls.end())
+    {
+        return 110;
+    }
+    *done = abqnn::ipc::transact_ready(it->second->tx) ? 1 : 0;
+    return 0;
+}
+
+int invoke_pt_wait(int ticket)
+{
+    std::unique_ptr<AsyncCall> call;
+    {
+        std::lock_guard<std::mutex> lock(async_mutex);
+        auto it = async_calls.find(ticket);
+        if (it == async_calls.end())
+        {
+            return 110;
+        }
+        call = std::move(it->second);
+        async_calls.erase(it);
+    }
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_complete(call->tx, resp);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    if (call->vumat)
+    {
+        return decode_vumat_response(resp, call->nblock, call->ndir, call->nshr, call->enerInternNew, call->stressNew);
+    }
+    return decode_umat_response(resp, call->psi, call->Cauchy, call->DDSDDE);
+}
+
+int abqnn_server_stats(char *buffer, int buffer_size)
+{
+    if (!buffer || buffer_size <= 0)
+    {
+        return 110;
+    }
+    buffer[0] = '\0';
+
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    abqnn::ipc::acquire_request_buffer(endpoint, 0);
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_STATS_REQ, 0, ABQNN_MSG_STATS_RESP, resp);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    size_t off = 0;
+    int32_t status = 0;
+    uint32_t text_len = 0;
+    if (!abqnn::ipc::read_scalar(resp, off, status))
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+    if (status != 0)
+    {
+        return status;
+    }
+    if (!abqnn::ipc::read_scalar(resp, off, text_len) || off + text_len != resp.size)
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+
+    size_t n = std::min<size_t>(text_len, static_cast<size_t>(buffer_size) - 1);
+    std::memcpy(buffer, resp.data + off, n);
+    buffer[n] = '\0';
+    return 0;
+}
+
+int abqnn_reload_model(const char *module_filename)
+{
+    if (!module_filename)
+    {
+        return 110;
+    }
+
+    const char *endpoint = abqnn::ipc::default_endpoint();
+    uint32_t module_len = static_cast<uint32_t>(std::strlen(module_filename));
+    const size_t req_size = sizeof(module_len) + module_len;
+    abqnn::ipc::PayloadWriter req(abqnn::ipc::acquire_request_buffer(endpoint, req_size), req_size);
+    req.put(module_len);
+    req.put_bytes(module_filename, module_len);
+
+    abqnn::ipc::PayloadView resp;
+    int tx_err = abqnn::ipc::transact_in_place(endpoint, ABQNN_MSG_RELOAD_REQ, req_size, ABQNN_MSG_RELOAD_RESP, resp);
+    if (tx_err != 0)
+    {
+        return tx_err;
+    }
+
+    size_t off = 0;
+    int32_t status = 0;
+    if (!abqnn::ipc::read_scalar(resp, off, status) || off != resp.size)
+    {
+        return abqnn::ipc::ERR_IPC_PROTOCOL;
+    }
+    return status;
+}
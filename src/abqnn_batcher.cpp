@@ -0,0 +1,160 @@
+#include <algorithm>
+
+#include "abqnn_batcher.h"
+
+namespace abqnn::server {
+
+static size_t size_bucket(size_t size)
+{
+    size_t bucket = 0;
+    for (size_t limit = 1; limit < size && bucket + 1 < kBatchSizeBuckets; limit <<= 1)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+Batcher::Batcher(WorkerPool &pool, RunBatch run, size_t max_batch, std::chrono::microseconds max_wait)
+    : pool_(pool), run_(run), max_batch_(max_batch == 0 ? 1 : max_batch), max_wait_(max_wait)
+{
+    timer_ = std::thread(&Batcher::timer_main, this);
+}
+
+Batcher::~Batcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    timer_cv_.notify_all();
+    timer_.join();
+
+    for (auto &entry : open_)
+    {
+        delete entry.second;
+    }
+}
+
+void Batcher::add(const std::string &key, void *item)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Batch *&open = open_[key];
+    if (!open)
+    {
+        if (!free_.empty())
+        {
+            open = free_.back().release();
+            free_.pop_back();
+        }
+        else
+        {
+            open = new Batch();
+            open->owner = this;
+        }
+        open->full = false;
+        open->deadline = std::chrono::steady_clock::now() + max_wait_;
+        // Every deadline is its batch's creation time plus max_wait_, so a
+        // new batch never expires before the ones already open; the timer
+        // only needs a nudge when it was idle.
+        if (++open_count_ == 1)
+        {
+            timer_cv_.notify_one();
+        }
+    }
+
+    open->items.push_back(item);
+    if (open->items.size() < max_batch_)
+    {
+        return;
+    }
+
+    Batch *batch = open;
+    batch->full = true;
+    open = nullptr;
+    --open_count_;
+    lock.unlock();
+    execute(batch);
+}
+
+void Batcher::run_task(void *context)
+{
+    auto *batch = static_cast<Batch *>(context);
+    batch->owner->execute(batch);
+}
+
+void Batcher::execute(Batch *batch)
+{
+    const size_t size = batch->items.size();
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    items_.fetch_add(size, std::memory_order_relaxed);
+    (batch->full ? full_batches_ : timed_out_batches_).fetch_add(1, std::memory_order_relaxed);
+    histogram_[size_bucket(size)].fetch_add(1, std::memory_order_relaxed);
+
+    run_(batch->items);
+
+    batch->items.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.emplace_back(batch);
+}
+
+void Batcher::timer_main()
+{
+    std::vector<Batch *> expired;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        if (open_count_ == 0)
+        {
+            timer_cv_.wait(lock);
+            continue;
+        }
+
+        auto next = std::chrono::steady_clock::time_point::max();
+        for (auto &entry : open_)
+        {
+            if (entry.second)
+            {
+                next = std::min(next, entry.second->deadline);
+            }
+        }
+        if (timer_cv_.wait_until(lock, next) != std::cv_status::timeout && std::chrono::steady_clock::now() < next)
+        {
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (auto &entry : open_)
+        {
+            if (entry.second && entry.second->deadline <= now)
+            {
+                expired.push_back(entry.second);
+                entry.second = nullptr;
+                --open_count_;
+            }
+        }
+
+        lock.unlock();
+        for (Batch *batch : expired)
+        {
+            pool_.submit(Task{&Batcher::run_task, batch});
+        }
+        expired.clear();
+        lock.lock();
+    }
+}
+
+BatcherStats Batcher::stats() const
+{
+    BatcherStats s;
+    s.batches = batches_.load(std::memory_order_relaxed);
+    s.items = items_.load(std::memory_order_relaxed);
+    s.full_batches = full_batches_.load(std::memory_order_relaxed);
+    s.timed_out_batches = timed_out_batches_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kBatchSizeBuckets; ++i)
+    {
+        s.size_histogram[i] = histogram_[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+} // namespace abqnn::server
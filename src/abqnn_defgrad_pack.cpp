@@ -0,0 +1,101 @@
+#include <cstddef>
+
+#include "abqnn_defgrad_pack.h"
+
+#if defined(_MSC_VER)
+#define ABQNN_RESTRICT __restrict
+#else
+#define ABQNN_RESTRICT __restrict__
+#endif
+
+namespace abqnn::server {
+
+// One pass over the block: each point reads one element of every component
+// column and writes its 9 contiguous outputs. The columns are read
+// sequentially and nothing aliases, so the loop vectorizes as a strided store.
+template <typename T>
+static void pack_3d(const T *ABQNN_RESTRICT src, size_t n, T *ABQNN_RESTRICT out)
+{
+    const T *ABQNN_RESTRICT f11 = src;
+    const T *ABQNN_RESTRICT f22 = src + n;
+    const T *ABQNN_RESTRICT f33 = src + 2 * n;
+    const T *ABQNN_RESTRICT f12 = src + 3 * n;
+    const T *ABQNN_RESTRICT f23 = src + 4 * n;
+    const T *ABQNN_RESTRICT f31 = src + 5 * n;
+    const T *ABQNN_RESTRICT f21 = src + 6 * n;
+    const T *ABQNN_RESTRICT f32 = src + 7 * n;
+    const T *ABQNN_RESTRICT f13 = src + 8 * n;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        T *ABQNN_RESTRICT F = out + 9 * i;
+        F[0] = f11[i];
+        F[1] = f12[i];
+        F[2] = f13[i];
+        F[3] = f21[i];
+        F[4] = f22[i];
+        F[5] = f23[i];
+        F[6] = f31[i];
+        F[7] = f32[i];
+        F[8] = f33[i];
+    }
+}
+
+// Plane strain and axisymmetric elements: no out-of-plane shear.
+template <typename T>
+static void pack_plane(const T *ABQNN_RESTRICT src, size_t n, T *ABQNN_RESTRICT out)
+{
+    const T *ABQNN_RESTRICT f11 = src;
+    const T *ABQNN_RESTRICT f22 = src + n;
+    const T *ABQNN_RESTRICT f33 = src + 2 * n;
+    const T *ABQNN_RESTRICT f12 = src + 3 * n;
+    const T *ABQNN_RESTRICT f21 = src + 4 * n;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        T *ABQNN_RESTRICT F = out + 9 * i;
+        F[0] = f11[i];
+        F[1] = f12[i];
+        F[2] = T(0);
+        F[3] = f21[i];
+        F[4] = f22[i];
+        F[5] = T(0);
+        F[6] = T(0);
+        F[7] = T(0);
+        F[8] = f33[i];
+    }
+}
+
+template <typename T>
+static bool pack(const T *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, T *out)
+{
+    if (!defgradF || !out || nblock <= 0 || ndir != 3)
+    {
+        return false;
+    }
+
+    const size_t n = static_cast<size_t>(nblock);
+    if (nshr == 3)
+    {
+        pack_3d(defgradF, n, out);
+        return true;
+    }
+    if (nshr == 1)
+    {
+        pack_plane(defgradF, n, out);
+        return true;
+    }
+    return false;
+}
+
+bool pack_vumat_defgrad(const double *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, double *out)
+{
+    return pack(defgradF, nblock, ndir, nshr, out);
+}
+
+bool pack_vumat_defgrad(const float *defgradF, int32_t nblock, int32_t ndir, int32_t nshr, float *out)
+{
+    return pack(defgradF, nblock, ndir, nshr, out);
+}
+
+} // namespace abqnn::server
@@ -1,129 +1,861 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "abqnn_config.h"
 #include "abqnn_ipc_common.h"
 #include "abqnn_ipc_protocol.h"
 
+#ifdef ABQNN_IPC_SHARED_MEMORY
+#include "abqnn_ipc_shm.h"
+#endif
+
 namespace abqnn::ipc {
 
-static HANDLE connect_pipe_with_retry(const char* pipe_name)
+const char* default_endpoint()
+{
+    static const char* endpoint = []() {
+        const char* env = std::getenv("ABQNN_IPC_ENDPOINT");
+        return (env && *env) ? env : ABQNN_DEFAULT_ENDPOINT;
+    }();
+    return endpoint;
+}
+
+// request_flags only reach the server in v2 frames; a v1 header ends before them.
+static bool write_frame(Connection& conn,
+                        uint32_t version,
+                        uint32_t request_id,
+                        uint32_t request_type,
+                        uint32_t request_flags,
+                        const char* request_data,
+                        size_t request_size)
+{
+    AbqnnIpcHeader req_hdr{};
+    req_hdr.magic = ABQNN_IPC_MAGIC;
+    req_hdr.version = version;
+    req_hdr.message_type = request_type;
+    req_hdr.payload_size = static_cast<uint32_t>(request_size);
+    req_hdr.request_id = request_id;
+    req_hdr.flags = request_flags;
+
+    return conn.write_gather(&req_hdr, abqnn_ipc_header_size(version), request_data, request_size);
+}
+
+// Reads the header of a response frame sent in `version`.
+static int read_frame_header(Connection& conn, uint32_t version, AbqnnIpcHeader& resp_hdr)
 {
-    constexpr int kMaxAttempts = 50;
-    constexpr DWORD kWaitMs = 50;
+    resp_hdr = AbqnnIpcHeader{};
+    if (!conn.read_all(&resp_hdr, abqnn_ipc_header_size(version)))
+    {
+        return ERR_IPC_READ;
+    }
 
-    for (int attempt = 0; attempt < kMaxAttempts; ++attempt)
+    if (resp_hdr.magic != ABQNN_IPC_MAGIC ||
+        resp_hdr.version != version ||
+        resp_hdr.payload_size > ABQNN_IPC_MAX_PAYLOAD ||
+        (resp_hdr.flags & ABQNN_IPC_FLAG_ERROR) != 0)
     {
-        HANDLE pipe = CreateFileA(
-            pipe_name,
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            NULL,
-            OPEN_EXISTING,
-            0,
-            NULL);
+        return ERR_IPC_PROTOCOL;
+    }
+    return 0;
+}
 
-        if (pipe != INVALID_HANDLE_VALUE)
+// Reads the response to `request_id`, the only request in flight on `conn`.
+static int read_response_frame(Connection& conn,
+                               uint32_t version,
+                               uint32_t request_id,
+                               uint32_t expected_response_type,
+                               std::vector<char>& response_payload)
+{
+    AbqnnIpcHeader resp_hdr{};
+    int err = read_frame_header(conn, version, resp_hdr);
+    if (err != 0)
+    {
+        return err;
+    }
+    // v1 frames carry no request ID.
+    if (resp_hdr.message_type != expected_response_type ||
+        (version >= 2 && resp_hdr.request_id != request_id))
+    {
+        return ERR_IPC_PROTOCOL;
+    }
+
+    response_payload.resize(resp_hdr.payload_size);
+    if (resp_hdr.payload_size > 0 && !conn.read_all(response_payload.data(), resp_hdr.payload_size))
+    {
+        return ERR_IPC_READ;
+    }
+
+    return 0;
+}
+
+static int exchange_frames(Connection& conn,
+                           uint32_t version,
+                           uint32_t request_id,
+                           uint32_t request_type,
+                           uint32_t request_flags,
+                           const char* request_data,
+                           size_t request_size,
+                           uint32_t expected_response_type,
+                           std::vector<char>& response_payload)
+{
+    if (!write_frame(conn, version, request_id, request_type, request_flags, request_data, request_size))
+    {
+        return ERR_IPC_WRITE;
+    }
+    return read_response_frame(conn, version, request_id, expected_response_type, response_payload);
+}
+
+// Requests in flight at once in transact_pipelined. Bounds the responses the
+// server may have to buffer while this thread is still writing.
+static constexpr size_t kPipelineWindow = 32;
+
+// Sends requests with consecutive IDs starting at first_id, keeping at most
+// kPipelineWindow in flight, and files each response under its request ID.
+// `completed` counts the responses received, also on failure.
+static int pipeline_frames(Connection& conn,
+                           uint32_t first_id,
+                           uint32_t request_type,
+                           const std::vector<std::vector<char>>& request_payloads,
+                           uint32_t expected_response_type,
+                           std::vector<std::vector<char>>& response_payloads,
+                           size_t& completed)
+{
+    const size_t count = request_payloads.size();
+    std::vector<char> done(count, 0);
+    size_t sent = 0;
+    completed = 0;
+
+    while (completed < count)
+    {
+        while (sent < count && sent - completed < kPipelineWindow)
         {
-            return pipe;
+            const std::vector<char>& req = request_payloads[sent];
+            if (!write_frame(conn, ABQNN_IPC_VERSION, first_id + static_cast<uint32_t>(sent),
+                             request_type, 0, req.data(), req.size()))
+            {
+                return ERR_IPC_WRITE;
+            }
+            ++sent;
         }
 
-        DWORD err = GetLastError();
-        if (err == ERROR_PIPE_BUSY)
+        AbqnnIpcHeader resp_hdr{};
+        int err = read_frame_header(conn, ABQNN_IPC_VERSION, resp_hdr);
+        if (err != 0)
         {
-            if (!WaitNamedPipeA(pipe_name, kWaitMs))
+            return err;
+        }
+
+        const size_t index = static_cast<uint32_t>(resp_hdr.request_id - first_id);
+        if (index >= sent || done[index] || resp_hdr.message_type != expected_response_type)
+        {
+            return ERR_IPC_PROTOCOL;
+        }
+
+        std::vector<char>& resp = response_payloads[index];
+        resp.resize(resp_hdr.payload_size);
+        if (resp_hdr.payload_size > 0 && !conn.read_all(resp.data(), resp_hdr.payload_size))
+        {
+            return ERR_IPC_READ;
+        }
+        done[index] = 1;
+        ++completed;
+    }
+    return 0;
+}
+
+#ifdef ABQNN_IPC_PERSISTENT_CONNECTIONS
+
+// One long-lived connection per calling thread. The handle is closed when the
+// thread exits, or as soon as an exchange on it fails.
+struct ThreadConnection
+{
+    std::unique_ptr<Connection> conn;
+    std::string endpoint;
+    // Set when the connection was opened for the current request, so a failure
+    // on it cannot be blamed on staleness.
+    bool fresh = false;
+
+    // Endpoint the negotiated state below belongs to; it survives reconnects.
+    std::string peer;
+    // Lowered to ABQNN_IPC_MIN_VERSION when the server drops a v2 frame and
+    // then answers the same request in v1.
+    uint32_t version = ABQNN_IPC_VERSION;
+    uint32_t next_request_id = 0;
+
+    std::vector<char> request;
+    std::vector<char> response;
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+    std::unique_ptr<shm::Region> region;
+    uint32_t slot = 0;
+    bool request_in_slot = false;
+    // Cleared when a server does not understand ABQNN_MSG_SHM_ATTACH_REQ, so
+    // later reconnects to the same endpoint skip the attach round trip.
+    bool try_attach = true;
+#endif
+
+    void close()
+    {
+#ifdef ABQNN_IPC_SHARED_MEMORY
+        region.reset();
+#endif
+        conn.reset();
+        endpoint.clear();
+    }
+};
+
+static thread_local ThreadConnection tls_connection;
+
+// A server that predates protocol v2 closes the connection on the first v2
+// frame. Called when the first exchange on a fresh connection failed to read:
+// switches this thread to v1 and reconnects for a retry. If the retry fails
+// as well, the version was not the cause and the caller restores it. Returns
+// false if the thread already speaks v1, i.e. the failure has another cause.
+static bool downgrade_protocol()
+{
+    ThreadConnection& tc = tls_connection;
+    if (tc.version <= ABQNN_IPC_MIN_VERSION)
+    {
+        return false;
+    }
+    tc.version = ABQNN_IPC_MIN_VERSION;
+    tc.conn = connect_with_retry(tc.endpoint.c_str());
+    return true;
+}
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+
+static constexpr int kShmOverflow = -1;
+static constexpr int kShmPollMs = 100;
+
+// Best effort: on any failure the connection simply stays stream-only.
+static void attach_shared_memory()
+{
+    ThreadConnection& tc = tls_connection;
+    std::vector<char> resp;
+    int err = exchange_frames(*tc.conn, tc.version, tc.next_request_id++,
+                              ABQNN_MSG_SHM_ATTACH_REQ, 0, nullptr, 0, ABQNN_MSG_SHM_ATTACH_RESP, resp);
+    const bool downgraded = err == ERR_IPC_READ && downgrade_protocol();
+    if (downgraded)
+    {
+        if (!tc.conn)
+        {
+            tc.version = ABQNN_IPC_VERSION;
+            return;
+        }
+        err = exchange_frames(*tc.conn, tc.version, 0,
+                              ABQNN_MSG_SHM_ATTACH_REQ, 0, nullptr, 0, ABQNN_MSG_SHM_ATTACH_RESP, resp);
+    }
+    if (err != 0)
+    {
+        if (downgraded)
+        {
+            tc.version = ABQNN_IPC_VERSION;
+        }
+        // A server without shared-memory support drops the connection on the
+        // unknown message type; reconnect and do not ask again.
+        tc.try_attach = false;
+        tc.conn = connect_with_retry(tc.endpoint.c_str());
+        return;
+    }
+
+    PayloadView view{resp.data(), resp.size()};
+    size_t off = 0;
+    int32_t status = 0;
+    uint64_t server_pid = 0;
+    uint32_t slot = 0;
+    if (!read_scalar(view, off, status) || status != 0 ||
+        !read_scalar(view, off, server_pid) || !read_scalar(view, off, slot))
+    {
+        return;
+    }
+
+    std::unique_ptr<shm::Region> region = shm::Region::open(shm::region_name_for_pid(server_pid));
+    if (!region || slot >= region->header()->slot_count)
+    {
+        return;
+    }
+
+    tc.region = std::move(region);
+    tc.slot = slot;
+}
+
+// Moves a request that was serialized into the slot into the stream buffer,
+// so it can be resent after the slot became unusable.
+static void spill_slot_request(size_t payload_size)
+{
+    ThreadConnection& tc = tls_connection;
+    if (!tc.request_in_slot)
+    {
+        return;
+    }
+    tc.request.assign(tc.region->slot_data(tc.slot), tc.region->slot_data(tc.slot) + payload_size);
+    tc.request_in_slot = false;
+}
+
+static int exchange_slot(uint32_t request_type,
+                         uint32_t request_flags,
+                         size_t payload_size,
+                         uint32_t expected_response_type,
+                         PayloadView& response)
+{
+    ThreadConnection& tc = tls_connection;
+    shm::SlotHeader* hdr = tc.region->slot(tc.slot);
+
+    hdr->message_type = request_type;
+    hdr->payload_size = static_cast<uint32_t>(payload_size);
+    hdr->flags = request_flags;
+    tc.region->post_request(tc.slot);
+
+    const uint64_t server_pid = tc.region->header()->server_pid;
+    while (!tc.region->wait_for_reply(tc.slot, kShmPollMs))
+    {
+        if (!shm::process_alive(server_pid))
+        {
+            return ERR_IPC_READ;
+        }
+    }
+
+    const uint32_t state = hdr->state.load(std::memory_order_acquire);
+    // Nothing else touches the slot until this thread posts its next request,
+    // so it can be handed back before the response is decoded.
+    hdr->state.store(shm::SLOT_IDLE, std::memory_order_relaxed);
+
+    if (state == shm::SLOT_OVERFLOW)
+    {
+        return kShmOverflow;
+    }
+    if (state != shm::SLOT_RESPONSE ||
+        hdr->message_type != expected_response_type ||
+        hdr->payload_size > tc.region->header()->slot_capacity)
+    {
+        return ERR_IPC_PROTOCOL;
+    }
+
+    response.data = tc.region->slot_data(tc.slot);
+    response.size = hdr->payload_size;
+    return 0;
+}
+
+#endif // ABQNN_IPC_SHARED_MEMORY
+
+static int ensure_connected(const char* endpoint)
+{
+    ThreadConnection& tc = tls_connection;
+    if (tc.conn && tc.endpoint == endpoint)
+    {
+        return 0;
+    }
+
+    tc.close();
+    if (tc.peer != endpoint)
+    {
+        tc.peer = endpoint;
+        tc.version = ABQNN_IPC_VERSION;
+#ifdef ABQNN_IPC_SHARED_MEMORY
+        tc.try_attach = true;
+#endif
+    }
+
+    tc.conn = connect_with_retry(endpoint);
+    if (!tc.conn)
+    {
+        return ERR_IPC_CONNECT;
+    }
+    tc.endpoint = endpoint;
+    tc.fresh = true;
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+    if (tc.try_attach)
+    {
+        attach_shared_memory();
+        if (!tc.conn)
+        {
+            tc.endpoint.clear();
+            return ERR_IPC_CONNECT;
+        }
+    }
+#endif
+    return 0;
+}
+
+char* acquire_request_buffer(const char* endpoint, size_t payload_size)
+{
+    ThreadConnection& tc = tls_connection;
+    // A connect failure is reported by transact_in_place; hand out the stream
+    // buffer so the caller can still serialize.
+    ensure_connected(endpoint);
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+    tc.request_in_slot = tc.region && payload_size <= tc.region->header()->slot_capacity;
+    if (tc.request_in_slot)
+    {
+        return tc.region->slot_data(tc.slot);
+    }
+#endif
+
+    tc.request.resize(payload_size);
+    return tc.request.data();
+}
+
+int transact_in_place(const char* endpoint,
+                      uint32_t request_type,
+                      size_t payload_size,
+                      uint32_t expected_response_type,
+                      PayloadView& response,
+                      uint32_t request_flags)
+{
+    ThreadConnection& tc = tls_connection;
+
+    // A reused connection may have been dropped by the server (restart, idle
+    // disconnect) since the last call; retry exactly once on a fresh one.
+    // Requests are pure functions of their payload, so resending is safe.
+    // A fresh connection dropped in v2 is retried in v1, so a stale reused
+    // one can take three attempts.
+    bool downgraded = false;
+    for (int attempt = 0; attempt < 3; ++attempt)
+    {
+        if (ensure_connected(endpoint) != 0)
+        {
+            if (downgraded)
             {
-                DWORD wait_err = GetLastError();
-                if (wait_err != ERROR_SEM_TIMEOUT)
+                tc.version = ABQNN_IPC_VERSION;
+            }
+            return ERR_IPC_CONNECT;
+        }
+        const bool reused = !tc.fresh;
+        bool via_stream = true;
+
+        int err = 0;
+#ifdef ABQNN_IPC_SHARED_MEMORY
+        if (tc.request_in_slot)
+        {
+            err = exchange_slot(request_type, request_flags, payload_size, expected_response_type, response);
+            if (err == kShmOverflow)
+            {
+                // Response too large for the slot: the request is still intact
+                // there, so repeat it over the stream.
+                spill_slot_request(payload_size);
+            }
+        }
+        via_stream = !tc.request_in_slot;
+        if (via_stream)
+#endif
+        {
+            err = exchange_frames(*tc.conn, tc.version, tc.next_request_id++,
+                                  request_type, request_flags, tc.request.data(), payload_size,
+                                  expected_response_type, tc.response);
+            response.data = tc.response.data();
+            response.size = tc.response.size();
+        }
+
+        if (err == 0)
+        {
+            tc.fresh = false;
+            return 0;
+        }
+
+#ifdef ABQNN_IPC_SHARED_MEMORY
+        spill_slot_request(payload_size);
+#endif
+        tc.close();
+        if (!reused && via_stream && err == ERR_IPC_READ)
+        {
+            if (tc.version > ABQNN_IPC_MIN_VERSION)
+            {
+                // The server dropped the first v2 frame: retry in v1.
+                tc.version = ABQNN_IPC_MIN_VERSION;
+                downgraded = true;
+                continue;
+            }
+            if (downgraded)
+            {
+                // Dropped in v1 too: the server did not drop the frame for its version.
+                tc.version = ABQNN_IPC_VERSION;
+            }
+            // A server that predates this message type drops the connection.
+            return ERR_IPC_UNSUPPORTED;
+        }
+        if (downgraded)
+        {
+            tc.version = ABQNN_IPC_VERSION;
+            return err;
+        }
+        if (!reused || err == ERR_IPC_PROTOCOL)
+        {
+            return err;
+        }
+    }
+    return ERR_IPC_CONNECT;
+}
+
+int transact_pipelined(const char* endpoint,
+                       uint32_t request_type,
+                       const std::vector<std::vector<char>>& request_payloads,
+                       uint32_t expected_response_type,
+                       std::vector<std::vector<char>>& response_payloads)
+{
+    ThreadConnection& tc = tls_connection;
+    response_payloads.resize(request_payloads.size());
+
+    bool downgraded = false;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (ensure_connected(endpoint) != 0)
+        {
+            return ERR_IPC_CONNECT;
+        }
+
+        if (tc.version < 2)
+        {
+            // v1 has no request IDs: one round trip per request.
+            for (size_t i = 0; i < request_payloads.size(); ++i)
+            {
+                int err = transact_blocking(endpoint, request_type, request_payloads[i],
+                                            expected_response_type, response_payloads[i]);
+                if (err != 0)
                 {
-                    break;
+                    if (downgraded && i == 0)
+                    {
+                        // Not even v1 got through: keep v2 (see transact_in_place).
+                        tc.version = ABQNN_IPC_VERSION;
+                    }
+                    return err;
                 }
             }
-            continue;
+            return 0;
+        }
+
+        const bool reused = !tc.fresh;
+        const uint32_t first_id = tc.next_request_id;
+        tc.next_request_id += static_cast<uint32_t>(request_payloads.size());
+
+        size_t completed = 0;
+        int err = pipeline_frames(*tc.conn, first_id, request_type, request_payloads,
+                                  expected_response_type, response_payloads, completed);
+        if (err == 0)
+        {
+            tc.fresh = false;
+            return 0;
+        }
+
+        // Responses still in flight would be misread by the next exchange.
+        tc.close();
+        if (completed > 0 || err == ERR_IPC_PROTOCOL)
+        {
+            return err;
+        }
+        if (!reused)
+        {
+            if (err != ERR_IPC_READ)
+            {
+                return err;
+            }
+            tc.version = ABQNN_IPC_MIN_VERSION;
+            downgraded = true;
         }
-        break;
     }
-    return INVALID_HANDLE_VALUE;
+    return ERR_IPC_CONNECT;
 }
 
-bool write_all(HANDLE h, const void* data, size_t n)
+void close_thread_connection()
 {
-    const char* p = static_cast<const char*>(data);
-    size_t sent = 0;
-    while (sent < n)
+    tls_connection.close();
+}
+
+#else
+
+static thread_local std::vector<char> tls_request;
+static thread_local std::vector<char> tls_response;
+// Lowered to ABQNN_IPC_MIN_VERSION once a server dropped a v2 frame and then
+// answered the same request in v1.
+static thread_local uint32_t tls_version = ABQNN_IPC_VERSION;
+
+char* acquire_request_buffer(const char* /*endpoint*/, size_t payload_size)
+{
+    tls_request.resize(payload_size);
+    return tls_request.data();
+}
+
+int transact_in_place(const char* endpoint,
+                      uint32_t request_type,
+                      size_t payload_size,
+                      uint32_t expected_response_type,
+                      PayloadView& response,
+                      uint32_t request_flags)
+{
+    bool downgraded = false;
+    while (true)
     {
-        DWORD wrote = 0;
-        if (!WriteFile(h, p + sent, static_cast<DWORD>(n - sent), &wrote, NULL) || wrote == 0)
+        std::unique_ptr<Connection> conn = connect_with_retry(endpoint);
+        if (!conn)
+        {
+            if (downgraded)
+            {
+                tls_version = ABQNN_IPC_VERSION;
+            }
+            return ERR_IPC_CONNECT;
+        }
+
+        int err = exchange_frames(*conn, tls_version, 0, request_type, request_flags, tls_request.data(), payload_size,
+                                  expected_response_type, tls_response);
+        if (err == ERR_IPC_READ && tls_version > ABQNN_IPC_MIN_VERSION)
+        {
+            tls_version = ABQNN_IPC_MIN_VERSION;
+            downgraded = true;
+            continue;
+        }
+        if (err != 0 && downgraded)
         {
-            return false;
+            // Failed in v1 too: the server did not drop the frame for its version.
+            tls_version = ABQNN_IPC_VERSION;
         }
-        sent += wrote;
+        if (err == ERR_IPC_READ)
+        {
+            // A server that predates this message type drops the connection.
+            err = ERR_IPC_UNSUPPORTED;
+        }
+        response.data = tls_response.data();
+        response.size = tls_response.size();
+        return err;
     }
-    return true;
 }
 
-bool read_all(HANDLE h, void* data, size_t n)
+int transact_pipelined(const char* endpoint,
+                       uint32_t request_type,
+                       const std::vector<std::vector<char>>& request_payloads,
+                       uint32_t expected_response_type,
+                       std::vector<std::vector<char>>& response_payloads)
 {
-    char* p = static_cast<char*>(data);
-    size_t got = 0;
-    while (got < n)
+    response_payloads.resize(request_payloads.size());
+    bool downgraded = false;
+    if (tls_version >= 2 && !request_payloads.empty())
     {
-        DWORD read_n = 0;
-        if (!ReadFile(h, p + got, static_cast<DWORD>(n - got), &read_n, NULL) || read_n == 0)
+        std::unique_ptr<Connection> conn = connect_with_retry(endpoint);
+        if (!conn)
         {
-            return false;
+            return ERR_IPC_CONNECT;
         }
-        got += read_n;
+
+        size_t completed = 0;
+        int err = pipeline_frames(*conn, 0, request_type, request_payloads,
+                                  expected_response_type, response_payloads, completed);
+        if (err != ERR_IPC_READ || completed > 0)
+        {
+            return err;
+        }
+        tls_version = ABQNN_IPC_MIN_VERSION;
+        downgraded = true;
     }
-    return true;
+
+    for (size_t i = 0; i < request_payloads.size(); ++i)
+    {
+        int err = transact_blocking(endpoint, request_type, request_payloads[i],
+                                    expected_response_type, response_payloads[i]);
+        if (err != 0)
+        {
+            if (downgraded && i == 0)
+            {
+                tls_version = ABQNN_IPC_VERSION;
+            }
+            return err;
+        }
+    }
+    return 0;
 }
 
-int transact_blocking(const char* pipe_name,
-                     uint32_t request_type,
-                     const std::vector<char>& request_payload,
-                     uint32_t expected_response_type,
-                     std::vector<char>& response_payload)
+void close_thread_connection()
+{
+}
+
+#endif // ABQNN_IPC_PERSISTENT_CONNECTIONS
+
+// Protocol version and idle connections of one endpoint, shared by all
+// submitted transactions.
+struct AsyncEndpoint
 {
-    HANDLE pipe = connect_pipe_with_retry(pipe_name);
+    uint32_t version = ABQNN_IPC_VERSION;
+    std::vector<std::unique_ptr<Connection>> idle;
+};
+
+static constexpr size_t kMaxIdleAsyncConnections = 16;
+
+static std::mutex async_mutex;
+static std::unordered_map<std::string, AsyncEndpoint> async_endpoints;
+static std::atomic<uint32_t> next_async_request_id{0};
 
-    if (pipe == INVALID_HANDLE_VALUE)
+// Takes an idle connection to the endpoint if `allow_reuse`, else opens one.
+static int open_async_connection(PendingTransaction& pending, bool allow_reuse)
+{
     {
-        return ERR_IPC_CONNECT;
+        std::lock_guard<std::mutex> lock(async_mutex);
+        AsyncEndpoint& ep = async_endpoints[pending.endpoint];
+        pending.version = ep.version;
+        pending.reused = allow_reuse && !ep.idle.empty();
+        if (pending.reused)
+        {
+            pending.conn = std::move(ep.idle.back());
+            ep.idle.pop_back();
+            return 0;
+        }
     }
 
-    AbqnnIpcHeader req_hdr{};
-    req_hdr.magic = ABQNN_IPC_MAGIC;
-    req_hdr.version = ABQNN_IPC_VERSION;
-    req_hdr.message_type = request_type;
-    req_hdr.payload_size = static_cast<uint32_t>(request_payload.size());
+    pending.conn = connect_with_retry(pending.endpoint.c_str());
+    return pending.conn ? 0 : ERR_IPC_CONNECT;
+}
+
+static void release_async_connection(PendingTransaction& pending)
+{
+#ifdef ABQNN_IPC_PERSISTENT_CONNECTIONS
+    std::lock_guard<std::mutex> lock(async_mutex);
+    AsyncEndpoint& ep = async_endpoints[pending.endpoint];
+    if (ep.idle.size() < kMaxIdleAsyncConnections)
+    {
+        ep.idle.push_back(std::move(pending.conn));
+    }
+#endif
+    pending.conn.reset();
+}
+
+// A v1 server drops the connection on a v2 frame. The request is then resent
+// in v1, and only an answer to it moves the whole endpoint to v1.
+static void confirm_async_version(const PendingTransaction& pending)
+{
+    std::lock_guard<std::mutex> lock(async_mutex);
+    AsyncEndpoint& ep = async_endpoints[pending.endpoint];
+    ep.version = std::min(ep.version, pending.version);
+}
 
-    if (!write_all(pipe, &req_hdr, sizeof(req_hdr)) ||
-        (!request_payload.empty() && !write_all(pipe, request_payload.data(), request_payload.size())))
+static int send_pending(PendingTransaction& pending)
+{
+    pending.request_id = next_async_request_id.fetch_add(1, std::memory_order_relaxed);
+    if (!write_frame(*pending.conn, pending.version, pending.request_id, pending.request_type,
+                     pending.request_flags, pending.request.data(), pending.request.size()))
     {
-        CloseHandle(pipe);
+        pending.conn.reset();
         return ERR_IPC_WRITE;
     }
+    return 0;
+}
 
-    AbqnnIpcHeader resp_hdr{};
-    if (!read_all(pipe, &resp_hdr, sizeof(resp_hdr)))
+int transact_submit(const char* endpoint,
+                    uint32_t request_type,
+                    uint32_t expected_response_type,
+                    PendingTransaction& pending)
+{
+    pending.endpoint = endpoint;
+    pending.request_type = request_type;
+    pending.expected_response_type = expected_response_type;
+
+    int err = open_async_connection(pending, true);
+    if (err == 0)
     {
-        CloseHandle(pipe);
-        return ERR_IPC_READ;
+        err = send_pending(pending);
+    }
+    if (err == ERR_IPC_WRITE)
+    {
+        // Either the idle connection went stale, or a v1 server dropped a
+        // fresh one on the v2 header. Requests are pure, so resend.
+        const bool downgrade = !pending.reused;
+        if (downgrade && pending.version <= ABQNN_IPC_MIN_VERSION)
+        {
+            return err;
+        }
+        err = open_async_connection(pending, false);
+        if (downgrade)
+        {
+            pending.version = ABQNN_IPC_MIN_VERSION;
+        }
+        if (err == 0)
+        {
+            err = send_pending(pending);
+        }
     }
+    return err;
+}
 
-    if (resp_hdr.magic != ABQNN_IPC_MAGIC ||
-        resp_hdr.version != ABQNN_IPC_VERSION ||
-        resp_hdr.message_type != expected_response_type ||
-        resp_hdr.payload_size > ABQNN_IPC_MAX_PAYLOAD)
+bool transact_ready(PendingTransaction& pending)
+{
+    return !pending.conn || pending.conn->readable();
+}
+
+int transact_complete(PendingTransaction& pending, PayloadView& response)
+{
+    if (!pending.conn)
     {
-        CloseHandle(pipe);
-        return ERR_IPC_PROTOCOL;
+        return ERR_IPC_CONNECT;
     }
 
-    response_payload.resize(resp_hdr.payload_size);
-    if (resp_hdr.payload_size > 0 && !read_all(pipe, response_payload.data(), resp_hdr.payload_size))
+    // A stale idle connection is resent on a fresh one, and a fresh one that a
+    // v1 server dropped is resent in v1, so the answer can take three reads.
+    constexpr int kMaxReads = 3;
+    for (int attempt = 0;; ++attempt)
     {
-        CloseHandle(pipe);
-        return ERR_IPC_READ;
+        int err = read_response_frame(*pending.conn, pending.version, pending.request_id,
+                                      pending.expected_response_type, pending.response);
+        if (err == 0)
+        {
+            if (pending.version < ABQNN_IPC_VERSION)
+            {
+                confirm_async_version(pending);
+            }
+            release_async_connection(pending);
+            response.data = pending.response.data();
+            response.size = pending.response.size();
+            return 0;
+        }
+
+        pending.conn.reset();
+        if (err != ERR_IPC_READ || attempt + 1 == kMaxReads)
+        {
+            return err;
+        }
+        const bool downgrade = !pending.reused;
+        if (downgrade && pending.version <= ABQNN_IPC_MIN_VERSION)
+        {
+            return err;
+        }
+
+        // Resend on a fresh connection, after a stale idle one or in v1.
+        err = open_async_connection(pending, false);
+        if (downgrade)
+        {
+            pending.version = ABQNN_IPC_MIN_VERSION;
+        }
+        if (err == 0)
+        {
+            err = send_pending(pending);
+        }
+        if (err != 0)
+        {
+            return err;
+        }
     }
+}
 
-    CloseHandle(pipe);
+int transact_blocking(const char* endpoint,
+                     uint32_t request_type,
+                     const std::vector<char>& request_payload,
+                     uint32_t expected_response_type,
+                     std::vector<char>& response_payload)
+{
+    char* out = acquire_request_buffer(endpoint, request_payload.size());
+    if (!request_payload.empty())
+    {
+        std::memcpy(out, request_payload.data(), request_payload.size());
+    }
+
+    PayloadView response;
+    int err = transact_in_place(endpoint, request_type, request_payload.size(), expected_response_type, response);
+    if (err != 0)
+    {
+        return err;
+    }
+    response_payload.assign(response.data, response.data + response.size);
     return 0;
 }
 
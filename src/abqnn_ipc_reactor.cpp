@@ -0,0 +1,134 @@
+#include "abqnn_ipc_reactor.h"
+
+namespace abqnn::ipc {
+
+ReactorRequest* Reactor::acquire_request()
+{
+    {
+        std::lock_guard<std::mutex> lock(free_mutex_);
+        if (!free_requests_.empty())
+        {
+            ReactorRequest* request = free_requests_.back().release();
+            free_requests_.pop_back();
+            return request;
+        }
+    }
+    return new ReactorRequest();
+}
+
+void Reactor::recycle(ReactorRequest* request)
+{
+    request->connection.reset();
+    request->response.clear();
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    free_requests_.emplace_back(request);
+}
+
+// Header bytes expected for the frame being assembled: the v1 prefix first,
+// then the rest of the header once the version is known.
+static size_t header_bytes(const AbqnnIpcHeader& header, size_t got)
+{
+    return got < ABQNN_IPC_V1_HEADER_SIZE ? ABQNN_IPC_V1_HEADER_SIZE : abqnn_ipc_header_size(header.version);
+}
+
+void Reactor::receive_window(ReactorConnection& conn, char*& data, size_t& size)
+{
+    if (!conn.request_)
+    {
+        data = reinterpret_cast<char*>(&conn.header_) + conn.header_got_;
+        size = header_bytes(conn.header_, conn.header_got_) - conn.header_got_;
+        return;
+    }
+    data = conn.request_->payload.data() + conn.payload_got_;
+    size = conn.request_->payload.size() - conn.payload_got_;
+}
+
+bool Reactor::received(const std::shared_ptr<ReactorConnection>& conn, size_t n)
+{
+    ReactorConnection& c = *conn;
+    if (!c.request_)
+    {
+        c.header_got_ += n;
+        if (c.header_got_ == ABQNN_IPC_V1_HEADER_SIZE &&
+            (c.header_.magic != ABQNN_IPC_MAGIC ||
+             c.header_.version < ABQNN_IPC_MIN_VERSION ||
+             c.header_.version > ABQNN_IPC_VERSION ||
+             c.header_.payload_size > ABQNN_IPC_MAX_PAYLOAD))
+        {
+            return false;
+        }
+        if (c.header_got_ < header_bytes(c.header_, c.header_got_))
+        {
+            return true;
+        }
+
+        c.request_ = acquire_request();
+        c.request_->header = c.header_;
+        c.request_->payload.resize(c.header_.payload_size);
+        c.payload_got_ = 0;
+    }
+    else
+    {
+        c.payload_got_ += n;
+    }
+
+    if (c.payload_got_ < c.request_->payload.size())
+    {
+        return true;
+    }
+
+    ReactorRequest* request = c.request_;
+    request->connection = conn;
+    c.request_ = nullptr;
+    c.header_ = AbqnnIpcHeader{};
+    c.header_got_ = 0;
+    handler_.on_request(request);
+    return true;
+}
+
+void Reactor::closed(ReactorConnection& conn)
+{
+    if (conn.request_)
+    {
+        recycle(conn.request_);
+        conn.request_ = nullptr;
+    }
+    handler_.on_close(conn);
+}
+
+void Reactor::reply(ReactorRequest* request)
+{
+    // Answer in the version the request was sent with.
+    AbqnnIpcHeader header{};
+    header.magic = ABQNN_IPC_MAGIC;
+    header.version = request->header.version;
+    header.message_type = request->response_type;
+    header.payload_size = static_cast<uint32_t>(request->response.size());
+    header.request_id = request->header.request_id;
+    header.flags = 0;
+
+    request->connection->write_frame(header, request->response.data(), request->response.size());
+    recycle(request);
+}
+
+void Reactor::reject(ReactorRequest* request)
+{
+    if (request->header.version >= 2)
+    {
+        // Other requests may be in flight on this connection; fail only this one.
+        AbqnnIpcHeader header{};
+        header.magic = ABQNN_IPC_MAGIC;
+        header.version = request->header.version;
+        header.message_type = request->header.message_type;
+        header.request_id = request->header.request_id;
+        header.flags = ABQNN_IPC_FLAG_ERROR;
+        request->connection->write_frame(header, nullptr, 0);
+    }
+    else
+    {
+        request->connection->shutdown();
+    }
+    recycle(request);
+}
+
+} // namespace abqnn::ipc
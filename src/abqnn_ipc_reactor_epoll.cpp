@@ -0,0 +1,349 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "abqnn_ipc_reactor.h"
+
+namespace abqnn::ipc {
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+// A peer that does not drain its socket for this long is dropped, so a stuck
+// client cannot hold an inference worker.
+constexpr int kWriteTimeoutMs = 5000;
+
+class EpollConnection final : public ReactorConnection
+{
+public:
+    explicit EpollConnection(int fd) : fd_(fd) {}
+
+    ~EpollConnection() override
+    {
+        ::close(fd_);
+    }
+
+    int fd() const { return fd_; }
+
+    bool write_frame(const AbqnnIpcHeader& header, const char* payload, size_t size) override
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+
+        // Header and payload leave in one gather write.
+        iovec iov[2];
+        iov[0].iov_base = const_cast<AbqnnIpcHeader*>(&header);
+        iov[0].iov_len = abqnn_ipc_header_size(header.version);
+        iov[1].iov_base = const_cast<char*>(payload);
+        iov[1].iov_len = size;
+        iovec* cur = iov;
+        int count = size > 0 ? 2 : 1;
+
+        while (count > 0)
+        {
+            msghdr msg{};
+            msg.msg_iov = cur;
+            msg.msg_iovlen = static_cast<size_t>(count);
+            ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    pollfd p{fd_, POLLOUT, 0};
+                    if (::poll(&p, 1, kWriteTimeoutMs) > 0)
+                    {
+                        continue;
+                    }
+                }
+                shutdown();
+                return false;
+            }
+
+            size_t left = static_cast<size_t>(sent);
+            while (count > 0 && left >= cur->iov_len)
+            {
+                left -= cur->iov_len;
+                ++cur;
+                --count;
+            }
+            if (count > 0)
+            {
+                cur->iov_base = static_cast<char*>(cur->iov_base) + left;
+                cur->iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+    void shutdown() override
+    {
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+
+    // Registration reference: keeps the connection alive while it is in the
+    // epoll set. Dropped by the I/O thread that closes it.
+    std::shared_ptr<EpollConnection> self;
+
+private:
+    int fd_;
+    std::mutex write_mutex_;
+};
+
+class EpollReactor final : public Reactor
+{
+public:
+    EpollReactor(ReactorHandler& handler, int epoll_fd, int listen_fd, std::string path,
+                 size_t io_threads, size_t max_connections)
+        : Reactor(handler), epoll_fd_(epoll_fd), listen_fd_(listen_fd), path_(std::move(path)),
+          io_threads_(io_threads == 0 ? 1 : io_threads)
+    {
+        max_connections_ = max_connections;
+    }
+
+    ~EpollReactor() override
+    {
+        ::close(epoll_fd_);
+        ::close(listen_fd_);
+        ::unlink(path_.c_str());
+    }
+
+    int run() override
+    {
+        // Every fd is registered EPOLLONESHOT, so one shared epoll set can be
+        // served by several threads without two of them reading the same
+        // connection; the serving thread re-arms it when done.
+        if (!arm(listen_fd_, nullptr, EPOLL_CTL_ADD))
+        {
+            return 2;
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < io_threads_; ++i)
+        {
+            threads.emplace_back(&EpollReactor::io_loop, this);
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        return 2;
+    }
+
+private:
+    bool arm(int fd, EpollConnection* conn, int op)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        if (conn)
+        {
+            ev.events |= EPOLLRDHUP;
+        }
+        ev.data.ptr = conn;
+        return ::epoll_ctl(epoll_fd_, op, fd, &ev) == 0;
+    }
+
+    void io_loop()
+    {
+        epoll_event events[kMaxEvents];
+        while (true)
+        {
+            int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return;
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                if (events[i].data.ptr == nullptr)
+                {
+                    accept_ready();
+                }
+                else
+                {
+                    serve(static_cast<EpollConnection*>(events[i].data.ptr)->self);
+                }
+            }
+        }
+    }
+
+    void accept_ready()
+    {
+        while (true)
+        {
+            if (max_connections_ > 0)
+            {
+                // Leave further clients in the listen backlog; close_connection
+                // re-arms the listener.
+                std::lock_guard<std::mutex> lock(accept_mutex_);
+                if (connections_.load() >= max_connections_)
+                {
+                    accept_paused_ = true;
+                    return;
+                }
+            }
+
+            int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+                if (errno == EMFILE || errno == ENFILE)
+                {
+                    // Out of descriptors: back off instead of spinning on the
+                    // still-readable listener.
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                break;
+            }
+
+            auto conn = std::make_shared<EpollConnection>(fd);
+            conn->self = conn;
+            connections_.fetch_add(1);
+            if (!arm(fd, conn.get(), EPOLL_CTL_ADD))
+            {
+                conn->self.reset();
+                connections_.fetch_sub(1);
+            }
+        }
+        arm(listen_fd_, nullptr, EPOLL_CTL_MOD);
+    }
+
+    void serve(std::shared_ptr<EpollConnection> conn)
+    {
+        std::shared_ptr<ReactorConnection> base = conn;
+        bool open = true;
+        while (open)
+        {
+            char* data = nullptr;
+            size_t size = 0;
+            receive_window(*conn, data, size);
+
+            ssize_t n = ::recv(conn->fd(), data, size, 0);
+            if (n > 0)
+            {
+                open = received(base, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                break;
+            }
+            open = false;
+        }
+
+        if (open && arm(conn->fd(), conn.get(), EPOLL_CTL_MOD))
+        {
+            return;
+        }
+        close_connection(*conn);
+    }
+
+    void close_connection(EpollConnection& conn)
+    {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd(), nullptr);
+        // The descriptor stays open until workers drop their references; make
+        // the peer see the close now.
+        conn.shutdown();
+        closed(conn);
+        conn.self.reset();
+        connections_.fetch_sub(1);
+
+        std::lock_guard<std::mutex> lock(accept_mutex_);
+        if (accept_paused_)
+        {
+            accept_paused_ = false;
+            arm(listen_fd_, nullptr, EPOLL_CTL_MOD);
+        }
+    }
+
+    int epoll_fd_;
+    int listen_fd_;
+    std::string path_;
+    size_t io_threads_;
+
+    std::mutex accept_mutex_;
+    bool accept_paused_ = false;
+};
+
+} // namespace
+
+std::unique_ptr<Reactor> Reactor::create(const char* endpoint, ReactorHandler& handler,
+                                         size_t io_threads, size_t max_connections)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    size_t len = std::strlen(endpoint);
+    if (len == 0 || len >= sizeof(addr.sun_path))
+    {
+        return nullptr;
+    }
+    std::memcpy(addr.sun_path, endpoint, len);
+
+    int listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+    {
+        return nullptr;
+    }
+
+    // A stale socket file from a previous server run would make bind() fail,
+    // but one a running server still listens on is not ours to remove: if a
+    // connect succeeds (or only finds the backlog full), give up instead.
+    int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+    {
+        ::close(listen_fd);
+        return nullptr;
+    }
+    const bool in_use = ::connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0 ||
+                        errno == EAGAIN;
+    ::close(probe);
+    if (in_use)
+    {
+        ::close(listen_fd);
+        return nullptr;
+    }
+    ::unlink(endpoint);
+
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, SOMAXCONN) != 0)
+    {
+        ::close(listen_fd);
+        return nullptr;
+    }
+
+    int epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0)
+    {
+        ::close(listen_fd);
+        ::unlink(endpoint);
+        return nullptr;
+    }
+
+    return std::make_unique<EpollReactor>(handler, epoll_fd, listen_fd, endpoint, io_threads, max_connections);
+}
+
+} // namespace abqnn::ipc
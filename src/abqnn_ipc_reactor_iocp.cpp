@@ -0,0 +1,371 @@
+#include <windows.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "abqnn_ipc_reactor.h"
+
+namespace abqnn::ipc {
+
+namespace {
+
+// Pipe instances kept waiting for a client, so a burst of connecting solver
+// threads does not see ERROR_PIPE_BUSY.
+constexpr size_t kPendingAccepts = 8;
+// A peer that does not drain its pipe for this long is dropped, so a stuck
+// client cannot hold an inference worker.
+constexpr DWORD kWriteTimeoutMs = 5000;
+
+enum class OpKind
+{
+    Accept,
+    Read
+};
+
+class PipeConnection;
+
+// Every overlapped operation queued on the port starts with one of these, so
+// the I/O thread can tell accepts from reads.
+struct Operation
+{
+    OVERLAPPED overlapped{};
+    OpKind kind = OpKind::Read;
+};
+
+struct PendingAccept
+{
+    Operation op;
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+};
+
+struct ReadOp
+{
+    Operation op;
+    PipeConnection* conn = nullptr;
+};
+
+class PipeConnection final : public ReactorConnection
+{
+public:
+    explicit PipeConnection(HANDLE pipe) : pipe_(pipe)
+    {
+        read.op.kind = OpKind::Read;
+        read.conn = this;
+        write_event_ = CreateEventA(NULL, TRUE, FALSE, NULL);
+    }
+
+    ~PipeConnection() override
+    {
+        CloseHandle(pipe_);
+        if (write_event_)
+        {
+            CloseHandle(write_event_);
+        }
+    }
+
+    HANDLE handle() const { return pipe_; }
+
+    bool write_frame(const AbqnnIpcHeader& header, const char* payload, size_t size) override
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        const size_t header_size = abqnn_ipc_header_size(header.version);
+        bool ok = false;
+        if (header_size + size <= kMaxStagedFrame)
+        {
+            // Pipes have no gather write: stage small frames so the header
+            // and payload leave in one WriteFile.
+            staging_.resize(header_size + size);
+            std::memcpy(staging_.data(), &header, header_size);
+            if (size > 0)
+            {
+                std::memcpy(staging_.data() + header_size, payload, size);
+            }
+            ok = write_all(staging_.data(), staging_.size());
+        }
+        else
+        {
+            ok = write_all(&header, header_size) && write_all(payload, size);
+        }
+        if (!ok)
+        {
+            shutdown();
+            return false;
+        }
+        return true;
+    }
+
+    void shutdown() override
+    {
+        // Fails the pending read, which makes the I/O thread close the connection.
+        DisconnectNamedPipe(pipe_);
+    }
+
+    ReadOp read;
+
+    // Registration reference: keeps the connection alive while a read is
+    // queued on the port. Dropped by the I/O thread that closes it.
+    std::shared_ptr<PipeConnection> self;
+
+private:
+    bool write_all(const void* data, size_t n)
+    {
+        if (!write_event_)
+        {
+            return false;
+        }
+
+        const char* p = static_cast<const char*>(data);
+        size_t sent = 0;
+        while (sent < n)
+        {
+            // Waited for on this thread; the event keeps the completion off the port.
+            OVERLAPPED ov{};
+            ov.hEvent = write_event_;
+            ResetEvent(write_event_);
+
+            DWORD wrote = 0;
+            if (!WriteFile(pipe_, p + sent, static_cast<DWORD>(n - sent), NULL, &ov) &&
+                GetLastError() != ERROR_IO_PENDING)
+            {
+                return false;
+            }
+            if (WaitForSingleObject(write_event_, kWriteTimeoutMs) != WAIT_OBJECT_0)
+            {
+                CancelIoEx(pipe_, &ov);
+                WaitForSingleObject(write_event_, INFINITE);
+                return false;
+            }
+            if (!GetOverlappedResult(pipe_, &ov, &wrote, FALSE) || wrote == 0)
+            {
+                return false;
+            }
+            sent += wrote;
+        }
+        return true;
+    }
+
+    static constexpr size_t kMaxStagedFrame = 64 * 1024;
+
+    HANDLE pipe_;
+    HANDLE write_event_ = NULL;
+    std::mutex write_mutex_;
+    std::vector<char> staging_; // guarded by write_mutex_
+};
+
+class IocpReactor final : public Reactor
+{
+public:
+    IocpReactor(ReactorHandler& handler, HANDLE port, std::string pipe_name,
+                size_t io_threads, size_t max_connections)
+        : Reactor(handler), port_(port), pipe_name_(std::move(pipe_name)),
+          io_threads_(io_threads == 0 ? 1 : io_threads)
+    {
+        max_connections_ = max_connections;
+    }
+
+    ~IocpReactor() override
+    {
+        for (auto& pa : accepts_)
+        {
+            if (pa->pipe != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(pa->pipe);
+            }
+        }
+        CloseHandle(port_);
+    }
+
+    int run() override
+    {
+        for (size_t i = 0; i < kPendingAccepts; ++i)
+        {
+            accepts_.push_back(std::make_unique<PendingAccept>());
+            accepts_.back()->op.kind = OpKind::Accept;
+            if (!post_accept(*accepts_.back()))
+            {
+                return 2;
+            }
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < io_threads_; ++i)
+        {
+            threads.emplace_back(&IocpReactor::io_loop, this);
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        return 2;
+    }
+
+private:
+    bool post_accept(PendingAccept& pa)
+    {
+        pa.pipe = CreateNamedPipeA(
+            pipe_name_.c_str(),
+            PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+            PIPE_UNLIMITED_INSTANCES,
+            ABQNN_IPC_MAX_PAYLOAD,
+            ABQNN_IPC_MAX_PAYLOAD,
+            0,
+            NULL);
+        if (pa.pipe == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        if (!CreateIoCompletionPort(pa.pipe, port_, 0, 0))
+        {
+            CloseHandle(pa.pipe);
+            pa.pipe = INVALID_HANDLE_VALUE;
+            return false;
+        }
+
+        pa.op.overlapped = OVERLAPPED{};
+        if (!ConnectNamedPipe(pa.pipe, &pa.op.overlapped))
+        {
+            DWORD err = GetLastError();
+            if (err == ERROR_PIPE_CONNECTED)
+            {
+                // The client beat us to it; no packet is queued in this case.
+                PostQueuedCompletionStatus(port_, 0, 0, &pa.op.overlapped);
+            }
+            else if (err != ERROR_IO_PENDING)
+            {
+                CloseHandle(pa.pipe);
+                pa.pipe = INVALID_HANDLE_VALUE;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void io_loop()
+    {
+        while (true)
+        {
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* ov = nullptr;
+            BOOL ok = GetQueuedCompletionStatus(port_, &bytes, &key, &ov, INFINITE);
+            if (!ov)
+            {
+                return;
+            }
+
+            Operation* op = CONTAINING_RECORD(ov, Operation, overlapped);
+            if (op->kind == OpKind::Accept)
+            {
+                accepted(*reinterpret_cast<PendingAccept*>(op), ok);
+            }
+            else
+            {
+                PipeConnection* raw = reinterpret_cast<ReadOp*>(op)->conn;
+                read_done(raw->self, ok, bytes);
+            }
+        }
+    }
+
+    void accepted(PendingAccept& pa, BOOL ok)
+    {
+        HANDLE pipe = pa.pipe;
+        pa.pipe = INVALID_HANDLE_VALUE;
+
+        if (ok)
+        {
+            auto conn = std::make_shared<PipeConnection>(pipe);
+            conn->self = conn;
+            connections_.fetch_add(1);
+            start_read(conn);
+        }
+        else
+        {
+            CloseHandle(pipe);
+        }
+
+        if (max_connections_ > 0)
+        {
+            // Leave further clients waiting on the pipe; close_connection
+            // puts the instance back.
+            std::lock_guard<std::mutex> lock(accept_mutex_);
+            if (connections_.load() >= max_connections_)
+            {
+                parked_.push_back(&pa);
+                return;
+            }
+        }
+        post_accept(pa);
+    }
+
+    void start_read(const std::shared_ptr<PipeConnection>& conn)
+    {
+        char* data = nullptr;
+        size_t size = 0;
+        receive_window(*conn, data, size);
+
+        conn->read.op.overlapped = OVERLAPPED{};
+        if (!ReadFile(conn->handle(), data, static_cast<DWORD>(size), NULL, &conn->read.op.overlapped) &&
+            GetLastError() != ERROR_IO_PENDING)
+        {
+            close_connection(*conn);
+        }
+    }
+
+    void read_done(std::shared_ptr<PipeConnection> conn, BOOL ok, DWORD bytes)
+    {
+        if (!ok || bytes == 0 || !received(conn, bytes))
+        {
+            close_connection(*conn);
+            return;
+        }
+        start_read(conn);
+    }
+
+    void close_connection(PipeConnection& conn)
+    {
+        conn.shutdown();
+        closed(conn);
+        conn.self.reset();
+        connections_.fetch_sub(1);
+
+        PendingAccept* pa = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(accept_mutex_);
+            if (!parked_.empty())
+            {
+                pa = parked_.back();
+                parked_.pop_back();
+            }
+        }
+        if (pa)
+        {
+            post_accept(*pa);
+        }
+    }
+
+    HANDLE port_;
+    std::string pipe_name_;
+    size_t io_threads_;
+
+    std::vector<std::unique_ptr<PendingAccept>> accepts_;
+    std::mutex accept_mutex_;
+    std::vector<PendingAccept*> parked_;
+};
+
+} // namespace
+
+std::unique_ptr<Reactor> Reactor::create(const char* endpoint, ReactorHandler& handler,
+                                         size_t io_threads, size_t max_connections)
+{
+    HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, static_cast<DWORD>(io_threads));
+    if (!port)
+    {
+        return nullptr;
+    }
+    return std::make_unique<IocpReactor>(handler, port, endpoint, io_threads, max_connections);
+}
+
+} // namespace abqnn::ipc
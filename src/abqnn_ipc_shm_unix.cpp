@@ -0,0 +1,248 @@
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "abqnn_ipc_shm.h"
+
+namespace abqnn::ipc::shm {
+
+namespace {
+
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+#ifdef __linux__
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::nanoseconds timeout)
+{
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    // Not FUTEX_PRIVATE_FLAG: the word lives in memory shared with another process.
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+#else
+void futex_wait(std::atomic<uint32_t>*, uint32_t, std::chrono::nanoseconds timeout)
+{
+    std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds(50)));
+}
+
+void futex_wake(std::atomic<uint32_t>*)
+{
+}
+#endif
+
+// Spins, then sleeps on `word` until done(value) holds. If `sleeper` is given
+// it is raised around the sleep so the waker can skip the syscall otherwise.
+template <typename Done>
+bool wait_until(std::atomic<uint32_t>& state, int timeout_ms, Done done, std::atomic<uint32_t>* sleeper = nullptr)
+{
+    for (int i = 0; i < SPIN_ITERATIONS; ++i)
+    {
+        if (done(state.load(std::memory_order_acquire)))
+        {
+            return true;
+        }
+        cpu_relax();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true)
+    {
+        uint32_t cur = state.load(std::memory_order_acquire);
+        if (done(cur))
+        {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return false;
+        }
+        if (sleeper)
+        {
+            sleeper->store(1, std::memory_order_seq_cst);
+            cur = state.load(std::memory_order_seq_cst);
+            if (done(cur))
+            {
+                sleeper->store(0, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        futex_wait(&state, cur, deadline - now);
+        if (sleeper)
+        {
+            sleeper->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+class PosixRegion final : public Region
+{
+public:
+    PosixRegion(std::string name, void* base, size_t size, bool owner)
+        : name_(std::move(name)), size_(size), owner_(owner)
+    {
+        base_ = static_cast<char*>(base);
+        header_ = reinterpret_cast<RegionHeader*>(base_);
+    }
+
+    ~PosixRegion() override
+    {
+        munmap(base_, size_);
+        if (owner_)
+        {
+            shm_unlink(name_.c_str());
+        }
+    }
+
+    void post_request(uint32_t i) override
+    {
+        slot(i)->state.store(SLOT_REQUEST, std::memory_order_release);
+        header_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+        if (header_->server_waiting.load(std::memory_order_seq_cst) != 0)
+        {
+            futex_wake(&header_->doorbell);
+        }
+    }
+
+    void post_reply(uint32_t i, SlotState state) override
+    {
+        slot(i)->state.store(state, std::memory_order_release);
+        futex_wake(&slot(i)->state);
+    }
+
+    bool wait_for_requests(uint32_t& seen, int timeout_ms) override
+    {
+        const uint32_t last = seen;
+        return wait_until(header_->doorbell, timeout_ms,
+                          [&](uint32_t v) { seen = v; return v != last; },
+                          &header_->server_waiting);
+    }
+
+    bool wait_for_reply(uint32_t i, int timeout_ms) override
+    {
+        return wait_until(slot(i)->state, timeout_ms, [](uint32_t s) { return s >= SLOT_RESPONSE; });
+    }
+
+private:
+    std::string name_;
+    size_t size_;
+    bool owner_;
+};
+
+} // namespace
+
+std::unique_ptr<Region> Region::create(const std::string& name, uint32_t slot_count, uint64_t slot_capacity)
+{
+    const size_t size = region_size_for(slot_count, slot_capacity);
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // ftruncate zero-fills, so every slot starts out as SLOT_FREE.
+    auto* header = static_cast<RegionHeader*>(base);
+    header->slot_count = slot_count;
+    header->slot_capacity = slot_capacity;
+    header->slot_stride = slot_stride_for(slot_capacity);
+    header->server_pid = current_pid();
+    header->version = REGION_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = REGION_MAGIC;
+
+    return std::unique_ptr<Region>(new PosixRegion(name, base, size, true));
+}
+
+std::unique_ptr<Region> Region::open(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < SLOTS_OFFSET)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    auto* header = static_cast<RegionHeader*>(base);
+    if (header->magic != REGION_MAGIC || header->version != REGION_VERSION ||
+        region_size_for(header->slot_count, header->slot_capacity) > size)
+    {
+        munmap(base, size);
+        return nullptr;
+    }
+
+    return std::unique_ptr<Region>(new PosixRegion(name, base, size, false));
+}
+
+std::string region_name_for_pid(uint64_t pid)
+{
+    return "/abqnn_shm_" + std::to_string(pid);
+}
+
+uint64_t current_pid()
+{
+    return static_cast<uint64_t>(getpid());
+}
+
+bool process_alive(uint64_t pid)
+{
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+} // namespace abqnn::ipc::shm
@@ -0,0 +1,261 @@
+#include <windows.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "abqnn_ipc_shm.h"
+
+namespace abqnn::ipc::shm {
+
+namespace {
+
+// One auto-reset event per slot for the client, plus the server's doorbell event.
+std::string event_name(const std::string& region_name, uint32_t slot)
+{
+    return region_name + "_" + std::to_string(slot) + "_c";
+}
+
+std::string doorbell_name(const std::string& region_name)
+{
+    return region_name + "_door";
+}
+
+// Spins, then sleeps on `event` until done(value) holds. If `sleeper` is given
+// it is raised around the sleep so the waker can skip SetEvent otherwise.
+template <typename Done>
+bool wait_until(std::atomic<uint32_t>& state, HANDLE event, int timeout_ms, Done done,
+                std::atomic<uint32_t>* sleeper = nullptr)
+{
+    for (int i = 0; i < SPIN_ITERATIONS; ++i)
+    {
+        if (done(state.load(std::memory_order_acquire)))
+        {
+            return true;
+        }
+        YieldProcessor();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true)
+    {
+        if (done(state.load(std::memory_order_acquire)))
+        {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return false;
+        }
+        if (sleeper)
+        {
+            sleeper->store(1, std::memory_order_seq_cst);
+            if (done(state.load(std::memory_order_seq_cst)))
+            {
+                sleeper->store(0, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+        WaitForSingleObject(event, static_cast<DWORD>(remaining > 0 ? remaining : 1));
+        if (sleeper)
+        {
+            sleeper->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+class Win32Region final : public Region
+{
+public:
+    Win32Region(HANDLE mapping, void* base, HANDLE doorbell, std::vector<HANDLE> client_events)
+        : mapping_(mapping), doorbell_(doorbell), client_events_(std::move(client_events))
+    {
+        base_ = static_cast<char*>(base);
+        header_ = reinterpret_cast<RegionHeader*>(base_);
+    }
+
+    ~Win32Region() override
+    {
+        CloseHandle(doorbell_);
+        for (HANDLE h : client_events_)
+        {
+            CloseHandle(h);
+        }
+        UnmapViewOfFile(base_);
+        CloseHandle(mapping_);
+    }
+
+    void post_request(uint32_t i) override
+    {
+        slot(i)->state.store(SLOT_REQUEST, std::memory_order_release);
+        header_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+        if (header_->server_waiting.load(std::memory_order_seq_cst) != 0)
+        {
+            SetEvent(doorbell_);
+        }
+    }
+
+    void post_reply(uint32_t i, SlotState state) override
+    {
+        slot(i)->state.store(state, std::memory_order_release);
+        SetEvent(client_events_[i]);
+    }
+
+    bool wait_for_requests(uint32_t& seen, int timeout_ms) override
+    {
+        const uint32_t last = seen;
+        return wait_until(header_->doorbell, doorbell_, timeout_ms,
+                          [&](uint32_t v) { seen = v; return v != last; },
+                          &header_->server_waiting);
+    }
+
+    bool wait_for_reply(uint32_t i, int timeout_ms) override
+    {
+        return wait_until(slot(i)->state, client_events_[i], timeout_ms, [](uint32_t s) { return s >= SLOT_RESPONSE; });
+    }
+
+private:
+    HANDLE mapping_;
+    HANDLE doorbell_;
+    std::vector<HANDLE> client_events_;
+};
+
+void close_all(std::vector<HANDLE>& handles)
+{
+    for (HANDLE h : handles)
+    {
+        CloseHandle(h);
+    }
+    handles.clear();
+}
+
+HANDLE open_event(const std::string& name, bool create)
+{
+    return create ? CreateEventA(NULL, FALSE, FALSE, name.c_str())
+                  : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+}
+
+bool open_events(const std::string& name, uint32_t slot_count, bool create,
+                 HANDLE& doorbell, std::vector<HANDLE>& client_events)
+{
+    doorbell = open_event(doorbell_name(name), create);
+    if (!doorbell)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < slot_count; ++i)
+    {
+        HANDLE c = open_event(event_name(name, i), create);
+        if (!c)
+        {
+            CloseHandle(doorbell);
+            doorbell = NULL;
+            close_all(client_events);
+            return false;
+        }
+        client_events.push_back(c);
+    }
+    return true;
+}
+
+} // namespace
+
+std::unique_ptr<Region> Region::create(const std::string& name, uint32_t slot_count, uint64_t slot_capacity)
+{
+    const uint64_t size = region_size_for(slot_count, slot_capacity);
+
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFFu),
+                                        name.c_str());
+    if (!mapping)
+    {
+        return nullptr;
+    }
+
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!base)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    HANDLE doorbell = NULL;
+    std::vector<HANDLE> client_events;
+    if (!open_events(name, slot_count, true, doorbell, client_events))
+    {
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    // Page-file backed mappings are zero-filled, so every slot starts out as SLOT_FREE.
+    auto* header = static_cast<RegionHeader*>(base);
+    header->slot_count = slot_count;
+    header->slot_capacity = slot_capacity;
+    header->slot_stride = slot_stride_for(slot_capacity);
+    header->server_pid = current_pid();
+    header->version = REGION_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = REGION_MAGIC;
+
+    return std::unique_ptr<Region>(new Win32Region(mapping, base, doorbell, std::move(client_events)));
+}
+
+std::unique_ptr<Region> Region::open(const std::string& name)
+{
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (!mapping)
+    {
+        return nullptr;
+    }
+
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!base)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    MEMORY_BASIC_INFORMATION info{};
+    VirtualQuery(base, &info, sizeof(info));
+
+    auto* header = static_cast<RegionHeader*>(base);
+    HANDLE doorbell = NULL;
+    std::vector<HANDLE> client_events;
+    if (header->magic != REGION_MAGIC || header->version != REGION_VERSION ||
+        region_size_for(header->slot_count, header->slot_capacity) > info.RegionSize ||
+        !open_events(name, header->slot_count, false, doorbell, client_events))
+    {
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+        return nullptr;
+    }
+
+    return std::unique_ptr<Region>(new Win32Region(mapping, base, doorbell, std::move(client_events)));
+}
+
+std::string region_name_for_pid(uint64_t pid)
+{
+    return "Local\\abqnn_shm_" + std::to_string(pid);
+}
+
+uint64_t current_pid()
+{
+    return static_cast<uint64_t>(GetCurrentProcessId());
+}
+
+bool process_alive(uint64_t pid)
+{
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+    if (!process)
+    {
+        return false;
+    }
+    bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+}
+
+} // namespace abqnn::ipc::shm
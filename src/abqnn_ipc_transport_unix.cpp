@@ -0,0 +1,204 @@
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "abqnn_ipc_transport.h"
+
+namespace abqnn::ipc {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool fill_socket_address(const char* endpoint, sockaddr_un& addr)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t len = std::strlen(endpoint);
+    if (len == 0 || len >= sizeof(addr.sun_path))
+    {
+        return false;
+    }
+    std::memcpy(addr.sun_path, endpoint, len);
+    return true;
+}
+
+class UnixSocketConnection final : public Connection
+{
+public:
+    explicit UnixSocketConnection(int fd) : fd_(fd)
+    {
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    }
+
+    ~UnixSocketConnection() override
+    {
+        close();
+    }
+
+    bool write_all(const void* data, size_t n) override
+    {
+        const char* p = static_cast<const char*>(data);
+        size_t sent = 0;
+        while (sent < n)
+        {
+            ssize_t wrote = ::send(fd_, p + sent, n - sent, kSendFlags);
+            if (wrote < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (wrote <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(wrote);
+        }
+        return true;
+    }
+
+    bool write_gather(const void* head, size_t head_size, const void* body, size_t body_size) override
+    {
+        iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(head);
+        iov[0].iov_len = head_size;
+        iov[1].iov_base = const_cast<void*>(body);
+        iov[1].iov_len = body_size;
+        iovec* cur = iov;
+        int count = body_size > 0 ? 2 : 1;
+
+        while (count > 0)
+        {
+            msghdr msg{};
+            msg.msg_iov = cur;
+            msg.msg_iovlen = static_cast<size_t>(count);
+            ssize_t sent = ::sendmsg(fd_, &msg, kSendFlags);
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            size_t left = static_cast<size_t>(sent);
+            while (count > 0 && left >= cur->iov_len)
+            {
+                left -= cur->iov_len;
+                ++cur;
+                --count;
+            }
+            if (count > 0)
+            {
+                cur->iov_base = static_cast<char*>(cur->iov_base) + left;
+                cur->iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+    bool read_all(void* data, size_t n) override
+    {
+        char* p = static_cast<char*>(data);
+        size_t got = 0;
+        while (got < n)
+        {
+            ssize_t read_n = ::recv(fd_, p + got, n - got, 0);
+            if (read_n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (read_n <= 0)
+            {
+                return false;
+            }
+            got += static_cast<size_t>(read_n);
+        }
+        return true;
+    }
+
+    bool readable() override
+    {
+        if (fd_ < 0)
+        {
+            return true;
+        }
+        pollfd pfd{fd_, POLLIN, 0};
+        int n = 0;
+        do
+        {
+            n = ::poll(&pfd, 1, 0);
+        } while (n < 0 && errno == EINTR);
+        return n != 0;
+    }
+
+    void close() override
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+private:
+    int fd_;
+};
+
+} // namespace
+
+std::unique_ptr<Connection> connect_with_retry(const char* endpoint)
+{
+    constexpr int kMaxAttempts = 50;
+    constexpr auto kWait = std::chrono::milliseconds(50);
+
+    sockaddr_un addr{};
+    if (!fill_socket_address(endpoint, addr))
+    {
+        return nullptr;
+    }
+
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt)
+    {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0)
+        {
+            return std::make_unique<UnixSocketConnection>(fd);
+        }
+
+        int err = errno;
+        ::close(fd);
+
+        // EAGAIN: listen backlog full, the Unix-socket equivalent of ERROR_PIPE_BUSY.
+        if (err == EAGAIN || err == EINTR)
+        {
+            std::this_thread::sleep_for(kWait);
+            continue;
+        }
+        break;
+    }
+    return nullptr;
+}
+
+} // namespace abqnn::ipc
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <vector>
+
+#include <windows.h>
+
+#include "abqnn_ipc_protocol.h"
+#include "abqnn_ipc_transport.h"
+
+namespace abqnn::ipc {
+
+namespace {
+
+class NamedPipeConnection final : public Connection
+{
+public:
+    explicit NamedPipeConnection(HANDLE pipe) : pipe_(pipe) {}
+
+    ~NamedPipeConnection() override
+    {
+        close();
+    }
+
+    bool write_all(const void* data, size_t n) override
+    {
+        const char* p = static_cast<const char*>(data);
+        size_t sent = 0;
+        while (sent < n)
+        {
+            DWORD wrote = 0;
+            if (!WriteFile(pipe_, p + sent, static_cast<DWORD>(n - sent), &wrote, NULL) || wrote == 0)
+            {
+                return false;
+            }
+            sent += wrote;
+        }
+        return true;
+    }
+
+    // WriteFile cannot gather from a pipe, so small frames are staged into
+    // one buffer (kept for the next frame) and written at once.
+    bool write_gather(const void* head, size_t head_size, const void* body, size_t body_size) override
+    {
+        if (head_size + body_size > kMaxStagedFrame)
+        {
+            return write_all(head, head_size) && write_all(body, body_size);
+        }
+        staging_.resize(head_size + body_size);
+        std::memcpy(staging_.data(), head, head_size);
+        if (body_size > 0)
+        {
+            std::memcpy(staging_.data() + head_size, body, body_size);
+        }
+        return write_all(staging_.data(), staging_.size());
+    }
+
+    bool read_all(void* data, size_t n) override
+    {
+        char* p = static_cast<char*>(data);
+        size_t got = 0;
+        while (got < n)
+        {
+            DWORD read_n = 0;
+            if (!ReadFile(pipe_, p + got, static_cast<DWORD>(n - got), &read_n, NULL) || read_n == 0)
+            {
+                return false;
+            }
+            got += read_n;
+        }
+        return true;
+    }
+
+    bool readable() override
+    {
+        DWORD available = 0;
+        // A broken pipe fails the peek; report it readable so read_all fails.
+        return !PeekNamedPipe(pipe_, NULL, 0, NULL, &available, NULL) || available > 0;
+    }
+
+    void close() override
+    {
+        if (pipe_ == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        CloseHandle(pipe_);
+        pipe_ = INVALID_HANDLE_VALUE;
+    }
+
+private:
+    static constexpr size_t kMaxStagedFrame = 64 * 1024;
+
+    HANDLE pipe_;
+    std::vector<char> staging_;
+};
+
+} // namespace
+
+std::unique_ptr<Connection> connect_with_retry(const char* endpoint)
+{
+    constexpr int kMaxAttempts = 50;
+    constexpr DWORD kWaitMs = 50;
+
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt)
+    {
+        HANDLE pipe = CreateFileA(
+            endpoint,
+            GENERIC_READ | GENERIC_WRITE,
+            0,
+            NULL,
+            OPEN_EXISTING,
+            0,
+            NULL);
+
+        if (pipe != INVALID_HANDLE_VALUE)
+        {
+            return std::make_unique<NamedPipeConnection>(pipe);
+        }
+
+        DWORD err = GetLastError();
+        if (err == ERROR_PIPE_BUSY)
+        {
+            if (!WaitNamedPipeA(endpoint, kWaitMs))
+            {
+                DWORD wait_err = GetLastError();
+                if (wait_err != ERROR_SEM_TIMEOUT)
+                {
+                    break;
+                }
+            }
+            continue;
+        }
+        break;
+    }
+    return nullptr;
+}
+
+} // namespace abqnn::ipc
@@ -0,0 +1,566 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "abqnn_mlp_energy.h"
+
+#if defined(_MSC_VER)
+#define ABQNN_RESTRICT __restrict
+#else
+#define ABQNN_RESTRICT __restrict__
+#endif
+
+namespace abqnn::server {
+
+// Points per tile. Each unit of a layer holds kComps rows of one value per
+// lane, so a layer of width w needs up to w * kComps * kTile doubles (40 KiB
+// for w = 16).
+static constexpr int kTile = 32;
+// A partial tile is evaluated on its points rounded up to this many lanes.
+static constexpr int kLaneStep = 8;
+
+// Per unit: value, gradient in the three invariants, then the Hessian entries
+// (00, 11, 22, 01, 02, 12).
+static constexpr int kComps = 10;
+
+// Voigt pairs shared by the UMAT outputs and the symmetric 3x3 storage below.
+static constexpr int kVoigt[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
+
+struct MlpEnergyModel::Tile
+{
+    int count = 0;
+    int lanes = 0;         // count rounded up to kLaneStep; the row length of a and z
+    double x[3][kTile];    // I1bar - 3, I2bar - 3, J - 1
+    double J[kTile];
+    double I1[kTile];
+    double I2[kTile];
+    double m[6][kTile];    // b = F F^T (UMAT) or C = F^T F (VUMAT), Voigt order
+    std::vector<double> a; // layer activations, unit-major
+    std::vector<double> z; // layer pre-activations, unit-major
+};
+
+bool MlpEnergyModel::load(const std::string &path, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    std::stringstream text;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        text << line.substr(0, line.find('#')) << '\n';
+    }
+
+    std::string magic, key;
+    int version = 0;
+    int32_t mat_par_inputs = 0, n_layers = 0;
+    if (!(text >> magic >> version) || magic != "abqnn-mlp-energy" || version != 1)
+    {
+        error = path + ": not an abqnn-mlp-energy version 1 file";
+        return false;
+    }
+    if (!(text >> key >> mat_par_inputs) || key != "mat_par_inputs" || mat_par_inputs < 0)
+    {
+        error = path + ": expected mat_par_inputs <K>";
+        return false;
+    }
+    if (!(text >> key >> n_layers) || key != "layers" || n_layers <= 0)
+    {
+        error = path + ": expected layers <N>";
+        return false;
+    }
+
+    std::vector<Layer> layers;
+    std::vector<double> weights;
+    int32_t width = 3 + mat_par_inputs;
+    int32_t max_width = 1;
+    for (int32_t l = 0; l < n_layers; ++l)
+    {
+        Layer layer;
+        std::string activation;
+        if (!(text >> key >> layer.in >> layer.out >> activation) || key != "layer")
+        {
+            error = path + ": expected layer <in> <out> <activation> for layer " + std::to_string(l);
+            return false;
+        }
+        if (layer.in != width || layer.out <= 0)
+        {
+            error = path + ": layer " + std::to_string(l) + " takes " + std::to_string(layer.in) + " inputs, expected " +
+                    std::to_string(width);
+            return false;
+        }
+        if (activation == "softplus")
+        {
+            layer.activation = Activation::softplus;
+        }
+        else if (activation == "tanh")
+        {
+            layer.activation = Activation::tanh;
+        }
+        else if (activation != "identity")
+        {
+            error = path + ": unknown activation '" + activation + "'";
+            return false;
+        }
+
+        const size_t n_values = static_cast<size_t>(layer.out) * (static_cast<size_t>(layer.in) + 1);
+        layer.weights = weights.size();
+        layer.bias = weights.size() + static_cast<size_t>(layer.out) * static_cast<size_t>(layer.in);
+        for (size_t i = 0; i < n_values; ++i)
+        {
+            double v;
+            if (!(text >> v))
+            {
+                error = path + ": layer " + std::to_string(l) + " is missing weights";
+                return false;
+            }
+            weights.push_back(v);
+        }
+        layers.push_back(layer);
+        width = layer.out;
+        max_width = std::max(max_width, layer.out);
+    }
+    if (width != 1 || layers.back().activation != Activation::identity)
+    {
+        error = path + ": the last layer must have one identity output";
+        return false;
+    }
+    if (text >> key)
+    {
+        error = path + ": unexpected trailing data '" + key + "'";
+        return false;
+    }
+
+    mat_par_inputs_ = mat_par_inputs;
+    max_width_ = max_width;
+    layers_ = std::move(layers);
+    weights_ = std::move(weights);
+    return true;
+}
+
+// Applies the activation in place to one unit: value v, gradient g and Hessian
+// h become s(v), s'(v) g and s''(v) g g^T + s'(v) h.
+static void activate_unit(double *ABQNN_RESTRICT unit, int lanes, bool softplus)
+{
+    double *ABQNN_RESTRICT v = unit;
+    double *ABQNN_RESTRICT g0 = unit + lanes;
+    double *ABQNN_RESTRICT g1 = unit + 2 * lanes;
+    double *ABQNN_RESTRICT g2 = unit + 3 * lanes;
+    double *ABQNN_RESTRICT h0 = unit + 4 * lanes;
+    double *ABQNN_RESTRICT h1 = unit + 5 * lanes;
+    double *ABQNN_RESTRICT h2 = unit + 6 * lanes;
+    double *ABQNN_RESTRICT h3 = unit + 7 * lanes;
+    double *ABQNN_RESTRICT h4 = unit + 8 * lanes;
+    double *ABQNN_RESTRICT h5 = unit + 9 * lanes;
+
+    for (int p = 0; p < lanes; ++p)
+    {
+        double s, d1, d2;
+        if (softplus)
+        {
+            // torch.nn.Softplus(beta=1, threshold=20): linear above the threshold.
+            const double e = std::exp(-std::abs(v[p]));
+            const double sig = v[p] >= 0.0 ? 1.0 / (1.0 + e) : e / (1.0 + e);
+            const bool linear = v[p] > 20.0;
+            s = linear ? v[p] : std::max(v[p], 0.0) + std::log1p(e);
+            d1 = linear ? 1.0 : sig;
+            d2 = linear ? 0.0 : sig * (1.0 - sig);
+        }
+        else
+        {
+            s = std::tanh(v[p]);
+            d1 = 1.0 - s * s;
+            d2 = -2.0 * s * d1;
+        }
+        v[p] = s;
+        h0[p] = d2 * g0[p] * g0[p] + d1 * h0[p];
+        h1[p] = d2 * g1[p] * g1[p] + d1 * h1[p];
+        h2[p] = d2 * g2[p] * g2[p] + d1 * h2[p];
+        h3[p] = d2 * g0[p] * g1[p] + d1 * h3[p];
+        h4[p] = d2 * g0[p] * g2[p] + d1 * h4[p];
+        h5[p] = d2 * g1[p] * g2[p] + d1 * h5[p];
+        g0[p] *= d1;
+        g1[p] *= d1;
+        g2[p] *= d1;
+    }
+}
+
+void MlpEnergyModel::evaluate(Tile &tile, const double *mat_par) const
+{
+    const size_t buffer = static_cast<size_t>(max_width_) * kComps * kTile;
+    if (tile.a.size() < buffer)
+    {
+        tile.a.assign(buffer, 0.0);
+        tile.z.assign(buffer, 0.0);
+    }
+    const int lanes = tile.lanes;
+    const int unit = kComps * lanes;
+
+    // First layer: the invariants have unit gradients and no curvature, and
+    // mat_par only shifts the bias.
+    const Layer &first = layers_.front();
+    for (int32_t o = 0; o < first.out; ++o)
+    {
+        const double *w = &weights_[first.weights + static_cast<size_t>(o) * first.in];
+        double shift = weights_[first.bias + o];
+        for (int32_t k = 0; k < mat_par_inputs_; ++k)
+        {
+            shift += w[3 + k] * mat_par[k];
+        }
+
+        double *ABQNN_RESTRICT z = &tile.z[static_cast<size_t>(o) * unit];
+        for (int p = 0; p < lanes; ++p)
+        {
+            z[p] = shift + w[0] * tile.x[0][p] + w[1] * tile.x[1][p] + w[2] * tile.x[2][p];
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            std::fill(z + (1 + c) * lanes, z + (2 + c) * lanes, w[c]);
+        }
+        std::fill(z + 4 * lanes, z + unit, 0.0);
+    }
+
+    for (size_t l = 0;; ++l)
+    {
+        const Layer &layer = layers_[l];
+        if (layer.activation != Activation::identity)
+        {
+            for (int32_t o = 0; o < layer.out; ++o)
+            {
+                activate_unit(&tile.z[static_cast<size_t>(o) * unit], lanes, layer.activation == Activation::softplus);
+            }
+        }
+        tile.a.swap(tile.z);
+        if (l + 1 == layers_.size())
+        {
+            break;
+        }
+
+        // Every derivative row is linear in the previous layer's rows, so a
+        // unit is one bias plus `in` multiply-adds over kComps * lanes values.
+        const Layer &next = layers_[l + 1];
+        for (int32_t o = 0; o < next.out; ++o)
+        {
+            const double *w = &weights_[next.weights + static_cast<size_t>(o) * next.in];
+            double *ABQNN_RESTRICT z = &tile.z[static_cast<size_t>(o) * unit];
+            std::fill(z, z + lanes, weights_[next.bias + o]);
+            std::fill(z + lanes, z + unit, 0.0);
+            for (int32_t i = 0; i < next.in; ++i)
+            {
+                const double wi = w[i];
+                const double *ABQNN_RESTRICT a = &tile.a[static_cast<size_t>(i) * unit];
+                for (int k = 0; k < unit; ++k)
+                {
+                    z[k] += wi * a[k];
+                }
+            }
+        }
+    }
+}
+
+// Fills the invariant inputs of tile point p from the symmetric m = F F^T (or
+// F^T F) already stored there and J. Returns false for det F <= 0.
+static bool set_invariants(double (&x)[3][kTile], double *J, double *I1, double *I2, const double (&m)[6][kTile], int p)
+{
+    const double trace = m[0][p] + m[1][p] + m[2][p];
+    const double trace_sq = m[0][p] * m[0][p] + m[1][p] * m[1][p] + m[2][p] * m[2][p] +
+                            2.0 * (m[3][p] * m[3][p] + m[4][p] * m[4][p] + m[5][p] * m[5][p]);
+    I1[p] = trace;
+    I2[p] = 0.5 * (trace * trace - trace_sq);
+    if (!(J[p] > 0.0))
+    {
+        // Keep the tile finite; the caller reports the point as failed.
+        x[0][p] = x[1][p] = x[2][p] = 0.0;
+        return false;
+    }
+    const double Jm = 1.0 / std::cbrt(J[p] * J[p]);
+    x[0][p] = Jm * I1[p] - 3.0;
+    x[1][p] = Jm * Jm * I2[p] - 3.0;
+    x[2][p] = J[p] - 1.0;
+    return true;
+}
+
+// Kirchhoff-like tensor 2 (p1 G1 + p2 G2 + p3 G3) of the invariant gradient,
+// with G the invariant derivatives pushed through the symmetric m (= b gives
+// Kirchhoff stress, = C its co-rotated form), and the isochoric terms G1, G2
+// and m^2 the tangent needs. Voigt order.
+struct Pushed
+{
+    double tau[6];
+    double G[3][6];
+    double m2[6];
+};
+
+static void push_forward(const double *m, double J, double I1, double I2, const double *p, Pushed &out)
+{
+    const double Jm = 1.0 / std::cbrt(J * J);
+    const double K = Jm * Jm;
+    const double eye[6] = {1.0, 1.0, 1.0, 0.0, 0.0, 0.0};
+
+    out.m2[0] = m[0] * m[0] + m[3] * m[3] + m[4] * m[4];
+    out.m2[1] = m[3] * m[3] + m[1] * m[1] + m[5] * m[5];
+    out.m2[2] = m[4] * m[4] + m[5] * m[5] + m[2] * m[2];
+    out.m2[3] = m[0] * m[3] + m[3] * m[1] + m[4] * m[5];
+    out.m2[4] = m[0] * m[4] + m[3] * m[5] + m[4] * m[2];
+    out.m2[5] = m[3] * m[4] + m[1] * m[5] + m[5] * m[2];
+
+    for (int v = 0; v < 6; ++v)
+    {
+        out.G[0][v] = Jm * (m[v] - I1 / 3.0 * eye[v]);
+        out.G[1][v] = K * (I1 * m[v] - out.m2[v] - 2.0 / 3.0 * I2 * eye[v]);
+        out.G[2][v] = 0.5 * J * eye[v];
+        out.tau[v] = 2.0 * (p[0] * out.G[0][v] + p[1] * out.G[1][v] + p[2] * out.G[2][v]);
+    }
+}
+
+// DDSDDE = (c + Jaumann correction) / J from the invariant gradient p and
+// Hessian h (00, 11, 22, 01, 02, 12), with c the spatial tangent
+//
+//   c = 4 [sum_ab p_ab G_a (x) G_b + sum_a p_a Hhat_a],
+//
+// Hhat_a the spatial second derivatives of the invariants:
+//
+//   Hhat_1 = I1 Jm (I (x) I / 9 + II / 3) - Jm / 3 (I (x) b + b (x) I)
+//   Hhat_2 = K [I2 (4/9 I (x) I + 2/3 II) - 2/3 (I (x) B + B (x) I) + b (x) b - b (.) b]
+//   Hhat_3 = J / 4 I (x) I - J / 2 II
+//
+// where Jm = J^(-2/3), K = Jm^2, B = I1 b - b^2, II the symmetric identity
+// and (b (.) b)_ijkl = (b_ik b_jl + b_il b_jk) / 2.
+static void spatial_tangent(const double *b, const Pushed &pf, double J, double I1, double I2, const double *p,
+                            const double *h, double *ddsdde)
+{
+    const double Jm = 1.0 / std::cbrt(J * J);
+    const double K = Jm * Jm;
+    const double H[3][3] = {{h[0], h[3], h[4]}, {h[3], h[1], h[5]}, {h[4], h[5], h[2]}};
+
+    const double alpha = 4.0 * (p[0] * I1 * Jm / 3.0 + p[1] * K * I2 * 2.0 / 3.0 - p[2] * J / 2.0);
+    const double beta = 4.0 * (p[0] * I1 * Jm / 9.0 + p[1] * K * I2 * 4.0 / 9.0 + p[2] * J / 4.0);
+    const double gamma = -4.0 / 3.0 * p[0] * Jm;
+    const double delta = -8.0 / 3.0 * p[1] * K;
+    const double eps = 4.0 * p[1] * K;
+
+    double B[6];
+    for (int v = 0; v < 6; ++v)
+    {
+        B[v] = I1 * b[v] - pf.m2[v];
+    }
+    double HG[3][6];
+    for (int a = 0; a < 3; ++a)
+    {
+        for (int v = 0; v < 6; ++v)
+        {
+            HG[a][v] = H[a][0] * pf.G[0][v] + H[a][1] * pf.G[1][v] + H[a][2] * pf.G[2][v];
+        }
+    }
+
+    auto full = [](const double *s, int i, int j) {
+        static constexpr int voigt_of[3][3] = {{0, 3, 4}, {3, 1, 5}, {4, 5, 2}};
+        return s[voigt_of[i][j]];
+    };
+
+    const double inv_J = 1.0 / J;
+    for (int r = 0; r < 6; ++r)
+    {
+        const int i = kVoigt[r][0], j = kVoigt[r][1];
+        const double eye_r = i == j ? 1.0 : 0.0;
+        for (int s = r; s < 6; ++s)
+        {
+            const int k = kVoigt[s][0], l = kVoigt[s][1];
+            const double eye_s = k == l ? 1.0 : 0.0;
+            const double dik = i == k, dil = i == l, djk = j == k, djl = j == l;
+
+            double c = 4.0 * (pf.G[0][r] * HG[0][s] + pf.G[1][r] * HG[1][s] + pf.G[2][r] * HG[2][s]);
+            c += alpha * 0.5 * (dik * djl + dil * djk);
+            c += beta * eye_r * eye_s;
+            c += gamma * (eye_r * b[s] + b[r] * eye_s);
+            c += delta * (eye_r * B[s] + B[r] * eye_s);
+            c += eps * (b[r] * b[s] - 0.5 * (full(b, i, k) * full(b, j, l) + full(b, i, l) * full(b, j, k)));
+            c += 0.5 * (full(pf.tau, i, k) * djl + full(pf.tau, i, l) * djk + dik * full(pf.tau, j, l) +
+                        dil * full(pf.tau, j, k));
+
+            ddsdde[r * 6 + s] = c * inv_J;
+            ddsdde[s * 6 + r] = c * inv_J;
+        }
+    }
+}
+
+int32_t MlpEnergyModel::umat(const double *F, int32_t n, const double *mat_par, int32_t n_mat_par, int32_t *status,
+                             double *psi, double *cauchy, double *ddsdde) const
+{
+    if (n_mat_par < mat_par_inputs_ || (mat_par_inputs_ > 0 && !mat_par))
+    {
+        return 110;
+    }
+
+    thread_local Tile tile;
+    for (int32_t base = 0; base < n; base += kTile)
+    {
+        tile.count = std::min<int32_t>(kTile, n - base);
+        tile.lanes = std::min(kTile, (tile.count + kLaneStep - 1) / kLaneStep * kLaneStep);
+        bool valid[kTile];
+        for (int p = 0; p < kTile; ++p)
+        {
+            // Pad a partial tile with the identity so every lane stays finite.
+            static constexpr double eye[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+            const double *Fp = p < tile.count ? F + 9 * static_cast<size_t>(base + p) : eye;
+            // Column-major: F_ij = Fp[3 * j + i].
+            auto f = [Fp](int i, int j) { return Fp[3 * j + i]; };
+            for (int v = 0; v < 6; ++v)
+            {
+                const int i = kVoigt[v][0], j = kVoigt[v][1];
+                tile.m[v][p] = f(i, 0) * f(j, 0) + f(i, 1) * f(j, 1) + f(i, 2) * f(j, 2);
+            }
+            tile.J[p] = f(0, 0) * (f(1, 1) * f(2, 2) - f(1, 2) * f(2, 1)) -
+                        f(0, 1) * (f(1, 0) * f(2, 2) - f(1, 2) * f(2, 0)) +
+                        f(0, 2) * (f(1, 0) * f(2, 1) - f(1, 1) * f(2, 0));
+            valid[p] = set_invariants(tile.x, tile.J, tile.I1, tile.I2, tile.m, p);
+        }
+
+        evaluate(tile, mat_par);
+
+        for (int p = 0; p < tile.count; ++p)
+        {
+            const size_t i = static_cast<size_t>(base + p);
+            if (!valid[p])
+            {
+                const double nan = std::numeric_limits<double>::quiet_NaN();
+                status[i] = 105;
+                psi[i] = nan;
+                std::fill(cauchy + 6 * i, cauchy + 6 * i + 6, nan);
+                std::fill(ddsdde + 36 * i, ddsdde + 36 * i + 36, nan);
+                continue;
+            }
+
+            const double *unit = tile.a.data();
+            const int lanes = tile.lanes;
+            const double grad[3] = {unit[lanes + p], unit[2 * lanes + p], unit[3 * lanes + p]};
+            double hess[6];
+            for (int c = 0; c < 6; ++c)
+            {
+                hess[c] = unit[(4 + c) * lanes + p];
+            }
+            const double b[6] = {tile.m[0][p], tile.m[1][p], tile.m[2][p], tile.m[3][p], tile.m[4][p], tile.m[5][p]};
+
+            Pushed pf;
+            push_forward(b, tile.J[p], tile.I1[p], tile.I2[p], grad, pf);
+            status[i] = 0;
+            psi[i] = unit[p];
+            for (int v = 0; v < 6; ++v)
+            {
+                cauchy[6 * i + v] = pf.tau[v] / tile.J[p];
+            }
+            spatial_tangent(b, pf, tile.J[p], tile.I1[p], tile.I2[p], grad, hess, ddsdde + 36 * i);
+        }
+    }
+    return 0;
+}
+
+template <typename T>
+int32_t MlpEnergyModel::vumat_impl(const T *defgradF, int32_t nblock, int32_t ndir, int32_t nshr,
+                                   const double *mat_par, int32_t n_mat_par, T *energy, T *stress) const
+{
+    if (n_mat_par < mat_par_inputs_ || (mat_par_inputs_ > 0 && !mat_par) || !defgradF || nblock <= 0)
+    {
+        return 110;
+    }
+    if (ndir != 3 || (nshr != 3 && nshr != 1))
+    {
+        return 111;
+    }
+
+    // Abaqus stress order [11, 22, 33, 12, 23, 31], as Voigt slots of Pushed::tau.
+    static constexpr int stress_slot[6] = {0, 1, 2, 3, 5, 4};
+    // defgradF column of row-major F_ij (see pack_vumat_defgrad), -1 if absent.
+    static constexpr int column_3d[9] = {0, 3, 8, 6, 1, 4, 5, 7, 2};
+    static constexpr int column_plane[9] = {0, 3, -1, 4, 1, -1, -1, -1, 2};
+    const int *column = nshr == 3 ? column_3d : column_plane;
+    const int n_stress = 3 + nshr;
+    const size_t n = static_cast<size_t>(nblock);
+
+    thread_local Tile tile;
+    int32_t result = 0;
+    for (size_t base = 0; base < n; base += kTile)
+    {
+        tile.count = static_cast<int>(std::min<size_t>(kTile, n - base));
+        tile.lanes = std::min(kTile, (tile.count + kLaneStep - 1) / kLaneStep * kLaneStep);
+
+        // Unpack this tile's columns, padding with the identity.
+        double Fc[9][kTile];
+        for (int e = 0; e < 9; ++e)
+        {
+            const double pad = e % 4 == 0 ? 1.0 : 0.0;
+            const T *ABQNN_RESTRICT src = column[e] < 0 ? nullptr : defgradF + column[e] * n + base;
+            for (int p = 0; p < kTile; ++p)
+            {
+                Fc[e][p] = src && p < tile.count ? static_cast<double>(src[p]) : pad;
+            }
+        }
+
+        bool valid[kTile];
+        for (int p = 0; p < kTile; ++p)
+        {
+            auto f = [&Fc, p](int i, int j) { return Fc[3 * i + j][p]; };
+            for (int v = 0; v < 6; ++v)
+            {
+                const int i = kVoigt[v][0], j = kVoigt[v][1];
+                tile.m[v][p] = f(0, i) * f(0, j) + f(1, i) * f(1, j) + f(2, i) * f(2, j);
+            }
+            tile.J[p] = f(0, 0) * (f(1, 1) * f(2, 2) - f(1, 2) * f(2, 1)) -
+                        f(0, 1) * (f(1, 0) * f(2, 2) - f(1, 2) * f(2, 0)) +
+                        f(0, 2) * (f(1, 0) * f(2, 1) - f(1, 1) * f(2, 0));
+            valid[p] = set_invariants(tile.x, tile.J, tile.I1, tile.I2, tile.m, p);
+        }
+
+        evaluate(tile, mat_par);
+
+        const double *unit = tile.a.data();
+        const int lanes = tile.lanes;
+        for (int p = 0; p < tile.count; ++p)
+        {
+            const size_t i = base + static_cast<size_t>(p);
+            if (!valid[p])
+            {
+                result = 105;
+                energy[i] = std::numeric_limits<T>::quiet_NaN();
+                for (int c = 0; c < n_stress; ++c)
+                {
+                    stress[c * n + i] = std::numeric_limits<T>::quiet_NaN();
+                }
+                continue;
+            }
+
+            // With m = C, push_forward gives R^T tau R = 2 C psi_C for an
+            // isotropic energy: the co-rotational Kirchhoff stress.
+            const double grad[3] = {unit[lanes + p], unit[2 * lanes + p], unit[3 * lanes + p]};
+            const double C[6] = {tile.m[0][p], tile.m[1][p], tile.m[2][p], tile.m[3][p], tile.m[4][p], tile.m[5][p]};
+            Pushed pf;
+            push_forward(C, tile.J[p], tile.I1[p], tile.I2[p], grad, pf);
+            energy[i] = static_cast<T>(unit[p]);
+            for (int c = 0; c < n_stress; ++c)
+            {
+                stress[c * n + i] = static_cast<T>(pf.tau[stress_slot[c]] / tile.J[p]);
+            }
+        }
+    }
+    return result;
+}
+
+int32_t MlpEnergyModel::vumat(const double *defgradF, int32_t nblock, int32_t ndir, int32_t nshr,
+                              const double *mat_par, int32_t n_mat_par, double *energy, double *stress) const
+{
+    return vumat_impl(defgradF, nblock, ndir, nshr, mat_par, n_mat_par, energy, stress);
+}
+
+int32_t MlpEnergyModel::vumat(const float *defgradF, int32_t nblock, int32_t ndir, int32_t nshr,
+                              const double *mat_par, int32_t n_mat_par, float *energy, float *stress) const
+{
+    return vumat_impl(defgradF, nblock, ndir, nshr, mat_par, n_mat_par, energy, stress);
+}
+
+} // namespace abqnn::server
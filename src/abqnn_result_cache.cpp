@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cstring>
+
+#include "abqnn_result_cache.h"
+
+namespace abqnn::server {
+
+static uint64_t mix_word(uint64_t h, uint64_t w)
+{
+    h ^= w * 0x9E3779B97F4A7C15ull;
+    h = (h << 27) | (h >> 37);
+    return h * 0xBF58476D1CE4E5B9ull;
+}
+
+UmatResultCache::UmatResultCache(size_t max_entries, size_t shards)
+    : shard_count_(std::max<size_t>(1, std::min(shards, max_entries)))
+{
+    capacity_per_shard_ = std::max<size_t>(1, max_entries / shard_count_);
+    shards_ = std::make_unique<Shard[]>(shard_count_);
+}
+
+uint64_t UmatResultCache::make_key(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par,
+                                   std::string &key)
+{
+    const uint64_t model_id = model;
+    const size_t f_bytes = 9 * sizeof(double);
+    const size_t mat_par_bytes = static_cast<size_t>(n_mat_par) * sizeof(double);
+    key.resize(sizeof(model_id) + f_bytes + mat_par_bytes);
+    std::memcpy(&key[0], &model_id, sizeof(model_id));
+    std::memcpy(&key[sizeof(model_id)], F, f_bytes);
+    if (mat_par_bytes != 0)
+    {
+        std::memcpy(&key[sizeof(model_id) + f_bytes], mat_par, mat_par_bytes);
+    }
+
+    // The key is a whole number of 8-byte words; they are read with memcpy
+    // since request payloads carry no alignment guarantee.
+    uint64_t h = 0xCBF29CE484222325ull ^ key.size();
+    for (size_t off = 0; off < key.size(); off += sizeof(uint64_t))
+    {
+        uint64_t w;
+        std::memcpy(&w, key.data() + off, sizeof(w));
+        h = mix_word(h, w);
+    }
+    return h ^ (h >> 32);
+}
+
+UmatResultCache::Shard &UmatResultCache::shard_for(uint64_t hash) const
+{
+    return shards_[(hash >> 48) % shard_count_];
+}
+
+bool UmatResultCache::lookup(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par,
+                             UmatResult &out)
+{
+    thread_local std::string key;
+    const uint64_t hash = make_key(model, F, mat_par, n_mat_par, key);
+    lookups_.fetch_add(1, std::memory_order_relaxed);
+
+    Shard &shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(hash);
+    if (it == shard.index.end() || shard.slots[it->second].key != key)
+    {
+        return false;
+    }
+    const UmatResult &stored = shard.slots[it->second].result;
+    out.psi = stored.psi;
+    out.cauchy_n = stored.cauchy_n;
+    out.ddsdde_n = stored.ddsdde_n;
+    out.values.assign(stored.values.begin(), stored.values.end());
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+static size_t entry_bytes(const std::string &key, const UmatResult &result)
+{
+    return key.size() + result.values.size() * sizeof(double);
+}
+
+void UmatResultCache::insert(uint64_t model, const double *F, const double *mat_par, int32_t n_mat_par, double psi,
+                             const double *cauchy, int32_t cauchy_n, const double *ddsdde, int32_t ddsdde_n)
+{
+    thread_local std::string key;
+    const uint64_t hash = make_key(model, F, mat_par, n_mat_par, key);
+
+    Shard &shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // A hash already present names its slot, whether the key matches or
+    // collides; otherwise take a free slot or replace the oldest.
+    size_t slot;
+    auto it = shard.index.find(hash);
+    if (it != shard.index.end())
+    {
+        slot = it->second;
+        shard.bytes -= entry_bytes(shard.slots[slot].key, shard.slots[slot].result);
+    }
+    else if (shard.slots.size() < capacity_per_shard_)
+    {
+        slot = shard.slots.size();
+        shard.slots.emplace_back();
+        shard.bytes += sizeof(Entry);
+        shard.index.emplace(hash, slot);
+    }
+    else
+    {
+        slot = shard.next;
+        shard.next = (shard.next + 1) % capacity_per_shard_;
+        Entry &old = shard.slots[slot];
+        shard.index.erase(old.hash);
+        shard.bytes -= entry_bytes(old.key, old.result);
+        ++shard.evictions;
+        shard.index.emplace(hash, slot);
+    }
+
+    Entry &entry = shard.slots[slot];
+    entry.hash = hash;
+    entry.model = model;
+    entry.key = key;
+    entry.result.psi = psi;
+    entry.result.cauchy_n = cauchy_n;
+    entry.result.ddsdde_n = ddsdde_n;
+    entry.result.values.assign(cauchy, cauchy + cauchy_n);
+    entry.result.values.insert(entry.result.values.end(), ddsdde, ddsdde + ddsdde_n);
+    shard.bytes += entry_bytes(entry.key, entry.result);
+}
+
+void UmatResultCache::erase_model(uint64_t model)
+{
+    for (size_t i = 0; i < shard_count_; ++i)
+    {
+        Shard &shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // Each hole takes the last slot, so the shard stays dense; the
+        // replacement order of a full shard is only roughly oldest-first
+        // afterwards.
+        for (size_t slot = 0; slot < shard.slots.size();)
+        {
+            Entry &entry = shard.slots[slot];
+            if (entry.model != model)
+            {
+                ++slot;
+                continue;
+            }
+            shard.index.erase(entry.hash);
+            shard.bytes -= entry_bytes(entry.key, entry.result) + sizeof(Entry);
+            if (slot + 1 != shard.slots.size())
+            {
+                entry = std::move(shard.slots.back());
+                shard.index[entry.hash] = slot;
+            }
+            shard.slots.pop_back();
+        }
+    }
+}
+
+ResultCacheStats UmatResultCache::stats() const
+{
+    ResultCacheStats s;
+    s.lookups = lookups_.load(std::memory_order_relaxed);
+    s.hits = hits_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < shard_count_; ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        s.entries += shards_[i].slots.size();
+        s.bytes += shards_[i].bytes;
+        s.evictions += shards_[i].evictions;
+    }
+    return s;
+}
+
+} // namespace abqnn::server
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include "abqnn_umat_tangent.h"
+
+#if defined(_MSC_VER)
+#define ABQNN_RESTRICT __restrict
+#else
+#define ABQNN_RESTRICT __restrict__
+#endif
+
+namespace abqnn::server {
+
+static constexpr int kVoigt[6][2] = {{0, 0}, {1, 1}, {2, 2}, {0, 1}, {0, 2}, {1, 2}};
+
+// One point. The F F contraction of A runs in two steps, each needed entry
+// computed once: T_iqkl = A_iqks F_ls for every (i, q) and Voigt (k, l),
+// then a_ijkl = T_iqkl F_jq for the Voigt (i, j) only.
+static bool tangent_point(const double *ABQNN_RESTRICT F, const double *ABQNN_RESTRICT P,
+                          const double *ABQNN_RESTRICT A, double *ABQNN_RESTRICT cauchy,
+                          double *ABQNN_RESTRICT ddsdde)
+{
+    const double J = F[0] * (F[4] * F[8] - F[5] * F[7]) - F[1] * (F[3] * F[8] - F[5] * F[6]) +
+                     F[2] * (F[3] * F[7] - F[4] * F[6]);
+    if (!(J > 0.0))
+    {
+        return false;
+    }
+    const double inv_J = 1.0 / J;
+
+    double tau[3][3];
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            tau[i][j] = P[3 * i] * F[3 * j] + P[3 * i + 1] * F[3 * j + 1] + P[3 * i + 2] * F[3 * j + 2];
+        }
+    }
+
+    double T[9][6];
+    for (int iq = 0; iq < 9; ++iq)
+    {
+        const double *ABQNN_RESTRICT A_iq = A + 9 * iq; // A_iq[k * 3 + s]
+        for (int v = 0; v < 6; ++v)
+        {
+            const int k = kVoigt[v][0], l = kVoigt[v][1];
+            T[iq][v] = A_iq[3 * k] * F[3 * l] + A_iq[3 * k + 1] * F[3 * l + 1] + A_iq[3 * k + 2] * F[3 * l + 2];
+        }
+    }
+
+    for (int r = 0; r < 6; ++r)
+    {
+        const int i = kVoigt[r][0], j = kVoigt[r][1];
+        cauchy[r] = tau[i][j] * inv_J;
+        for (int s = 0; s < 6; ++s)
+        {
+            const int k = kVoigt[s][0], l = kVoigt[s][1];
+            double a = T[3 * i][s] * F[3 * j] + T[3 * i + 1][s] * F[3 * j + 1] + T[3 * i + 2][s] * F[3 * j + 2];
+            a += 0.5 * ((j == l ? tau[i][k] : 0.0) + (j == k ? tau[i][l] : 0.0) + (i == l ? tau[j][k] : 0.0) -
+                        (i == k ? tau[j][l] : 0.0));
+            ddsdde[6 * r + s] = a * inv_J;
+        }
+    }
+    return true;
+}
+
+void umat_from_energy_derivatives(const double *F, const double *P, const double *A, int32_t n, int32_t *status,
+                                  double *cauchy, double *ddsdde)
+{
+    for (int32_t b = 0; b < n; ++b)
+    {
+        const size_t i = static_cast<size_t>(b);
+        if (tangent_point(F + 9 * i, P + 9 * i, A + 81 * i, cauchy + 6 * i, ddsdde + 36 * i))
+        {
+            status[i] = 0;
+            continue;
+        }
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        status[i] = 105;
+        std::fill(cauchy + 6 * i, cauchy + 6 * i + 6, nan);
+        std::fill(ddsdde + 36 * i, ddsdde + 36 * i + 36, nan);
+    }
+}
+
+} // namespace abqnn::server
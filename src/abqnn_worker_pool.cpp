@@ -0,0 +1,195 @@
+#include "abqnn_worker_pool.h"
+
+namespace abqnn::server {
+
+static thread_local int tls_worker_index = -1;
+
+WorkerPool::WorkerPool(size_t worker_count) : started_(std::chrono::steady_clock::now())
+{
+    if (worker_count == 0)
+    {
+        worker_count = 1;
+    }
+
+    queues_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        workers_.emplace_back(&WorkerPool::worker_main, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto &t : workers_)
+    {
+        t.join();
+    }
+}
+
+int WorkerPool::current_worker_index()
+{
+    return tls_worker_index;
+}
+
+void WorkerPool::submit(Task task)
+{
+    // Work submitted from a worker stays on that worker's deque; everything else
+    // is spread round-robin and rebalanced by stealing.
+    size_t index = tls_worker_index >= 0
+        ? static_cast<size_t>(tls_worker_index)
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    // Count before publishing so a worker that pops the task immediately never
+    // drives pending_ below zero.
+    size_t depth = pending_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    size_t seen = max_pending_.load(std::memory_order_relaxed);
+    while (depth > seen && !max_pending_.compare_exchange_weak(seen, depth, std::memory_order_relaxed))
+    {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(task);
+    }
+
+    {
+        // Taking the lock orders this notify after a worker's empty-queue check.
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+    }
+    idle_cv_.notify_one();
+}
+
+namespace {
+
+struct WaitedTask
+{
+    Task inner;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    static void run(void *context)
+    {
+        auto *self = static_cast<WaitedTask *>(context);
+        self->inner.run(self->inner.context);
+        // Notify under the lock: the waiter owns this object on its stack and
+        // may destroy it as soon as it observes `done`.
+        std::lock_guard<std::mutex> lock(self->mutex);
+        self->done = true;
+        self->cv.notify_one();
+    }
+};
+
+} // namespace
+
+void WorkerPool::run_and_wait(Task task)
+{
+    // Already on a worker: running inline avoids deadlocking a saturated pool.
+    if (tls_worker_index >= 0)
+    {
+        task.run(task.context);
+        return;
+    }
+
+    WaitedTask waited;
+    waited.inner = task;
+    submit(Task{&WaitedTask::run, &waited});
+
+    std::unique_lock<std::mutex> lock(waited.mutex);
+    waited.cv.wait(lock, [&]() { return waited.done; });
+}
+
+bool WorkerPool::pop_local(size_t index, Task &task)
+{
+    WorkerQueue &q = *queues_[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+    {
+        return false;
+    }
+    task = q.tasks.front();
+    q.tasks.pop_front();
+    return true;
+}
+
+bool WorkerPool::steal(size_t thief, Task &task)
+{
+    const size_t n = queues_.size();
+    for (size_t k = 1; k < n; ++k)
+    {
+        WorkerQueue &q = *queues_[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = q.tasks.back();
+            q.tasks.pop_back();
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::worker_main(size_t index)
+{
+    tls_worker_index = static_cast<int>(index);
+
+    while (true)
+    {
+        Task task;
+        if (pop_local(index, task) || steal(index, task))
+        {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            busy_.fetch_add(1, std::memory_order_relaxed);
+
+            auto t0 = std::chrono::steady_clock::now();
+            task.run(task.context);
+            auto t1 = std::chrono::steady_clock::now();
+
+            queues_[index]->busy_ns.fetch_add(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()),
+                std::memory_order_relaxed);
+            busy_.fetch_sub(1, std::memory_order_relaxed);
+            completed_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_cv_.wait(lock, [&]() { return stopping_ || pending_.load(std::memory_order_acquire) > 0; });
+        if (stopping_)
+        {
+            return;
+        }
+    }
+}
+
+WorkerPoolStats WorkerPool::stats() const
+{
+    WorkerPoolStats s;
+    s.workers = workers_.size();
+    s.queue_depth = pending_.load(std::memory_order_relaxed);
+    s.max_queue_depth = max_pending_.load(std::memory_order_relaxed);
+    s.busy_workers = busy_.load(std::memory_order_relaxed);
+    s.tasks_completed = completed_.load(std::memory_order_relaxed);
+    s.tasks_stolen = stolen_.load(std::memory_order_relaxed);
+    for (const auto &q : queues_)
+    {
+        s.busy_ns += q->busy_ns.load(std::memory_order_relaxed);
+    }
+    s.uptime_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_).count());
+    return s;
+}
+
+} // namespace abqnn::server
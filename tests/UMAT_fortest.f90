@@ -11,6 +11,10 @@ real(c_double), dimension(6,6) :: DDSDDE
 
 integer :: i, j
 integer(c_int) :: err
+integer(c_int) :: handle
+real(c_double) :: psi_handle
+real(c_double), dimension(6) :: cauchy6_handle
+real(c_double), dimension(6,6) :: DDSDDE_handle
 
 real(c_double) :: mat_par(2)
 integer(c_int) :: n_mat_par
@@ -27,6 +31,25 @@ interface
         real(c_double), dimension(6,6), intent(out) :: DDSDDE
         integer(c_int) :: err
     end function invoke_pt
+
+    function invoke_pt_register(module_name, mat_par, n_mat_par, handle) result(err) bind(C)
+        use iso_c_binding, only: c_char, c_double, c_int
+        character(c_char), dimension(*), intent(in) :: module_name
+        real(c_double), dimension(*), intent(in) :: mat_par
+        integer(c_int), intent(in), value :: n_mat_par
+        integer(c_int), intent(out) :: handle
+        integer(c_int) :: err
+    end function invoke_pt_register
+
+    function invoke_pt_by_handle(handle, F, psi, cauchy6, DDSDDE) result(err) bind(C)
+        use iso_c_binding, only: c_double, c_int
+        integer(c_int), intent(in), value :: handle
+        real(c_double), dimension(3,3), intent(in) :: F
+        real(c_double), intent(out) :: psi
+        real(c_double), dimension(6), intent(out) :: cauchy6
+        real(c_double), dimension(6,6), intent(out) :: DDSDDE
+        integer(c_int) :: err
+    end function invoke_pt_by_handle
 end interface
 
 mat_par(1) = 1.0d0
@@ -63,4 +86,25 @@ write(*,*) "All 1000 invocations completed successfully"
 write(*,*) "Last psi value:", psi
 write(*,*) "Last Cauchy stress:", cauchy6
 
+! Same points through a registered handle: the name and mat_par are sent once
+err = invoke_pt_register(c_char_"NH_3D.pt" // c_null_char, mat_par, n_mat_par, handle)
+if (err /= 0) then
+    write(*,*) "Error: invoke_pt_register returned error code", err
+    stop 1
+end if
+
+do i = 1, 1000
+    err = invoke_pt_by_handle(handle, F(i,:,:), psi_handle, cauchy6_handle, DDSDDE_handle)
+    if (err /= 0) then
+        write(*,*) "Error at handle iteration", i, ": error code", err
+        stop 1
+    end if
+end do
+
+if (psi_handle /= psi .or. any(cauchy6_handle /= cauchy6) .or. any(DDSDDE_handle /= DDSDDE)) then
+    write(*,*) "Error: handle call differs from invoke_pt"
+    stop 1
+end if
+write(*,*) "All 1000 handle invocations match"
+
 end program UMAT_fortest
@@ -1,6 +1,6 @@
 program VUMAT_fortest
 
-use iso_c_binding, only: c_char, c_null_char, c_double, c_int
+use iso_c_binding, only: c_char, c_null_char, c_double, c_float, c_int
 
 implicit none
 
@@ -20,6 +20,18 @@ integer, parameter :: NSTRESS  = NDIR + NSHR        ! 6
 real(c_double) :: defgradF(NBLOCK, NDEFGRAD)
 real(c_double) :: enerInternNew(NBLOCK)
 real(c_double) :: stressNew(NBLOCK, NSTRESS)
+real(c_double) :: enerHalf(NBLOCK / 2, 2)
+real(c_double) :: stressHalf(NBLOCK / 2, NSTRESS, 2)
+real(c_double) :: defgradHalf(NBLOCK / 2, NDEFGRAD)
+integer(c_int) :: tickets(2)
+integer(c_int) :: handle
+real(c_double) :: enerHandle(NBLOCK)
+real(c_double) :: stressHandle(NBLOCK, NSTRESS)
+real(c_float) :: defgradF32(NBLOCK, NDEFGRAD)
+real(c_float) :: mat_par32(2)
+real(c_float) :: enerF32(NBLOCK)
+real(c_float) :: stressF32(NBLOCK, NSTRESS)
+integer :: h, lo, hi
 
 integer :: i, j
 integer(c_int) :: err
@@ -44,6 +56,67 @@ interface
         real(c_double), dimension(*),   intent(out) :: enerInternNew
         real(c_double), dimension(*),   intent(out) :: stressNew
     end function invoke_pt_vumat_batch
+
+    function invoke_pt_vumat_batch_f32( &
+            module_name, defgradF, nblock, ndir, nshr, &
+            mat_par, n_mat_par, enerInternNew, stressNew) result(err) bind(C)
+        use iso_c_binding, only: c_char, c_float, c_int
+        integer(c_int) :: err
+        character(c_char), dimension(*), intent(in) :: module_name
+        real(c_float), dimension(*),     intent(in) :: defgradF
+        integer(c_int), value,           intent(in) :: nblock
+        integer(c_int), value,           intent(in) :: ndir
+        integer(c_int), value,           intent(in) :: nshr
+        real(c_float), dimension(*),     intent(in) :: mat_par
+        integer(c_int), value,           intent(in) :: n_mat_par
+        real(c_float), dimension(*),    intent(out) :: enerInternNew
+        real(c_float), dimension(*),    intent(out) :: stressNew
+    end function invoke_pt_vumat_batch_f32
+
+    function invoke_pt_vumat_batch_submit( &
+            module_name, defgradF, nblock, ndir, nshr, &
+            mat_par, n_mat_par, enerInternNew, stressNew, ticket) result(err) bind(C)
+        use iso_c_binding, only: c_char, c_double, c_int
+        integer(c_int) :: err
+        character(c_char), dimension(*), intent(in) :: module_name
+        real(c_double), dimension(*),    intent(in) :: defgradF
+        integer(c_int), value,           intent(in) :: nblock
+        integer(c_int), value,           intent(in) :: ndir
+        integer(c_int), value,           intent(in) :: nshr
+        real(c_double), dimension(*),    intent(in) :: mat_par
+        integer(c_int), value,           intent(in) :: n_mat_par
+        real(c_double), dimension(*)                :: enerInternNew
+        real(c_double), dimension(*)                :: stressNew
+        integer(c_int),                 intent(out) :: ticket
+    end function invoke_pt_vumat_batch_submit
+
+    function invoke_pt_wait(ticket) result(err) bind(C)
+        use iso_c_binding, only: c_int
+        integer(c_int) :: err
+        integer(c_int), value, intent(in) :: ticket
+    end function invoke_pt_wait
+
+    function invoke_pt_vumat_register(module_name, mat_par, n_mat_par, handle) result(err) bind(C)
+        use iso_c_binding, only: c_char, c_double, c_int
+        integer(c_int) :: err
+        character(c_char), dimension(*), intent(in) :: module_name
+        real(c_double), dimension(*),    intent(in) :: mat_par
+        integer(c_int), value,           intent(in) :: n_mat_par
+        integer(c_int),                 intent(out) :: handle
+    end function invoke_pt_vumat_register
+
+    function invoke_pt_vumat_batch_by_handle( &
+            handle, defgradF, nblock, ndir, nshr, enerInternNew, stressNew) result(err) bind(C)
+        use iso_c_binding, only: c_double, c_int
+        integer(c_int) :: err
+        integer(c_int), value,           intent(in) :: handle
+        real(c_double), dimension(*),    intent(in) :: defgradF
+        integer(c_int), value,           intent(in) :: nblock
+        integer(c_int), value,           intent(in) :: ndir
+        integer(c_int), value,           intent(in) :: nshr
+        real(c_double), dimension(*),   intent(out) :: enerInternNew
+        real(c_double), dimension(*),   intent(out) :: stressNew
+    end function invoke_pt_vumat_batch_by_handle
 end interface
 
 mat_par(1) = 1.0d0
@@ -99,4 +172,78 @@ write(*,*) "Last  internal energy:  ", enerInternNew(NBLOCK)
 write(*,*) "First stress (VUMAT order, ndir+nshr=6): ", stressNew(1, :)
 write(*,*) "Last  stress:                            ", stressNew(NBLOCK, :)
 
+! Same block as two halves in flight at once, as a driver with one call per
+! material would send them; results must match the single call.
+do h = 1, 2
+    lo = (h - 1) * (NBLOCK / 2) + 1
+    hi = h * (NBLOCK / 2)
+    defgradHalf = defgradF(lo:hi, :)
+    err = invoke_pt_vumat_batch_submit( &
+        c_char_"VUMAT_NH_3D.pt" // c_null_char, &
+            defgradHalf, NBLOCK / 2, ndir_c, nshr_c, &
+            mat_par, n_mat_par, &
+            enerHalf(:, h), stressHalf(:, :, h), tickets(h))
+    if (err /= 0) then
+        write(*,*) "Error: invoke_pt_vumat_batch_submit returned code", err
+        stop 1
+    end if
+end do
+
+do h = 1, 2
+    err = invoke_pt_wait(tickets(h))
+    if (err /= 0) then
+        write(*,*) "Error: invoke_pt_wait returned code", err
+        stop 1
+    end if
+    lo = (h - 1) * (NBLOCK / 2) + 1
+    hi = h * (NBLOCK / 2)
+    ! The model may round differently for a smaller batch.
+    if (any(abs(enerHalf(:, h) - enerInternNew(lo:hi)) > 1.0d-10 * (1.0d0 + abs(enerInternNew(lo:hi)))) .or. &
+        any(abs(stressHalf(:, :, h) - stressNew(lo:hi, :)) > 1.0d-10 * (1.0d0 + abs(stressNew(lo:hi, :))))) then
+        write(*,*) "Error: asynchronous half", h, "differs from the batch call"
+        stop 1
+    end if
+end do
+
+write(*,*) "Asynchronous half-block calls match"
+
+! Same block through a registered handle: only defgradF goes over the wire.
+err = invoke_pt_vumat_register(c_char_"VUMAT_NH_3D.pt" // c_null_char, mat_par, n_mat_par, handle)
+if (err /= 0) then
+    write(*,*) "Error: invoke_pt_vumat_register returned code", err
+    stop 1
+end if
+
+err = invoke_pt_vumat_batch_by_handle(handle, defgradF, nblock_c, ndir_c, nshr_c, enerHandle, stressHandle)
+if (err /= 0) then
+    write(*,*) "Error: invoke_pt_vumat_batch_by_handle returned code", err
+    stop 1
+end if
+if (any(enerHandle /= enerInternNew) .or. any(stressHandle /= stressNew)) then
+    write(*,*) "Error: handle call differs from the batch call"
+    stop 1
+end if
+
+write(*,*) "Handle call matches"
+
+! Same block in single precision, as Abaqus/Explicit runs by default
+defgradF32 = real(defgradF, c_float)
+mat_par32 = real(mat_par, c_float)
+err = invoke_pt_vumat_batch_f32( &
+    c_char_"VUMAT_NH_3D.pt" // c_null_char, &
+        defgradF32, nblock_c, ndir_c, nshr_c, &
+        mat_par32, n_mat_par, &
+        enerF32, stressF32)
+if (err /= 0) then
+    write(*,*) "Error: invoke_pt_vumat_batch_f32 returned code", err
+    stop 1
+end if
+if (any(abs(enerF32 - enerInternNew) > 1.0d-4 * (1.0d0 + abs(enerInternNew))) .or. &
+    any(abs(stressF32 - stressNew) > 1.0d-4 * (1.0d0 + abs(stressNew)))) then
+    write(*,*) "Error: single-precision call differs from the double-precision call"
+    stop 1
+end if
+
+write(*,*) "Single-precision call matches"
+
 end program VUMAT_fortest
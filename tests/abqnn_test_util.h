@@ -0,0 +1,43 @@
+#ifndef ABQNN_TEST_UTIL_H
+#define ABQNN_TEST_UTIL_H
+
+#include <cstring>
+#include <cstdlib>
+
+#include "umat_auxlib.h"
+
+// The outputs of one invoke_pt / invoke_pt_by_handle call. Compares bit for
+// bit, so two results are equal only if they are the same doubles.
+struct UmatOutput
+{
+    double psi = 0.0;
+    double Cauchy6[6] = {0};
+    double DDSDDE[36] = {0};
+
+    bool operator==(const UmatOutput& other) const
+    {
+        return std::memcmp(this, &other, sizeof(UmatOutput)) == 0;
+    }
+};
+
+// Reads the counter on the "name=value" line of abqnn_server_stats. Returns
+// 0, the error of the stats query, or -1 if the server does not report it.
+inline int read_server_stat(const char* name, unsigned long long& value)
+{
+    char stats[8192];
+    const int err = abqnn_server_stats(stats, static_cast<int>(sizeof(stats)));
+    if (err != 0) {
+        return err;
+    }
+    const size_t name_len = std::strlen(name);
+    for (const char* line = stats; line; line = std::strchr(line, '\n')) {
+        line += *line == '\n' ? 1 : 0;
+        if (std::strncmp(line, name, name_len) == 0 && line[name_len] == '=') {
+            value = std::strtoull(line + name_len + 1, nullptr, 10);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+#endif
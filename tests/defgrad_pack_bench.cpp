@@ -0,0 +1,96 @@
+// Micro-benchmark of the VUMAT deformation-gradient packing: the LibTorch
+// from_blob/index_put_ version the server used before, against
+// pack_vumat_defgrad writing into a reused tensor. Not run by ctest.
+//
+// Usage: defgrad_pack_bench [repeats]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <torch/torch.h>
+
+#include "abqnn_defgrad_pack.h"
+
+using torch::indexing::Slice;
+
+static torch::Tensor pack_with_index_put(const double *defgradF, int nblock, int nshr)
+{
+    const int ndefgrad = 3 + 2 * nshr;
+    auto defgrad_fortran = torch::from_blob(const_cast<double *>(defgradF), {ndefgrad, nblock}, torch::kDouble).t().contiguous();
+    auto F = torch::zeros({nblock, 3, 3}, torch::kDouble);
+
+    F.index_put_({Slice(), 0, 0}, defgrad_fortran.index({Slice(), 0}));
+    F.index_put_({Slice(), 1, 1}, defgrad_fortran.index({Slice(), 1}));
+    F.index_put_({Slice(), 2, 2}, defgrad_fortran.index({Slice(), 2}));
+    F.index_put_({Slice(), 0, 1}, defgrad_fortran.index({Slice(), 3}));
+    F.index_put_({Slice(), 1, 0}, defgrad_fortran.index({Slice(), nshr == 3 ? 6 : 4}));
+    if (nshr == 3)
+    {
+        F.index_put_({Slice(), 1, 2}, defgrad_fortran.index({Slice(), 4}));
+        F.index_put_({Slice(), 2, 0}, defgrad_fortran.index({Slice(), 5}));
+        F.index_put_({Slice(), 2, 1}, defgrad_fortran.index({Slice(), 7}));
+        F.index_put_({Slice(), 0, 2}, defgrad_fortran.index({Slice(), 8}));
+    }
+    return F;
+}
+
+template <typename Fn>
+static double mean_us(int repeats, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        fn();
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / repeats;
+}
+
+int main(int argc, char **argv)
+{
+    const int repeats = argc > 1 ? std::atoi(argv[1]) : 2000;
+    if (repeats <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [repeats]\n", argv[0]);
+        return 2;
+    }
+
+    torch::set_num_threads(1);
+    std::printf("%5s %7s %14s %14s %8s\n", "nshr", "nblock", "index_put us", "packed us", "speedup");
+
+    int failures = 0;
+    for (int nshr : {3, 1})
+    {
+        for (int nblock : {1, 8, 64, 136, 512, 4096, 32768})
+        {
+            const int ndefgrad = 3 + 2 * nshr;
+            std::vector<double> defgradF(static_cast<size_t>(ndefgrad) * nblock);
+            for (size_t i = 0; i < defgradF.size(); ++i)
+            {
+                defgradF[i] = 1.0 + 1e-3 * static_cast<double>(i % 97);
+            }
+
+            torch::Tensor packed = torch::empty({nblock, 3, 3}, torch::kDouble);
+            abqnn::server::pack_vumat_defgrad(defgradF.data(), nblock, 3, nshr, packed.data_ptr<double>());
+            if (!torch::equal(packed, pack_with_index_put(defgradF.data(), nblock, nshr)))
+            {
+                std::fprintf(stderr, "mismatch: nshr=%d nblock=%d\n", nshr, nblock);
+                ++failures;
+                continue;
+            }
+
+            const int n = nblock > 4096 ? repeats / 10 + 1 : repeats;
+            double t_index_put = mean_us(n, [&] { pack_with_index_put(defgradF.data(), nblock, nshr); });
+            double t_packed = mean_us(n, [&] {
+                abqnn::server::pack_vumat_defgrad(defgradF.data(), nblock, 3, nshr, packed.data_ptr<double>());
+            });
+
+            std::printf("%5d %7d %14.3f %14.3f %7.1fx\n", nshr, nblock, t_index_put, t_packed,
+                        t_packed > 0.0 ? t_index_put / t_packed : 0.0);
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
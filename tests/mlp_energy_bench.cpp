@@ -0,0 +1,196 @@
+// Native MLP energy backend against TorchScript: checks that MLP_3D.mlp
+// reproduces the UMAT outputs of MLP_3D.pt and the VUMAT outputs of
+// VUMAT_MLP_3D.pt (all written by utils/gen_test_ts_models.py), then times
+// a single-point UMAT and VUMAT blocks of growing size on both. Not run by
+// ctest.
+//
+// Usage: mlp_energy_bench [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <torch/torch.h>
+#include <torch/script.h>
+
+#include "abqnn_config.h"
+#include "abqnn_defgrad_pack.h"
+#include "abqnn_mlp_energy.h"
+
+template <typename Fn>
+static double mean_us(int repeats, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+    {
+        fn();
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / repeats;
+}
+
+// Largest |a - b| relative to max(1, |b|).
+static double max_rel_diff(const double *a, const double *b, size_t n)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        worst = std::max(worst, std::abs(a[i] - b[i]) / std::max(1.0, std::abs(b[i])));
+    }
+    return worst;
+}
+
+int main(int argc, char **argv)
+{
+    const int repeats = argc > 1 ? std::atoi(argv[1]) : 1000;
+    if (repeats <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [repeats]\n", argv[0]);
+        return 2;
+    }
+    constexpr double tolerance = 1e-9;
+
+    try
+    {
+        std::filesystem::current_path(ABQNN_MODEL_PATH);
+        abqnn::server::MlpEnergyModel native;
+        std::string error;
+        if (!native.load("MLP_3D.mlp", error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        torch::jit::Module umat_module = torch::jit::load("MLP_3D.pt");
+        torch::jit::Module vumat_module = torch::jit::load("VUMAT_MLP_3D.pt");
+        umat_module.eval();
+        vumat_module.eval();
+        torch::set_num_threads(1);
+
+        const std::vector<double> mat_par = {1.0, 10.0};
+        torch::Tensor mat_par_tensor = torch::tensor(mat_par, torch::kDouble);
+
+        // Column-major F near the identity, as the UMAT client sends them.
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> perturb(-0.2, 0.2);
+        const int n_points = 64;
+        std::vector<double> F(9 * static_cast<size_t>(n_points));
+        for (int p = 0; p < n_points; ++p)
+        {
+            for (int k = 0; k < 9; ++k)
+            {
+                F[9 * p + k] = (k % 4 == 0 ? 1.0 : 0.0) + perturb(rng);
+            }
+        }
+
+        // UMAT: every point through forward, against one native batch.
+        std::vector<int32_t> status(n_points);
+        std::vector<double> psi(n_points), cauchy(6 * n_points), ddsdde(36 * n_points);
+        if (native.umat(F.data(), n_points, mat_par.data(), 2, status.data(), psi.data(), cauchy.data(), ddsdde.data()) != 0)
+        {
+            std::fprintf(stderr, "native UMAT failed\n");
+            return 1;
+        }
+        double umat_diff = 0.0;
+        for (int p = 0; p < n_points; ++p)
+        {
+            torch::Tensor Fp = torch::from_blob(&F[9 * p], {3, 3}, torch::kDouble).t().contiguous();
+            auto out = umat_module.forward({Fp, mat_par_tensor}).toTuple();
+            const double ref_psi = out->elements()[0].toTensor().item<double>();
+            torch::Tensor ref_cauchy = out->elements()[1].toTensor().contiguous();
+            torch::Tensor ref_ddsdde = out->elements()[2].toTensor().contiguous();
+            umat_diff = std::max({umat_diff, max_rel_diff(&psi[p], &ref_psi, 1),
+                                  max_rel_diff(&cauchy[6 * p], ref_cauchy.data_ptr<double>(), 6),
+                                  max_rel_diff(&ddsdde[36 * p], ref_ddsdde.data_ptr<double>(), 36)});
+        }
+
+        // VUMAT: the same points as one Fortran-ordered block.
+        static constexpr int column_of[9] = {0, 3, 8, 6, 1, 4, 5, 7, 2}; // row-major F_ij -> defgradF column
+        std::vector<double> defgrad(9 * static_cast<size_t>(n_points));
+        for (int p = 0; p < n_points; ++p)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    defgrad[column_of[3 * i + j] * n_points + p] = F[9 * p + 3 * j + i];
+                }
+            }
+        }
+        std::vector<double> energy(n_points), stress(6 * n_points);
+        if (native.vumat(defgrad.data(), n_points, 3, 3, mat_par.data(), 2, energy.data(), stress.data()) != 0)
+        {
+            std::fprintf(stderr, "native VUMAT failed\n");
+            return 1;
+        }
+        torch::Tensor F_batch = torch::empty({n_points, 3, 3}, torch::kDouble);
+        abqnn::server::pack_vumat_defgrad(defgrad.data(), n_points, 3, 3, F_batch.data_ptr<double>());
+        auto vumat_out = vumat_module.forward({F_batch, mat_par_tensor}).toTuple();
+        torch::Tensor ref_energy = vumat_out->elements()[0].toTensor().contiguous();
+        torch::Tensor ref_stress = vumat_out->elements()[1].toTensor().t().contiguous(); // Fortran order
+        const double vumat_diff = std::max(max_rel_diff(energy.data(), ref_energy.data_ptr<double>(), n_points),
+                                           max_rel_diff(stress.data(), ref_stress.data_ptr<double>(), 6 * n_points));
+
+        std::printf("max relative difference: UMAT %.3g, VUMAT %.3g\n", umat_diff, vumat_diff);
+        if (!(umat_diff <= tolerance && vumat_diff <= tolerance))
+        {
+            std::fprintf(stderr, "native backend disagrees with TorchScript\n");
+            return 1;
+        }
+
+        // Single-point UMAT latency.
+        torch::Tensor F0 = torch::from_blob(F.data(), {3, 3}, torch::kDouble).t().contiguous();
+        for (int w = 0; w < 20; ++w)
+        {
+            umat_module.forward({F0, mat_par_tensor});
+        }
+        const double t_torch = mean_us(std::max(1, repeats / 10), [&] { umat_module.forward({F0, mat_par_tensor}); });
+        const double t_native = mean_us(repeats, [&] {
+            native.umat(F.data(), 1, mat_par.data(), 2, status.data(), psi.data(), cauchy.data(), ddsdde.data());
+        });
+        std::printf("\nUMAT single point: TorchScript %.2f us, native %.3f us (%.0fx)\n\n", t_torch, t_native,
+                    t_native > 0.0 ? t_torch / t_native : 0.0);
+
+        // VUMAT block latency, packing included on both sides.
+        std::printf("%7s %16s %12s %8s\n", "nblock", "TorchScript us", "native us", "speedup");
+        for (int nblock : {1, 8, 64, 136, 512, 4096})
+        {
+            std::vector<double> block(9 * static_cast<size_t>(nblock));
+            for (int c = 0; c < 9; ++c)
+            {
+                for (int p = 0; p < nblock; ++p)
+                {
+                    block[c * nblock + p] = (c < 3 ? 1.0 : 0.0) + perturb(rng);
+                }
+            }
+            std::vector<double> block_energy(nblock), block_stress(6 * static_cast<size_t>(nblock));
+            torch::Tensor packed = torch::empty({nblock, 3, 3}, torch::kDouble);
+            auto run_torch = [&] {
+                abqnn::server::pack_vumat_defgrad(block.data(), nblock, 3, 3, packed.data_ptr<double>());
+                vumat_module.forward({packed, mat_par_tensor});
+            };
+            for (int w = 0; w < 5; ++w)
+            {
+                run_torch();
+            }
+            const int n = nblock > 512 ? repeats / 100 + 1 : repeats / 10 + 1;
+            const double t_block_torch = mean_us(n, run_torch);
+            const double t_block_native = mean_us(n, [&] {
+                native.vumat(block.data(), nblock, 3, 3, mat_par.data(), 2, block_energy.data(), block_stress.data());
+            });
+            std::printf("%7d %16.2f %12.2f %7.1fx\n", nblock, t_block_torch, t_block_native,
+                        t_block_native > 0.0 ? t_block_torch / t_block_native : 0.0);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("Exception: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Throughput of concurrent UMAT forwards on 1..N threads: every thread on one
+// shared module, against every thread on its own clone(inplace=true) replica
+// (what the server does with --module-replicas 1). Not run by ctest.
+//
+// Usage: module_replica_bench [max_threads] [forwards_per_thread] [model]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <torch/torch.h>
+#include <torch/script.h>
+
+#include <filesystem>
+
+#include "abqnn_config.h"
+
+// Forwards per second with `threads` threads, each running `forwards` on
+// modules[t % modules.size()].
+static double run(std::vector<torch::jit::Module> &modules, int threads, int forwards)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&modules, t, forwards]() {
+            torch::jit::Module &module = modules[static_cast<size_t>(t) % modules.size()];
+            torch::InferenceMode guard;
+            torch::Tensor F = torch::eye(3, torch::kDouble);
+            F[0][1] = 0.05 + 1e-3 * t;
+            torch::Tensor mat_par = torch::tensor({1.0, 10.0}, torch::kDouble);
+            for (int i = 0; i < forwards; ++i)
+            {
+                module.forward({F, mat_par});
+            }
+        });
+    }
+    for (auto &th : pool)
+    {
+        th.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * static_cast<double>(forwards) / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    const int max_threads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int forwards = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const std::string model = argc > 3 ? argv[3] : "NH_3D.pt";
+    if (max_threads <= 0 || forwards <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [max_threads] [forwards_per_thread] [model]\n", argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        std::filesystem::current_path(ABQNN_MODEL_PATH);
+        torch::jit::Module shared = torch::jit::load(model);
+        shared.eval();
+
+        // As the server runs them: one intra-op thread per forward.
+        torch::set_num_threads(1);
+
+        std::vector<torch::jit::Module> one{shared};
+        std::vector<torch::jit::Module> replicas;
+        for (int t = 0; t < max_threads; ++t)
+        {
+            replicas.push_back(shared.clone(/*inplace=*/true));
+        }
+
+        // Warm up the profiling executors of every instance.
+        run(one, 1, 50);
+        run(replicas, max_threads, 50);
+
+        std::printf("%7s %16s %16s %8s\n", "threads", "shared fwd/s", "replicas fwd/s", "ratio");
+        for (int threads = 1; threads <= max_threads; threads *= 2)
+        {
+            double shared_rate = run(one, threads, forwards);
+            double replica_rate = run(replicas, threads, forwards);
+            std::printf("%7d %16.0f %16.0f %7.2fx\n", threads, shared_rate, replica_rate, replica_rate / shared_rate);
+            if (threads < max_threads && threads * 2 > max_threads)
+            {
+                threads = max_threads / 2;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::printf("Exception: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
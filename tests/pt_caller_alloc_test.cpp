@@ -0,0 +1,81 @@
+/**
+ * @file pt_caller_alloc_test.cpp
+ * @brief Counts heap allocations made by steady-state invoke_pt calls
+ *
+ * After a few warm-up calls (connection, shared-memory attach, buffer growth)
+ * the IPC client must serialize, exchange and decode without allocating.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "abqnn_config.h"
+#include "umat_auxlib.h"
+
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* model_path = argc > 1 ? argv[1] : "NH_3D.pt";
+    constexpr int kWarmup = 16;
+    constexpr int kCalls = 1000;
+
+    double F[9] = {1.1, 0.0, 0.0, 0.0, 1.05, 0.0, 0.0, 0.0, 1.0 / (1.1 * 1.05)};
+    double mat_par[2] = {1.0, 10.0};
+    double psi = 0.0;
+    double Cauchy6[6] = {0};
+    double DDSDDE[36] = {0};
+
+    for (int i = 0; i < kWarmup; ++i) {
+        int err = invoke_pt(model_path, F, mat_par, 2, &psi, Cauchy6, DDSDDE);
+        if (err != 0) {
+            std::cerr << "Error: invoke_pt returned " << err << std::endl;
+            return err;
+        }
+    }
+
+    const long before = allocations.load();
+    for (int i = 0; i < kCalls; ++i) {
+        F[0] = 1.0 + 1e-4 * i;
+        int err = invoke_pt(model_path, F, mat_par, 2, &psi, Cauchy6, DDSDDE);
+        if (err != 0) {
+            std::cerr << "Error: invoke_pt returned " << err << std::endl;
+            return err;
+        }
+    }
+    const long used = allocations.load() - before;
+
+    std::cout << "Heap allocations in " << kCalls << " steady-state calls: " << used << std::endl;
+
+#ifdef ABQNN_IPC_PERSISTENT_CONNECTIONS
+    if (used != 0) {
+        std::cerr << "Error: expected no allocations per call" << std::endl;
+        return 1;
+    }
+#else
+    std::cout << "Connections are opened per call in this build; not enforced." << std::endl;
+#endif
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <atomic>
 #include <cmath>
 #include <condition_variable>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <mutex>
@@ -12,6 +13,9 @@
 
 #include "umat_auxlib.h"
 
+// Usage: pt_caller_concurrency_test [model] [min-mean-batch-size]
+// With min-mean-batch-size, the server must batch UMAT requests
+// (--umat-batch-size) and report a umat_mean_batch_size above it.
 int main(int argc, char *argv[])
 {
     const char *model_path = "NH_3D.pt";
@@ -19,6 +23,7 @@ int main(int argc, char *argv[])
     {
         model_path = argv[1];
     }
+    const double min_mean_batch_size = argc > 2 ? std::strtod(argv[2], nullptr) : -1.0;
 
     constexpr int kThreadCount = 8;
     constexpr int kCallsPerThread = 12;
@@ -106,6 +111,14 @@ int main(int argc, char *argv[])
         t.detach();
     }
 
+    // Swap in a fresh copy of the model while the calls run; none may fail.
+    const int reload_err = abqnn_reload_model(model_path);
+    if (reload_err != 0)
+    {
+        std::cout << "Model reload failed with error " << reload_err << "." << std::endl;
+        return 1;
+    }
+
     {
         std::unique_lock<std::mutex> lock(done_mutex);
         const bool all_finished = done_cv.wait_for(
@@ -136,5 +149,31 @@ int main(int argc, char *argv[])
 
     std::cout << "Parallel IPC test passed: " << (kThreadCount * kCallsPerThread)
               << " requests completed successfully." << std::endl;
+
+    char stats[8192];
+    const int stats_err = abqnn_server_stats(stats, static_cast<int>(sizeof(stats)));
+    if (stats_err != 0 || std::strstr(stats, "tasks_completed=") == nullptr)
+    {
+        std::cout << "Server stats query failed with error " << stats_err << "." << std::endl;
+        return 1;
+    }
+    std::cout << "Server stats:" << std::endl << stats;
+
+    if (min_mean_batch_size >= 0.0)
+    {
+        const char *mean = std::strstr(stats, "umat_mean_batch_size=");
+        if (mean == nullptr)
+        {
+            std::cout << "Server does not batch UMAT requests." << std::endl;
+            return 1;
+        }
+        const double mean_batch_size = std::strtod(mean + std::strlen("umat_mean_batch_size="), nullptr);
+        if (!(mean_batch_size > min_mean_batch_size))
+        {
+            std::cout << "Mean UMAT batch size " << mean_batch_size << " is not above " << min_mean_batch_size
+                      << "." << std::endl;
+            return 1;
+        }
+    }
     return 0;
 }
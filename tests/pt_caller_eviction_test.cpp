@@ -0,0 +1,66 @@
+/**
+ * @file pt_caller_eviction_test.cpp
+ * @brief Model cache evictions, against a server with a tiny --model-cache-mb
+ *
+ * Alternates two models so that each load evicts the other, through a handle
+ * and by name. Every call must succeed and repeat the first call's result
+ * bit for bit, and the server must report evictions.
+ */
+
+#include <iostream>
+
+#include "abqnn_test_util.h"
+#include "umat_auxlib.h"
+
+int main()
+{
+    std::cout << "ABQnn Model Cache Eviction Test" << std::endl;
+    std::cout << "===============================" << std::endl;
+
+    const double F[9] = {1.05, 0.02, 0.0,
+                         0.01, 0.98, 0.0,
+                         0.0, -0.01, 1.0};
+    double mat_par[2] = {1.0, 10.0};
+
+    int handle = 0;
+    int err = invoke_pt_register("MLP_3D.pt", mat_par, 2, &handle);
+    if (err != 0) {
+        std::cerr << "Error: invoke_pt_register returned " << err << std::endl;
+        return 1;
+    }
+
+    constexpr int kRounds = 8;
+    UmatOutput first[2];
+    for (int round = 0; round < kRounds; ++round) {
+        UmatOutput out[2];
+        const int err_handle = invoke_pt_by_handle(handle, F, &out[0].psi, out[0].Cauchy6, out[0].DDSDDE);
+        const int err_native = invoke_pt("MLP_3D.mlp", F, mat_par, 2, &out[1].psi, out[1].Cauchy6, out[1].DDSDDE);
+        if (err_handle != 0 || err_native != 0) {
+            std::cerr << "Error: round " << round << " returned " << err_handle << " (handle), "
+                      << err_native << " (native)" << std::endl;
+            return 1;
+        }
+        if (round == 0) {
+            first[0] = out[0];
+            first[1] = out[1];
+        } else if (!(out[0] == first[0]) || !(out[1] == first[1])) {
+            std::cerr << "Error: round " << round << " differs from round 0" << std::endl;
+            return 1;
+        }
+    }
+
+    unsigned long long count = 0;
+    err = read_server_stat("model_cache_evictions", count);
+    if (err != 0) {
+        std::cerr << "Error: no model_cache_evictions in the server stats (error " << err << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "  model_cache_evictions=" << count << std::endl;
+    if (count == 0) {
+        std::cerr << "Error: no model was evicted" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\nTest completed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file pt_caller_legacy_server_test.cpp
+ * @brief umat_auxlib against a server that predates handles and batches
+ *
+ * Runs an in-process stand-in for the first server release on
+ * ABQNN_IPC_ENDPOINT: it speaks protocol v1 only, answers
+ * ABQNN_MSG_UMAT_REQ and drops the connection on anything else, as that
+ * release did. invoke_pt_register / invoke_pt_by_handle must fall back to
+ * named requests, and coalesced calls (run with ABQNN_COALESCE_WINDOW_US)
+ * to single requests, with every call succeeding. First, the stand-in also
+ * answers v2 for one asynchronous call, then turns v1-only under the idle
+ * connection it leaves behind, as if an older server had replaced it.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "abqnn_ipc_common.h"
+#include "abqnn_ipc_protocol.h"
+#include "abqnn_ipc_reactor.h"
+#include "umat_auxlib.h"
+
+// Until set, the stand-in answers v2 UMAT requests as well.
+static std::atomic<bool> legacy{false};
+
+// Frames the stand-in dropped, by message type.
+static std::atomic<int> dropped_register{0};
+static std::atomic<int> dropped_batch{0};
+
+class LegacyHandler final : public abqnn::ipc::ReactorHandler
+{
+public:
+    abqnn::ipc::Reactor* reactor = nullptr;
+
+    // Answers a UMAT request with psi = F11, Cauchy = F[0..5], DDSDDE = I.
+    void on_request(abqnn::ipc::ReactorRequest* request) override
+    {
+        if ((legacy.load() && request->header.version != ABQNN_IPC_MIN_VERSION) ||
+            request->header.message_type != ABQNN_MSG_UMAT_REQ)
+        {
+            if (request->header.message_type == ABQNN_MSG_REGISTER_REQ) ++dropped_register;
+            if (request->header.message_type == ABQNN_MSG_UMAT_BATCH_REQ) ++dropped_batch;
+            // reject shuts a v1 connection down, which is what the old
+            // server did with every frame it did not understand.
+            request->header.version = ABQNN_IPC_MIN_VERSION;
+            reactor->reject(request);
+            return;
+        }
+
+        abqnn::ipc::PayloadView req{request->payload.data(), request->payload.size()};
+        size_t off = 0;
+        uint32_t module_len = 0;
+        double F[9] = {0};
+        abqnn::ipc::read_scalar(req, off, module_len);
+        off += module_len + sizeof(int32_t);
+        std::memcpy(F, req.data + off, sizeof(F));
+
+        const int32_t status = 0;
+        const int32_t cauchy_n = 6;
+        const int32_t ddsdde_n = 36;
+        double ddsdde[36] = {0};
+        for (int i = 0; i < 6; ++i) {
+            ddsdde[7 * i] = 1.0;
+        }
+        request->response.clear();
+        auto put = [&](const void* p, size_t n) {
+            request->response.insert(request->response.end(), static_cast<const char*>(p),
+                                     static_cast<const char*>(p) + n);
+        };
+        put(&status, sizeof(status));
+        put(&F[0], sizeof(double));
+        put(&cauchy_n, sizeof(cauchy_n));
+        put(&ddsdde_n, sizeof(ddsdde_n));
+        put(F, 6 * sizeof(double));
+        put(ddsdde, sizeof(ddsdde));
+        request->response_type = ABQNN_MSG_UMAT_RESP;
+        reactor->reply(request);
+    }
+
+    void on_close(abqnn::ipc::ReactorConnection&) override {}
+};
+
+static bool check_result(const char* what, int err, const double* F, double psi, const double* Cauchy6)
+{
+    if (err != 0) {
+        std::cerr << "Error: " << what << " returned " << err << std::endl;
+        return false;
+    }
+    if (psi != F[0] || std::memcmp(Cauchy6, F, 6 * sizeof(double)) != 0) {
+        std::cerr << "Error: " << what << " returned another point's result" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Four concurrent invoke_pt calls, which coalescing would put in one batch.
+static bool run_concurrent_calls(const double* mat_par)
+{
+    constexpr int kThreads = 4;
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            const double F[9] = {1.0 + 0.1 * t, 0.01 * t, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+            double psi = 0.0;
+            double Cauchy6[6] = {0};
+            double DDSDDE[36] = {0};
+            const int err = invoke_pt("NH_3D.pt", F, mat_par, 2, &psi, Cauchy6, DDSDDE);
+            if (!check_result("concurrent invoke_pt", err, F, psi, Cauchy6)) {
+                ok = false;
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    return ok;
+}
+
+int main()
+{
+    std::cout << "ABQnn Legacy Server Test" << std::endl;
+    std::cout << "========================" << std::endl;
+
+    // Never destroyed: the I/O thread runs until the process exits.
+    auto* handler = new LegacyHandler();
+    const char* endpoint = abqnn::ipc::default_endpoint();
+    handler->reactor = abqnn::ipc::Reactor::create(endpoint, *handler, 1, 0).release();
+    if (!handler->reactor) {
+        std::cerr << "Error: cannot listen on " << endpoint << std::endl;
+        return 1;
+    }
+    std::thread([handler]() { handler->reactor->run(); }).detach();
+
+    const double mat_par[2] = {1.0, 10.0};
+    const double F[9] = {1.05, 0.02, 0.0, 0.01, 0.98, 0.0, 0.0, 0.0, 1.0};
+    double psi = 0.0;
+    double Cauchy6[6] = {0};
+    double DDSDDE[36] = {0};
+
+    // The second call is dropped on the idle v2 connection of the first,
+    // then on a fresh v2 one, and must be answered in v1.
+    int err = 0;
+    for (int k = 0; k < 2; ++k) {
+        legacy = k == 1;
+        int ticket = 0;
+        err = invoke_pt_submit("NH_3D.pt", F, mat_par, 2, &psi, Cauchy6, DDSDDE, &ticket);
+        if (err == 0) {
+            err = invoke_pt_wait(ticket);
+        }
+        if (!check_result("invoke_pt_submit/invoke_pt_wait", err, F, psi, Cauchy6)) {
+            return 1;
+        }
+    }
+    std::cout << "  Asynchronous calls fall back to v1." << std::endl;
+
+    err = invoke_pt("NH_3D.pt", F, mat_par, 2, &psi, Cauchy6, DDSDDE);
+    if (!check_result("invoke_pt", err, F, psi, Cauchy6)) {
+        return 1;
+    }
+
+    int handle = 0;
+    err = invoke_pt_register("NH_3D.pt", mat_par, 2, &handle);
+    if (err != 0 || handle <= 0) {
+        std::cerr << "Error: invoke_pt_register returned " << err << ", handle " << handle << std::endl;
+        return 1;
+    }
+    for (int k = 0; k < 2; ++k) {
+        err = invoke_pt_by_handle(handle, F, &psi, Cauchy6, DDSDDE);
+        if (!check_result("invoke_pt_by_handle", err, F, psi, Cauchy6)) {
+            return 1;
+        }
+    }
+    if (dropped_register.load() == 0) {
+        std::cerr << "Error: the library never tried to register with the server" << std::endl;
+        return 1;
+    }
+    std::cout << "  Handles fall back to named requests." << std::endl;
+
+    // The first round finds batches unsupported, the second must not send any.
+    if (!run_concurrent_calls(mat_par)) {
+        return 1;
+    }
+    const int batches_after_first_round = dropped_batch.load();
+    if (!run_concurrent_calls(mat_par)) {
+        return 1;
+    }
+    if (dropped_batch.load() != batches_after_first_round) {
+        std::cerr << "Error: coalescing went on after the server dropped a batch" << std::endl;
+        return 1;
+    }
+    std::cout << "  Coalesced calls fall back to single requests." << std::endl;
+
+    std::cout << "\nTest completed successfully!" << std::endl;
+    return 0;
+}
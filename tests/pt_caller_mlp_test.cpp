@@ -0,0 +1,108 @@
+/**
+ * @file pt_caller_mlp_test.cpp
+ * @brief Native MLP models through the server against their TorchScript twins
+ *
+ * MLP_3D.mlp, MLP_3D.pt and VUMAT_MLP_3D.pt hold the same weights (see
+ * utils/gen_test_ts_models.py). Every UMAT and VUMAT call on the native model
+ * must succeed and match the TorchScript model within a tolerance.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "umat_auxlib.h"
+
+// Largest |a - b| relative to max(1, |b|).
+template <typename T>
+static double max_rel_diff(const T* a, const T* b, int n)
+{
+    double worst = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const double d = std::abs(static_cast<double>(a[i]) - static_cast<double>(b[i]));
+        worst = std::max(worst, d / std::max(1.0, std::abs(static_cast<double>(b[i]))));
+    }
+    return worst;
+}
+
+static bool check(const char* what, int err_native, int err_torch, double diff, double tolerance)
+{
+    if (err_native != 0 || err_torch != 0) {
+        std::cerr << "Error: " << what << " returned " << err_native << " (native), "
+                  << err_torch << " (TorchScript)" << std::endl;
+        return false;
+    }
+    std::cout << "  " << what << ": max relative difference " << diff << std::endl;
+    if (!(diff <= tolerance)) {
+        std::cerr << "Error: " << what << " differs from TorchScript" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    std::cout << "ABQnn Native MLP Test" << std::endl;
+    std::cout << "=====================" << std::endl;
+
+    const char* native_model = "MLP_3D.mlp";
+    const char* umat_model = "MLP_3D.pt";
+    const char* vumat_model = "VUMAT_MLP_3D.pt";
+    double mat_par[2] = {1.0, 10.0};
+    bool ok = true;
+
+    // UMAT: a few column-major F around the identity.
+    for (int p = 0; p < 4; ++p) {
+        double F[9] = {1.0 + 0.05 * p, 0.01 * p, 0.0,
+                       0.02, 1.0 - 0.03 * p, 0.005 * p,
+                       0.0, -0.01, 1.0 + 0.02 * p};
+        double psi[2] = {0.0, 0.0};
+        double Cauchy6[2][6] = {{0}};
+        double DDSDDE[2][36] = {{0}};
+        const int err_native = invoke_pt(native_model, F, mat_par, 2, &psi[0], Cauchy6[0], DDSDDE[0]);
+        const int err_torch = invoke_pt(umat_model, F, mat_par, 2, &psi[1], Cauchy6[1], DDSDDE[1]);
+        const double diff = std::max({max_rel_diff(&psi[0], &psi[1], 1),
+                                      max_rel_diff(Cauchy6[0], Cauchy6[1], 6),
+                                      max_rel_diff(DDSDDE[0], DDSDDE[1], 36)});
+        ok = check("invoke_pt", err_native, err_torch, diff, 1e-9) && ok;
+    }
+
+    // VUMAT: one block, defgradF(nblock, 9) in Fortran order, columns
+    // [11, 22, 33, 12, 23, 31, 21, 32, 13].
+    constexpr int kBlock = 16;
+    std::vector<double> defgrad(9 * kBlock);
+    for (int c = 0; c < 9; ++c) {
+        for (int p = 0; p < kBlock; ++p) {
+            defgrad[c * kBlock + p] = (c < 3 ? 1.0 : 0.0) + 0.01 * ((c + 3 * p) % 7 - 3);
+        }
+    }
+    std::vector<double> energy[2] = {std::vector<double>(kBlock), std::vector<double>(kBlock)};
+    std::vector<double> stress[2] = {std::vector<double>(6 * kBlock), std::vector<double>(6 * kBlock)};
+    int err_native = invoke_pt_vumat_batch(native_model, defgrad.data(), kBlock, 3, 3, mat_par, 2,
+                                           energy[0].data(), stress[0].data());
+    int err_torch = invoke_pt_vumat_batch(vumat_model, defgrad.data(), kBlock, 3, 3, mat_par, 2,
+                                          energy[1].data(), stress[1].data());
+    double diff = std::max(max_rel_diff(energy[0].data(), energy[1].data(), kBlock),
+                           max_rel_diff(stress[0].data(), stress[1].data(), 6 * kBlock));
+    ok = check("invoke_pt_vumat_batch", err_native, err_torch, diff, 1e-9) && ok;
+
+    // The same block in single precision; both sides round differently.
+    std::vector<float> defgrad_f32(defgrad.begin(), defgrad.end());
+    float mat_par_f32[2] = {1.0f, 10.0f};
+    std::vector<float> energy_f32[2] = {std::vector<float>(kBlock), std::vector<float>(kBlock)};
+    std::vector<float> stress_f32[2] = {std::vector<float>(6 * kBlock), std::vector<float>(6 * kBlock)};
+    err_native = invoke_pt_vumat_batch_f32(native_model, defgrad_f32.data(), kBlock, 3, 3, mat_par_f32, 2,
+                                           energy_f32[0].data(), stress_f32[0].data());
+    err_torch = invoke_pt_vumat_batch_f32(vumat_model, defgrad_f32.data(), kBlock, 3, 3, mat_par_f32, 2,
+                                          energy_f32[1].data(), stress_f32[1].data());
+    diff = std::max(max_rel_diff(energy_f32[0].data(), energy_f32[1].data(), kBlock),
+                    max_rel_diff(stress_f32[0].data(), stress_f32[1].data(), 6 * kBlock));
+    ok = check("invoke_pt_vumat_batch_f32", err_native, err_torch, diff, 1e-4) && ok;
+
+    if (!ok) {
+        return 1;
+    }
+    std::cout << "\nTest completed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file pt_caller_pipeline_test.cpp
+ * @brief Pipelined UMAT requests on one connection (transact_pipelined)
+ *
+ * Sends a run of UMAT requests without waiting for each response, one of
+ * them for a model that does not exist. Response i must answer request i:
+ * byte for byte what the same request gets on its own, and the error only
+ * where the bad request was. Repeats the run after close_thread_connection.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "abqnn_ipc_common.h"
+#include "abqnn_ipc_protocol.h"
+
+// ABQNN_MSG_UMAT_REQ payload, as umat_auxlib writes it.
+static std::vector<char> umat_request(const std::string& model, const double* F, const double* mat_par, int n_mat_par)
+{
+    const uint32_t module_len = static_cast<uint32_t>(model.size());
+    const int32_t n = n_mat_par;
+    std::vector<char> payload;
+    abqnn::ipc::PayloadWriter req = abqnn::ipc::begin_payload(
+        payload, sizeof(module_len) + module_len + sizeof(n) + (9 + n_mat_par) * sizeof(double));
+    req.put(module_len);
+    req.put_bytes(model.data(), module_len);
+    req.put(n);
+    req.put_bytes(F, 9 * sizeof(double));
+    req.put_bytes(mat_par, n_mat_par * sizeof(double));
+    return payload;
+}
+
+static int32_t response_status(const std::vector<char>& resp)
+{
+    size_t off = 0;
+    int32_t status = -1;
+    return abqnn::ipc::read_scalar(resp, off, status) ? status : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    std::cout << "ABQnn Pipelined IPC Test" << std::endl;
+    std::cout << "========================" << std::endl;
+
+    const char* endpoint = abqnn::ipc::default_endpoint();
+    const std::string model = argc > 1 ? argv[1] : "NH_3D.pt";
+    const double mat_par[2] = {1.0, 10.0};
+
+    constexpr int kRequests = 16;
+    constexpr int kBadRequest = 5;
+    std::vector<std::vector<char>> requests;
+    for (int i = 0; i < kRequests; ++i) {
+        const double F[9] = {1.0 + 0.01 * i, 0.002 * i, 0.0,
+                             0.0, 1.0 - 0.005 * i, 0.001 * i,
+                             0.0, 0.0, 1.0};
+        requests.push_back(umat_request(i == kBadRequest ? "no_such_model.pt" : model, F, mat_par, 2));
+    }
+
+    // Each request on its own, for reference.
+    std::vector<std::vector<char>> expected(kRequests);
+    for (int i = 0; i < kRequests; ++i) {
+        const int err = abqnn::ipc::transact_blocking(endpoint, ABQNN_MSG_UMAT_REQ, requests[i],
+                                                      ABQNN_MSG_UMAT_RESP, expected[i]);
+        if (err != 0) {
+            std::cerr << "Error: request " << i << " on its own failed with " << err << std::endl;
+            return 1;
+        }
+        if ((response_status(expected[i]) != 0) != (i == kBadRequest)) {
+            std::cerr << "Error: request " << i << " on its own returned status "
+                      << response_status(expected[i]) << std::endl;
+            return 1;
+        }
+    }
+
+    for (int run = 0; run < 2; ++run) {
+        std::vector<std::vector<char>> responses;
+        const int err = abqnn::ipc::transact_pipelined(endpoint, ABQNN_MSG_UMAT_REQ, requests,
+                                                       ABQNN_MSG_UMAT_RESP, responses);
+        if (err != 0 || responses.size() != requests.size()) {
+            std::cerr << "Error: transact_pipelined returned " << err << std::endl;
+            return 1;
+        }
+        for (int i = 0; i < kRequests; ++i) {
+            if (responses[i] != expected[i]) {
+                std::cerr << "Error: run " << run << ", response " << i << " (status "
+                          << response_status(responses[i]) << ") does not answer request " << i << std::endl;
+                return 1;
+            }
+        }
+        std::cout << "  Run " << run << ": " << kRequests << " pipelined responses match." << std::endl;
+
+        // The next run starts on a new connection.
+        abqnn::ipc::close_thread_connection();
+    }
+
+    std::cout << "\nTest completed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file pt_caller_result_cache_test.cpp
+ * @brief UMAT result memoization, against a server with --umat-result-cache
+ *
+ * Sends the same F again and again, by name and through a handle. Every
+ * answer must be bit-identical to the first, and the server must report
+ * result cache hits.
+ */
+
+#include <iostream>
+
+#include "abqnn_test_util.h"
+#include "umat_auxlib.h"
+
+int main(int argc, char* argv[])
+{
+    std::cout << "ABQnn UMAT Result Cache Test" << std::endl;
+    std::cout << "============================" << std::endl;
+
+    const char* model_path = argc > 1 ? argv[1] : "NH_3D.pt";
+    const double F[9] = {1.1, 0.02, 0.0,
+                         0.01, 1.05, 0.0,
+                         0.0, -0.03, 0.9};
+    double mat_par[2] = {1.0, 10.0};
+
+    int handle = 0;
+    int err = invoke_pt_register(model_path, mat_par, 2, &handle);
+    if (err != 0) {
+        std::cerr << "Error: invoke_pt_register returned " << err << std::endl;
+        return 1;
+    }
+
+    constexpr int kRepeats = 8;
+    UmatOutput first;
+    for (int k = 0; k < kRepeats; ++k) {
+        UmatOutput out[2];
+        const int err_name = invoke_pt(model_path, F, mat_par, 2, &out[0].psi, out[0].Cauchy6, out[0].DDSDDE);
+        const int err_handle = invoke_pt_by_handle(handle, F, &out[1].psi, out[1].Cauchy6, out[1].DDSDDE);
+        if (err_name != 0 || err_handle != 0) {
+            std::cerr << "Error: repeat " << k << " returned " << err_name << " (by name), "
+                      << err_handle << " (handle)" << std::endl;
+            return 1;
+        }
+        if (k == 0) {
+            first = out[0];
+        }
+        if (!(out[0] == first) || !(out[1] == first)) {
+            std::cerr << "Error: repeat " << k << " is not bit-identical to the first result" << std::endl;
+            return 1;
+        }
+    }
+
+    unsigned long long count = 0;
+    err = read_server_stat("umat_result_cache_hits", count);
+    if (err != 0) {
+        std::cerr << "Error: no result cache in the server stats (error " << err << ")" << std::endl;
+        return 1;
+    }
+    std::cout << "  umat_result_cache_hits=" << count << std::endl;
+    if (count == 0) {
+        std::cerr << "Error: repeated inputs were not served from the result cache" << std::endl;
+        return 1;
+    }
+
+    std::cout << "\nTest completed successfully!" << std::endl;
+    return 0;
+}
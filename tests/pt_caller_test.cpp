@@ -6,9 +6,41 @@
 #include <iostream>
 #include <cstring>
 #include <cmath>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include "umat_auxlib.h"
 
+// One invoke_pt call's inputs, outputs and status.
+struct UmatPoint
+{
+    double F[9] = {0};
+    double psi = 0.0;
+    double Cauchy6[6] = {0};
+    double DDSDDE[36] = {0};
+    int err = -1;
+};
+
+// Largest |a - b| over psi, Cauchy and DDSDDE, relative to max(1, |b|).
+static double max_rel_diff(const UmatPoint& a, const UmatPoint& b)
+{
+    auto rel = [](double x, double y) { return std::abs(x - y) / std::max(1.0, std::abs(y)); };
+    double worst = rel(a.psi, b.psi);
+    for (int i = 0; i < 6; ++i) {
+        worst = std::max(worst, rel(a.Cauchy6[i], b.Cauchy6[i]));
+    }
+    for (int i = 0; i < 36; ++i) {
+        worst = std::max(worst, rel(a.DDSDDE[i], b.DDSDDE[i]));
+    }
+    return worst;
+}
+
+static void call_invoke_pt(const char* model, const double* mat_par, UmatPoint& p)
+{
+    p.err = invoke_pt(model, p.F, mat_par, 2, &p.psi, p.Cauchy6, p.DDSDDE);
+}
+
 int main(int argc, char* argv[])
 {
     std::cout << "ABQnn PT Caller Test" << std::endl;
@@ -67,6 +99,158 @@ int main(int argc, char* argv[])
         std::cout << "]" << std::endl;
     }
     
+    // The same point through the asynchronous API, two calls in flight at once
+    double psi_async[2] = {0.0, 0.0};
+    double Cauchy6_async[2][6] = {{0}};
+    double DDSDDE_async[2][36] = {{0}};
+    int tickets[2] = {0, 0};
+    for (int k = 0; k < 2; ++k) {
+        err = invoke_pt_submit(model_path, &F[0][0], mat_par, 2,
+                               &psi_async[k], Cauchy6_async[k], DDSDDE_async[k], &tickets[k]);
+        if (err != 0) {
+            std::cerr << "Error: invoke_pt_submit returned " << err << std::endl;
+            return err;
+        }
+    }
+
+    int done = 0;
+    while (!done) {
+        err = invoke_pt_poll(tickets[1], &done);
+        if (err != 0) {
+            std::cerr << "Error: invoke_pt_poll returned " << err << std::endl;
+            return err;
+        }
+    }
+
+    for (int k = 0; k < 2; ++k) {
+        err = invoke_pt_wait(tickets[k]);
+        if (err != 0) {
+            std::cerr << "Error: invoke_pt_wait returned " << err << std::endl;
+            return err;
+        }
+        bool same = psi_async[k] == psi;
+        for (int i = 0; i < 6; ++i) {
+            same = same && Cauchy6_async[k][i] == Cauchy6[i];
+        }
+        for (int i = 0; i < 36; ++i) {
+            same = same && DDSDDE_async[k][i] == (&DDSDDE[0][0])[i];
+        }
+        if (!same) {
+            std::cerr << "Error: asynchronous result " << k << " differs from invoke_pt" << std::endl;
+            return 1;
+        }
+    }
+    if (invoke_pt_wait(tickets[0]) != 110) {
+        std::cerr << "Error: a released ticket was accepted again" << std::endl;
+        return 1;
+    }
+    std::cout << "  Asynchronous calls match." << std::endl;
+
+    // The same point through a registered handle
+    int handle = 0;
+    int handle_again = 0;
+    err = invoke_pt_register(model_path, mat_par, 2, &handle);
+    if (err == 0) {
+        err = invoke_pt_register(model_path, mat_par, 2, &handle_again);
+    }
+    if (err != 0) {
+        std::cerr << "Error: invoke_pt_register returned " << err << std::endl;
+        return err;
+    }
+    if (handle <= 0 || handle_again != handle) {
+        std::cerr << "Error: registering the same model twice gave handles " << handle << " and " << handle_again << std::endl;
+        return 1;
+    }
+
+    double psi_handle = 0.0;
+    double Cauchy6_handle[6] = {0};
+    double DDSDDE_handle[36] = {0};
+    err = invoke_pt_by_handle(handle, &F[0][0], &psi_handle, Cauchy6_handle, DDSDDE_handle);
+    if (err != 0) {
+        std::cerr << "Error: invoke_pt_by_handle returned " << err << std::endl;
+        return err;
+    }
+    bool same = psi_handle == psi;
+    for (int i = 0; i < 6; ++i) {
+        same = same && Cauchy6_handle[i] == Cauchy6[i];
+    }
+    for (int i = 0; i < 36; ++i) {
+        same = same && DDSDDE_handle[i] == (&DDSDDE[0][0])[i];
+    }
+    if (!same) {
+        std::cerr << "Error: invoke_pt_by_handle result differs from invoke_pt" << std::endl;
+        return 1;
+    }
+    if (invoke_pt_by_handle(handle + 1000, &F[0][0], &psi_handle, Cauchy6_handle, DDSDDE_handle) != 110) {
+        std::cerr << "Error: an unknown handle was accepted" << std::endl;
+        return 1;
+    }
+    std::cout << "  Handle calls match." << std::endl;
+
+    // NH_3D_energy.pt returns psi only and the server derives Cauchy and
+    // DDSDDE from it; they must match NH_3D.pt, which computes them itself.
+    const char* full_model = "NH_3D.pt";
+    const char* energy_model = "NH_3D_energy.pt";
+    const double energy_tolerance = 1e-8;
+    constexpr int kPoints = 4;
+    UmatPoint reference[kPoints];
+    for (int p = 0; p < kPoints; ++p) {
+        const double F_p[9] = {1.1 - 0.05 * p, 0.02 * p, 0.0,
+                               0.01, 1.0 + 0.03 * p, -0.01 * p,
+                               0.0, 0.015, 0.95 + 0.02 * p};
+        std::memcpy(reference[p].F, F_p, sizeof(F_p));
+        UmatPoint energy = reference[p];
+        call_invoke_pt(full_model, mat_par, reference[p]);
+        call_invoke_pt(energy_model, mat_par, energy);
+        if (reference[p].err != 0 || energy.err != 0) {
+            std::cerr << "Error: invoke_pt returned " << reference[p].err << " (" << full_model << "), "
+                      << energy.err << " (" << energy_model << ")" << std::endl;
+            return 1;
+        }
+        const double diff = max_rel_diff(energy, reference[p]);
+        if (!(diff <= energy_tolerance)) {
+            std::cerr << "Error: " << energy_model << " differs from " << full_model
+                      << " at point " << p << " by " << diff << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "  Energy-only model matches the full model." << std::endl;
+
+    // The same points at once, with one det F <= 0 among them. With
+    // ABQNN_COALESCE_WINDOW_US set (ctest cpp_batch_test) they go to the
+    // server as one batch; only the bad point may fail, with 105.
+    UmatPoint batch[kPoints + 1];
+    for (int p = 0; p < kPoints; ++p) {
+        std::memcpy(batch[p].F, reference[p].F, sizeof(batch[p].F));
+    }
+    const double F_inverted[9] = {1.0, 0.0, 0.0,
+                                  0.0, 1.0, 0.0,
+                                  0.0, 0.0, -1.0};
+    std::memcpy(batch[kPoints].F, F_inverted, sizeof(F_inverted));
+    std::vector<std::thread> threads;
+    for (UmatPoint& p : batch) {
+        threads.emplace_back(call_invoke_pt, energy_model, mat_par, std::ref(p));
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    if (batch[kPoints].err != 105) {
+        std::cerr << "Error: det F <= 0 returned " << batch[kPoints].err << ", expected 105" << std::endl;
+        return 1;
+    }
+    for (int p = 0; p < kPoints; ++p) {
+        if (batch[p].err != 0) {
+            std::cerr << "Error: point " << p << " next to det F <= 0 returned " << batch[p].err << std::endl;
+            return 1;
+        }
+        const double diff = max_rel_diff(batch[p], reference[p]);
+        if (!(diff <= energy_tolerance)) {
+            std::cerr << "Error: batched point " << p << " differs from " << full_model << " by " << diff << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "  Only the det F <= 0 point failed." << std::endl;
+
     std::cout << "\nTest completed successfully!" << std::endl;
     
     return 0;
@@ -6,7 +6,12 @@ param(
     [string]$TorchLibDir,
 
     [Parameter(Mandatory = $true)]
-    [string]$PidFile
+    [string]$PidFile,
+
+    [string]$Endpoint = '',
+
+    # Server options as one string, e.g. "--model-cache-mb 0.001"
+    [string]$ServerArgs = ''
 )
 
 $ErrorActionPreference = 'Stop'
@@ -15,11 +20,25 @@ if (-not (Test-Path -Path $ServerExe)) {
     Write-Error "Server executable not found: $ServerExe"
 }
 
-Get-Process -Name "abqnn_inference_server" -ErrorAction SilentlyContinue | Stop-Process -Force
+# Only stop this fixture's server; other fixtures may have one running.
+if (Test-Path -Path $PidFile) {
+    $oldPid = Get-Content -Path $PidFile | Select-Object -First 1
+    if ($oldPid) {
+        Stop-Process -Id ([int]$oldPid) -Force -ErrorAction SilentlyContinue
+    }
+    Remove-Item -Path $PidFile -Force
+}
 
 $env:PATH = "$TorchLibDir;$env:PATH"
+if ($Endpoint) {
+    $env:ABQNN_IPC_ENDPOINT = $Endpoint
+}
 
-$proc = Start-Process -FilePath $ServerExe -PassThru -WindowStyle Hidden
+if ($ServerArgs) {
+    $proc = Start-Process -FilePath $ServerExe -ArgumentList $ServerArgs -PassThru -WindowStyle Hidden
+} else {
+    $proc = Start-Process -FilePath $ServerExe -PassThru -WindowStyle Hidden
+}
 Start-Sleep -Milliseconds 300
 
 if ($proc.HasExited) {
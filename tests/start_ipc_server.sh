@@ -0,0 +1,45 @@
+#!/bin/sh
+# Usage: start_ipc_server.sh <server-exe> <torch-lib-dir> <pid-file> <endpoint> [server-option...]
+set -e
+
+SERVER_EXE="$1"
+TORCH_LIB_DIR="$2"
+PID_FILE="$3"
+ENDPOINT="$4"
+shift 4
+
+if [ ! -x "$SERVER_EXE" ]; then
+    echo "Server executable not found: $SERVER_EXE" >&2
+    exit 1
+fi
+
+if [ -f "$PID_FILE" ]; then
+    kill "$(cat "$PID_FILE")" 2>/dev/null || true
+    rm -f "$PID_FILE"
+fi
+
+export LD_LIBRARY_PATH="$TORCH_LIB_DIR${LD_LIBRARY_PATH:+:$LD_LIBRARY_PATH}"
+export ABQNN_IPC_ENDPOINT="$ENDPOINT"
+
+rm -f "$ENDPOINT"
+nohup "$SERVER_EXE" "$@" >/dev/null 2>&1 &
+SERVER_PID=$!
+
+# Wait for the listening socket to appear
+i=0
+while [ ! -S "$ENDPOINT" ]; do
+    if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+        echo "Server exited immediately" >&2
+        exit 1
+    fi
+    i=$((i + 1))
+    if [ "$i" -gt 100 ]; then
+        echo "Server did not create $ENDPOINT in time" >&2
+        kill "$SERVER_PID" 2>/dev/null || true
+        exit 1
+    fi
+    sleep 0.1
+done
+
+echo "$SERVER_PID" > "$PID_FILE"
+echo "Started ABQnn IPC server pid=$SERVER_PID"
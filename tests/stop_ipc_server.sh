@@ -0,0 +1,14 @@
+#!/bin/sh
+# Usage: stop_ipc_server.sh <pid-file>
+
+PID_FILE="$1"
+
+if [ -f "$PID_FILE" ]; then
+    SERVER_PID=$(head -n 1 "$PID_FILE")
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null
+        echo "Stopped ABQnn IPC server pid=$SERVER_PID"
+    fi
+    rm -f "$PID_FILE"
+fi
+exit 0
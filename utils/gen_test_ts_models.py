@@ -1,4 +1,4 @@
-from typing import Tuple
+from typing import List, Tuple
 import torch
 from torch import nn
 
@@ -113,6 +113,8 @@ def psi_C_derivates_to_UMAT_3D(
 class NH3D(nn.Module):
     def __init__(self):
         super(NH3D, self).__init__()
+        # Lets the server send DDSDDE as its upper triangle
+        self.ddsdde_symmetric: bool = True
 
     # Pretend a neural network model predicts psi and P given F
     # the gradient of P w.r.t F should be preserved
@@ -157,6 +159,42 @@ class NH3D(nn.Module):
 
         return psi.detach(), Cauchy.detach(), DDSDDE.detach()
 
+    # Optional batched entry point, used by the server for coalesced invoke_pt
+    # calls: one TorchScript call for the whole batch instead of one per point.
+    @torch.jit.export
+    def forward_batch(
+        self, F_batch: torch.Tensor, mat_par: torch.Tensor
+    ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+        psi_list: List[torch.Tensor] = []
+        cauchy_list: List[torch.Tensor] = []
+        ddsdde_list: List[torch.Tensor] = []
+        for b in range(F_batch.size(0)):
+            psi, Cauchy, DDSDDE = self.forward(F_batch[b], mat_par)
+            psi_list.append(psi)
+            cauchy_list.append(Cauchy)
+            ddsdde_list.append(DDSDDE)
+        return torch.stack(psi_list), torch.stack(cauchy_list), torch.stack(ddsdde_list)
+
+
+# Neohookean 3D energy alone: the server derives Cauchy and DDSDDE from psi by
+# autograd and pushes them forward in C++, so no psi_F_derivates_to_UMAT_3D here
+class NH3DEnergy(nn.Module):
+    def __init__(self):
+        super(NH3DEnergy, self).__init__()
+        # forward returns psi only (see "Energy-Only Models" in the README)
+        self.energy_only: bool = True
+        self.ddsdde_symmetric: bool = True
+
+    # F_batch: [B, 3, 3]; one psi per point, each from its own F only
+    def forward(self, F_batch: torch.Tensor, mat_par: torch.Tensor) -> torch.Tensor:
+        c1 = mat_par[0]
+        c2 = mat_par[1]
+
+        I1 = (F_batch * F_batch).sum(dim=(1, 2))
+        J = torch.linalg.det(F_batch)
+
+        return c1 * (J ** (-2 / 3) * I1 - 3) + c2 * (J - 1) ** 2
+
 
 class NH_PE(nn.Module):
     def __init__(self):
@@ -303,13 +341,146 @@ class VUMATBatchNHPE(nn.Module):
 
         return energy, stress_vumat
 
+# Small MLP energy model for testing the server's native backend. psi is an
+# MLP of the isochoric invariants, J and mat_par; the server evaluates the
+# same network natively from the weight file written by export_mlp_energy.
+class MLPEnergy3D(nn.Module):
+    def __init__(self, n_mat_par: int = 2, hidden: List[int] = [16, 16]):
+        super(MLPEnergy3D, self).__init__()
+        self.ddsdde_symmetric: bool = True
+        self.n_mat_par = n_mat_par
+
+        layers: List[nn.Module] = []
+        width = 3 + n_mat_par
+        for h in hidden:
+            layers.append(nn.Linear(width, h))
+            layers.append(nn.Softplus())
+            width = h
+        layers.append(nn.Linear(width, 1))
+        self.net = nn.Sequential(*layers).double()
+
+    # psi over any leading batch dimensions of C = F^T F and J = det F
+    def energy(
+        self, C: torch.Tensor, J: torch.Tensor, mat_par: torch.Tensor
+    ) -> torch.Tensor:
+        I1 = torch.diagonal(C, dim1=-2, dim2=-1).sum(-1)
+        I2 = 0.5 * (I1**2 - torch.einsum("...ij,...ji->...", C, C))
+        Jm = J ** (-2 / 3)
+        invariants = torch.stack([Jm * I1 - 3, Jm * Jm * I2 - 3, J - 1], dim=-1)
+        batch_shape = list(invariants.shape[:-1])
+        params = mat_par[: self.n_mat_par].expand(batch_shape + [self.n_mat_par])
+        return self.net(torch.cat([invariants, params], dim=-1)).squeeze(-1)
+
+    def forward(
+        self, F_in: torch.Tensor, mat_par: torch.Tensor
+    ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+        F = F_in.clone().requires_grad_(True)
+        psi = self.energy(F.T @ F, torch.det(F), mat_par)
+
+        P = torch.autograd.grad([psi], [F], create_graph=True)[0]
+        assert P is not None
+        P_F = torch.zeros(3, 3, 3, 3, dtype=F_in.dtype, device=F_in.device)
+        for i in range(3):
+            for j in range(3):
+                grad_P_F_ij = torch.autograd.grad([P[i, j]], [F], retain_graph=True)[0]
+                assert grad_P_F_ij is not None
+                P_F[i, j, :, :] = grad_P_F_ij
+
+        Cauchy, DDSDDE = psi_F_derivates_to_UMAT_3D(F_in, torch.det(F_in), P, P_F)
+
+        return psi.detach(), Cauchy.detach(), DDSDDE.detach()
+
+    @torch.jit.export
+    def forward_batch(
+        self, F_batch: torch.Tensor, mat_par: torch.Tensor
+    ) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor]:
+        psi_list: List[torch.Tensor] = []
+        cauchy_list: List[torch.Tensor] = []
+        ddsdde_list: List[torch.Tensor] = []
+        for b in range(F_batch.size(0)):
+            psi, Cauchy, DDSDDE = self.forward(F_batch[b], mat_par)
+            psi_list.append(psi)
+            cauchy_list.append(Cauchy)
+            ddsdde_list.append(DDSDDE)
+        return torch.stack(psi_list), torch.stack(cauchy_list), torch.stack(ddsdde_list)
+
+
+# VUMAT counterpart of an MLPEnergy3D: energy and the co-rotational Cauchy
+# stress 2 C psi_C / J of the same network.
+class VUMATBatchMLP3D(nn.Module):
+    def __init__(self, energy_model: MLPEnergy3D):
+        super().__init__()
+        self.energy_model = energy_model
+
+    def forward(
+        self, F_batch: torch.Tensor, mat_par: torch.Tensor
+    ) -> Tuple[torch.Tensor, torch.Tensor]:
+        if F_batch.dim() != 3 or F_batch.size(-1) != 3 or F_batch.size(-2) != 3:
+            raise RuntimeError("Expected F_batch shape [nblock, 3, 3]")
+
+        C = (F_batch.swapaxes(-1, -2) @ F_batch).detach().requires_grad_(True)
+        J = torch.sqrt(torch.det(C))
+        energy = self.energy_model.energy(C, J, mat_par)
+        psi_C = torch.autograd.grad([energy.sum()], [C])[0]
+        assert psi_C is not None
+
+        co_rot_Cauchy = 2 * C.detach() @ psi_C / J.detach()[:, None, None]
+        stress_vumat = torch.stack(
+            [
+                co_rot_Cauchy[:, 0, 0],
+                co_rot_Cauchy[:, 1, 1],
+                co_rot_Cauchy[:, 2, 2],
+                co_rot_Cauchy[:, 0, 1],
+                co_rot_Cauchy[:, 1, 2],
+                co_rot_Cauchy[:, 2, 0],
+            ],
+            dim=1,
+        )
+
+        return energy.detach(), stress_vumat
+
+
+# Writes the weights of an MLPEnergy3D in the text format the server loads
+# natively from a .mlp file (see include/abqnn_mlp_energy.h).
+def export_mlp_energy(model: MLPEnergy3D, path: str):
+    modules = list(model.net)
+    lines = [
+        "# exported by gen_test_ts_models.py",
+        "abqnn-mlp-energy 1",
+        f"mat_par_inputs {model.n_mat_par}",
+        f"layers {sum(isinstance(m, nn.Linear) for m in modules)}",
+    ]
+    for k, m in enumerate(modules):
+        if not isinstance(m, nn.Linear):
+            continue
+        following = modules[k + 1] if k + 1 < len(modules) else None
+        if isinstance(following, nn.Softplus):
+            activation = "softplus"
+        elif isinstance(following, nn.Tanh):
+            activation = "tanh"
+        else:
+            activation = "identity"
+        lines.append(f"layer {m.in_features} {m.out_features} {activation}")
+        for row in m.weight.detach().double().tolist():
+            lines.append(" ".join(repr(v) for v in row))
+        lines.append(" ".join(repr(v) for v in m.bias.detach().double().tolist()))
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
 if __name__ == "__main__":
     model = NH3D()
     scripted_model = torch.jit.script(model)
-    scripted_model = torch.jit.optimize_for_inference(scripted_model)
+    # freeze here so the ddsdde_symmetric attribute survives
+    scripted_model = torch.jit.freeze(scripted_model.eval(), preserved_attrs=["forward_batch", "ddsdde_symmetric"])
+    scripted_model = torch.jit.optimize_for_inference(scripted_model, other_methods=["forward_batch"])
     # should be executed in the root directory
     scripted_model.save("models/NH_3D.pt")
 
+    model = NH3DEnergy()
+    scripted_model = torch.jit.script(model)
+    scripted_model.save("models/NH_3D_energy.pt")
+
     model = NH_PE()
     scripted_model = torch.jit.script(model)
     scripted_model = torch.jit.optimize_for_inference(scripted_model)
@@ -326,6 +497,17 @@ if __name__ == "__main__":
     scripted_model = torch.jit.optimize_for_inference(scripted_model)
     scripted_model.save("models/VUMAT_NH_PE.pt")
 
+    # One set of weights for TorchScript and the native backend
+    torch.manual_seed(0)
+    model = MLPEnergy3D().eval()
+    export_mlp_energy(model, "models/MLP_3D.mlp")
+
+    scripted_model = torch.jit.script(model)
+    scripted_model.save("models/MLP_3D.pt")
+
+    scripted_model = torch.jit.script(VUMATBatchMLP3D(model).eval())
+    scripted_model.save("models/VUMAT_MLP_3D.pt")
+
     # --- test run ---
     """ F_test = torch.eye(3)[None, :, :] + torch.randn(100, 3, 3) * 0.2
     F = F_test[0, :, :]